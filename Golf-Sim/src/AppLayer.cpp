@@ -1,8 +1,8 @@
 #include "AppLayer.h"
 
+#include <chrono>
 #include <filesystem>
 #include <fstream>
-#include <glm/gtx/rotate_vector.hpp>
 #include <vector>
 
 #include "GLCore/Core/KeyCodes.h"
@@ -10,6 +10,7 @@
 #include "ImGuiConstants.h"
 #include "ImGuiFileDialog.h"
 #include "backends/imgui_impl_opengl3.h"
+#include "solver/ResultFile.h"
 #include "util/DebugColors.h"
 #include "util/opengl/VertexArray.h"
 #include "util/opengl/VertexBuffer.h"
@@ -87,6 +88,10 @@ void AppLayer::OnAttach() {
 }
 
 void AppLayer::OnDetach() {
+  finishInverseSearch(false);
+  shardedSolver.reset();
+  closeResultStream();
+
   ballModel.freeModel();
   terrain.freeModel();
   goal.freeModel();
@@ -98,9 +103,8 @@ void AppLayer::OnDetach() {
   lightDepthFrameBuffer0.free();
   lightDepthShader.free();
 
-  for (Ball& ball : balls) {
-    ball.removePhysics(physicsWorld, physicsCommon, ballShapeRegistry);
-  }
+  clearBalls();
+  ballBodyPool.reset();
   terrain.removePhysics(physicsWorld, physicsCommon);
   goal.removePhysics(physicsWorld, physicsCommon);
 
@@ -132,27 +136,8 @@ void AppLayer::OnEvent(Event& event) {
 }
 
 void AppLayer::update(Timestep ts) {
-  // check if the staggered initialization is ready for next batch
-  if (staggeredBalls.size() > 0) {
-    bool anyActive = false;
-    for (Ball& ball : balls) {
-      if (ball.getState() == BallState::ACTIVE) {
-        anyActive = true;
-      }
-    }
-
-    if (!anyActive) {
-      for (Ball& ball : balls) {
-        ball.removePhysics(physicsWorld, physicsCommon, ballShapeRegistry);
-      }
-
-      int initSize = staggeredBalls.size();
-      for (int i = initSize - 1;
-           i >= std::max(0, initSize - staggeredBatchSize); i--) {
-        addBall(staggeredBalls[i]);
-        staggeredBalls.pop_back();
-      }
-    }
+  if (inverseSolver != nullptr && inverseDone) {
+    finishInverseSearch(true);
   }
 
   if (!justStartedPhysics && physicsRunning) {
@@ -162,9 +147,63 @@ void AppLayer::update(Timestep ts) {
     justStartedPhysics = false;
   }
   float desiredPhysicsTimeStep = 1.0 / 60.0f;
+  int numPhysicsSteps = 0;
+  long long liveBallSteps = 0;
+  auto physicsStart = std::chrono::steady_clock::now();
+  if (maxThroughput && physicsRunning) {
+    // step as many times as fit in the frame budget instead of keeping pace
+    // with real time, updating the balls after every step so that no state
+    // changes (goal proximity, out of bounds) are skipped
+    auto budgetStart = std::chrono::steady_clock::now();
+    bool anyActive = true;
+    bool staggeredRunning = true;
+    while (anyActive || staggeredRunning) {
+      stepPhysics(desiredPhysicsTimeStep);
+      numPhysicsSteps++;
+      liveBallSteps += liveShots.size();
+
+      if (ballBodyPool != nullptr) {
+        shots.update(terrain, goal, *ballBodyPool, 1.0f);
+      }
+      anyActive = shots.getNumActive() > 0;
+      for (Ball& ball : balls) {
+        ball.update(desiredPhysicsTimeStep, terrain, goal, physicsWorld,
+                    physicsCommon, ballShapeRegistry, 1.0f);
+        if (ball.getState() == BallState::ACTIVE) {
+          anyActive = true;
+        }
+      }
+      staggeredRunning = updateStaggered(desiredPhysicsTimeStep);
+
+      std::chrono::duration<float, std::milli> elapsed =
+          std::chrono::steady_clock::now() - budgetStart;
+      if (elapsed.count() >= physicsBudgetMs) {
+        break;
+      }
+    }
+    physicsAccumulatedTime = 0;
+  }
   while (physicsAccumulatedTime >= desiredPhysicsTimeStep && physicsRunning) {
     physicsAccumulatedTime -= desiredPhysicsTimeStep;
-    physicsWorld->update(desiredPhysicsTimeStep);
+    stepPhysics(desiredPhysicsTimeStep);
+    numPhysicsSteps++;
+    liveBallSteps += liveShots.size();
+  }
+
+  std::chrono::duration<double> physicsTime =
+      std::chrono::steady_clock::now() - physicsStart;
+  if (liveBallSteps > 0) {
+    liveCountController.record(liveBallSteps, numPhysicsSteps,
+                               physicsTime.count());
+  }
+
+  // measure how fast simulated time passes compared to real time
+  simSpeedSimulatedTime += numPhysicsSteps * desiredPhysicsTimeStep;
+  simSpeedRealTime += ts;
+  if (simSpeedRealTime >= 0.5f) {
+    simSpeed = simSpeedSimulatedTime / simSpeedRealTime;
+    simSpeedSimulatedTime = 0;
+    simSpeedRealTime = 0;
   }
 
   cameraController.update(ts);
@@ -175,30 +214,37 @@ void AppLayer::update(Timestep ts) {
     balls.push_back(ballsAdd.front());
     ballsAdd.pop();
   }
-  for (Ball& ball : balls) {
-    ball.update(ts, terrain, goal, physicsWorld, physicsCommon,
-                ballShapeRegistry, interpolationFactor);
+  if (!maxThroughput || !physicsRunning) {
+    if (ballBodyPool != nullptr) {
+      shots.update(terrain, goal, *ballBodyPool, interpolationFactor);
+    }
+    for (Ball& ball : balls) {
+      ball.update(ts, terrain, goal, physicsWorld, physicsCommon,
+                  ballShapeRegistry, interpolationFactor);
+    }
+    updateStaggered(numPhysicsSteps * desiredPhysicsTimeStep);
   }
   terrain.update(ts, interpolationFactor);
 
-  render();
+  // rendering can be skipped on most frames while running at max throughput
+  frameCount++;
+  if (!maxThroughput ||
+      (renderInterval > 0 && frameCount % renderInterval == 0)) {
+    render();
+  }
 
   timeMetrics.update(ts);
 
-  exportReady = false;
-  if (paramsNumDivisions * paramsNumDivisions * paramsNumDivisions ==
-      balls.size()) {
-    bool ready = true;
-    for (Ball& ball : balls) {
-      if (ball.getState() == BallState::ACTIVE) {
-        ready = false;
-        break;
-      }
-    }
+  // every shot of the streamed sweep has been written (or it was cleared)
+  if (resultStream != nullptr && !isSolvingInParallel() && liveShots.empty() &&
+      staggeredBalls.empty()) {
+    closeResultStream();
+  }
 
-    if (ready) {
-      exportReady = true;
-    }
+  exportReady = false;
+  if (sweepConfig.getNumShots() == shots.size() &&
+      shots.getNumActive() == 0) {
+    exportReady = true;
   }
   exportReady = true;
 
@@ -221,6 +267,42 @@ void AppLayer::update(Timestep ts) {
   }
 }
 
+void AppLayer::stepPhysics(float dt) {
+  // shots about to land get their rigid body before the world is stepped
+  if (flightStage != nullptr) {
+    shots.stepFlights(*flightStage, *ballBodyPool);
+  }
+  physicsWorld->update(dt);
+}
+
+bool AppLayer::updateStaggered(float dt) {
+  // retire finished balls, handing their rigid bodies back to the pool
+  for (int i = liveShots.size() - 1; i >= 0; i--) {
+    int row = liveShots[i].row;
+    if (updateLiveShot(liveShots[i], shots.getState(row), dt, maxShotTime)) {
+      if (resultStream != nullptr) {
+        shots.recordDistance(row, goal, terrain);
+        resultStream->push(shots.getParamIndex(row), shots.getDistance(row),
+                           shots.getState(row), shots.getPosition(row));
+      }
+      shots.removePhysics(row, *ballBodyPool);
+      liveShots[i] = liveShots.back();
+      liveShots.pop_back();
+    }
+  }
+
+  // launch pending shots until the world holds the target number of balls
+  int target =
+      autoTuneLiveBalls ? liveCountController.getTarget() : liveBallCount;
+  while (liveShots.size() < target && !staggeredBalls.empty()) {
+    liveShots.push_back(LiveShot{shots.size()});
+    addBall(staggeredBalls.back());
+    staggeredBalls.pop_back();
+  }
+
+  return !liveShots.empty() || !staggeredBalls.empty();
+}
+
 void AppLayer::render() {
   if (renderPhysicsDebugging) {
     renderFrameBuffer.prepareForRender();
@@ -341,6 +423,7 @@ void AppLayer::render() {
 
     lightDepthFrameBuffer0.prepareForCalculate();
     if (renderShadows) {
+      shots.render(ballRenderer);
       for (Ball& ball : balls) {
         ball.render(ballRenderer);
       }
@@ -362,6 +445,7 @@ void AppLayer::render() {
       //                        &visualizeNormalsShader);
     }
 
+    shots.render(ballRenderer);
     for (Ball& ball : balls) {
       ball.render(ballRenderer);
     }
@@ -552,11 +636,59 @@ void renderHelpMenu() {
 
       ImGui::Spacing();
 
+      ImGui::TextWrapped("Instead of a grid, the 'Sampling' option can spread any number of shots over the ranges "
+        "with a Sobol or Halton sequence or with Latin hypercube sampling. These cover wide ranges much more evenly "
+        "than a grid with the same number of shots, and the shots are launched in an order where any prefix is "
+        "already spread evenly, so a sweep cut short still covers the whole space. A non-zero 'Sample Seed' "
+        "randomizes the samples. Such sweeps can only be exported in the binary format.");
+
+      ImGui::Spacing();
+
       ImGui::TextWrapped("After specifying these parameters, there are two options for starting the simulation: "
         "staggered and simultaneous. For simultaneous starts, all balls are launched at the same time, which is highly "
-        "unrecommended for more than ~500 balls due to performance reasons. For staggered starts, the balls are launched in "
-        "batches, and this batch size can be configured while the staggered option is selected. By default, the staggered "
-        "option is selected. Trial and error can be used to determine which batch size is the best.");
+        "unrecommended for more than ~500 balls due to performance reasons. For staggered starts, only a limited number "
+        "of live balls are in flight at once: as soon as a ball comes to rest, lands in the goal or leaves the map, its "
+        "result is kept and the next shot is launched in its place. By default, the staggered option is selected and the "
+        "number of live balls is tuned automatically for the most physics steps per second. Unchecking 'Auto Tune' lets "
+        "you set it by hand, and shots still in flight after 'Max Shot Time' seconds are cut off.");
+
+      ImGui::Spacing();
+
+      ImGui::TextWrapped("With 'Closed-Form Flight' checked, balls are moved along their flight path without the "
+        "physics engine and only get a rigid body once they are about to touch the terrain, which makes high shots "
+        "much cheaper to simulate. The results are the same up to floating point rounding.");
+
+      ImGui::Spacing();
+
+      ImGui::TextWrapped("By default the physics keeps pace with real time. Checking 'Max Throughput' instead runs "
+        "as many physics steps as fit in the 'Physics Budget' every frame, and only renders the scene every "
+        "'Render Every N Frames' frames (0 never renders). The 'Sim Speed' readout shows how many times faster "
+        "than real time the simulation is running.");
+
+      ImGui::Spacing();
+
+      ImGui::TextWrapped("The 'Parallel' option doesn't show the balls at all. Instead, the shots are split into "
+        "chunks of the batch size and handed out to 'Solver Threads' worker threads, each of which simulates them in its "
+        "own physics world. This scales with the number of cores, and the results can be exported once every shot has "
+        "been solved. The terrain and goal can't be regenerated while the solve is running. The 'heightfield' "
+        "backend replaces the physics engine with a much faster integrator that only handles balls on the terrain "
+        "and in the goal; 'golf-solve --backend validate' reports how far its results are from the 'rp3d' ones.");
+
+      ImGui::Spacing();
+
+      ImGui::TextWrapped("With 'Prune Misses' checked, a parallel solve stops a shot as soon as it can no longer "
+        "end in the goal: a ball can never climb higher than its speed would carry it, so once every way to the goal "
+        "leads over terrain higher than that, the shot is a miss. Its distance is then only a lower bound, and it is "
+        "stored with the 'Pruned' state in binary results files. This speeds up sweeps where many shots end up "
+        "rolling around far from the goal.");
+
+      ImGui::Spacing();
+
+      ImGui::TextWrapped("When only a few shots that go in are needed, 'Find Shots' searches the power, yaw and "
+        "pitch ranges instead of sweeping them. Several CMA-ES or Nelder-Mead searches minimize the distance from "
+        "the goal side by side, with every batch of shots solved in parallel, until 'Shots to Find' different shots "
+        "have gone in or 'Search Budget' shots have been simulated. The shots it finds are then launched so you can "
+        "watch them go in. This usually takes hundreds of shots rather than a full sweep.");
 
       break;
     case 3:
@@ -568,12 +700,20 @@ void renderHelpMenu() {
       ImGui::Spacing();
 
       ImGui::TextWrapped("Upon pressing the export button, a file dialog appears where you can select the folder "
-        "the results file will be saved to, as well as the name of the file.");
+        "the results file will be saved to, as well as the name of the file. With 'Binary' checked (the default) "
+        "the file is written in the compact binary format, which also records the state each ball ended in and "
+        "loads much faster in the visualizer; unchecking it writes the older text format.");
 
       ImGui::Spacing();
 
       ImGui::TextWrapped("By default, the file will be saved with the .golf extension, indicating that it is an "
         "output of Golf Simulator.");
+
+      ImGui::Spacing();
+
+      ImGui::TextWrapped("Staggered and parallel runs can also stream their results: with 'Stream Results' "
+        "checked, each ball is written to the selected .golfs file as soon as it finishes, so the visualizer "
+        "can load the results while the sweep is still running.");
       break;
   }
 }
@@ -654,20 +794,70 @@ void AppLayer::imGuiRender() {
         justStartedPhysics = true;
       }
     }
+    ImGui::SameLine();
+    ImGui::Checkbox("Max Throughput", &maxThroughput);
+    if (maxThroughput) {
+      ImGui::DragFloat("Physics Budget (ms)", &physicsBudgetMs, 0.5f, 1.0f,
+                       100.0f);
+      ImGui::DragInt("Render Every N Frames", &renderInterval, 0.25f, 0, 120);
+    }
+    ImGui::Text("Sim Speed: %.1fx real time", simSpeed);
 
-    setupGreenButton();
-    if (ImGui::Button("Init Balls")) {
-      initializeBalls(!initSimultaneous);
+    if (inverseSolver != nullptr) {
+      ImGui::Text("Searching: %d Shots Simulated on %d Threads",
+                  inverseSolver->getNumSimulations(), solverThreads);
+      setupRedButton();
+      if (ImGui::Button("Cancel Search")) {
+        inverseSolver->cancel();
+      }
+      clearButtonStyle();
+    } else if (isSolvingInParallel()) {
+      ImGui::Text("%d / %d Shots Solved on %d Threads",
+                  shardedSolver->getNumCompleted(),
+                  shardedSolver->getNumShots(),
+                  shardedSolver->getNumThreads());
+      setupRedButton();
+      if (ImGui::Button("Cancel Parallel")) {
+        shardedSolver->cancel();
+      }
+      clearButtonStyle();
+    } else {
+      setupGreenButton();
+      if (ImGui::Button("Init Balls")) {
+        if (initParallel) {
+          startParallelSolve();
+        } else {
+          initializeBalls(!initSimultaneous, sweepConfig.getShots());
+        }
+      }
+      if (initParallel) {
+        ImGui::SameLine();
+        if (ImGui::Button("Find Shots")) {
+          startInverseSearch();
+        }
+      }
+      clearButtonStyle();
+      if (inverseResult.numBatches > 0) {
+        ImGui::Text("Last Search: %d Shots Found in %d Simulations",
+                    static_cast<int>(inverseResult.holedShots.size()),
+                    inverseResult.numSimulations);
+      }
     }
-    clearButtonStyle();
 
     ImGui::SameLine();
-    if (ImGui::RadioButton("Staggered", !initSimultaneous)) {
+    if (ImGui::RadioButton("Staggered", !initSimultaneous && !initParallel)) {
       initSimultaneous = false;
+      initParallel = false;
     }
     ImGui::SameLine();
     if (ImGui::RadioButton("Simultaneous", initSimultaneous)) {
       initSimultaneous = true;
+      initParallel = false;
+    }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Parallel", initParallel)) {
+      initSimultaneous = false;
+      initParallel = true;
     }
     setupGreenButton();
     if (exportReady) {
@@ -678,6 +868,11 @@ void AppLayer::imGuiRender() {
             "result", 1, IGFDUserDatas("SaveFile"),
             ImGuiFileDialogFlags_ConfirmOverwrite);
       }
+      // only grids can be written as text
+      if (sweepConfig.sampling == SamplingMode::GRID) {
+        ImGui::SameLine();
+        ImGui::Checkbox("Binary", &binaryExport);
+      }
     }
     clearButtonStyle();
 
@@ -689,9 +884,31 @@ void AppLayer::imGuiRender() {
         outputFilePath =
             ImGuiFileDialog::Instance()->GetFilePathName() + ".golf";
         std::cout << outputFilePath << std::endl;
-        std::ofstream fout(outputFilePath);
-        writeOutputFile(fout);
-        fout.close();
+        writeOutputFile(outputFilePath);
+      }
+
+      ImGuiFileDialog::Instance()->Close();
+    }
+
+    if (!initSimultaneous && !isSolvingInParallel() && staggeredBalls.empty()) {
+      ImGui::Checkbox("Stream Results", &streamResults);
+      if (streamResults) {
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_FLOPPY_DISK " Stream To")) {
+          const char* filters = "Streamed Results File (*.golfs){.golfs}";
+          ImGuiFileDialog::Instance()->OpenDialog(
+              "Stream", ICON_FA_FLOPPY_DISK " Select Stream File", filters, ".",
+              "result", 1, IGFDUserDatas("SaveFile"),
+              ImGuiFileDialogFlags_ConfirmOverwrite);
+        }
+        ImGui::Text("%s", streamFilePath.c_str());
+      }
+    }
+    if (ImGuiFileDialog::Instance()->Display(
+            "Stream", ImGuiWindowFlags_NoDocking, minSize, maxSize)) {
+      if (ImGuiFileDialog::Instance()->IsOk()) {
+        streamFilePath =
+            ImGuiFileDialog::Instance()->GetFilePathName() + ".golfs";
       }
 
       ImGuiFileDialog::Instance()->Close();
@@ -700,10 +917,43 @@ void AppLayer::imGuiRender() {
     if (!initSimultaneous) {
       ImGui::NewLine();
 
-      ImGui::DragInt("Staggered Batch Size", &staggeredBatchSize, 5.0f, 1, 10000);
+      ImGui::Checkbox("Auto Tune", &autoTuneLiveBalls);
+      ImGui::SameLine();
+      if (autoTuneLiveBalls && !initParallel) {
+        ImGui::Text("%d Live Balls", liveCountController.getTarget());
+      } else {
+        ImGui::DragInt("Live Balls", &liveBallCount, 5.0f, 1, 10000);
+      }
+      ImGui::DragFloat("Max Shot Time (s)", &maxShotTime, 1.0f, 1.0f, 1000.0f);
+    }
+    ImGui::Checkbox("Closed-Form Flight", &useFlightStage);
+    if (initParallel) {
+      ImGui::DragInt("Solver Threads", &solverThreads, 0.25f, 1, 256);
+      ImGui::DragInt("Chunk Size", &solverChunkSize, 10.0f, 1, 100000);
+      const char* backendNames[] = {getBackendName(SolverBackend::RP3D),
+                                    getBackendName(SolverBackend::HEIGHT_FIELD)};
+      int backend = static_cast<int>(solverBackend);
+      if (ImGui::Combo("Backend", &backend, backendNames,
+                       IM_ARRAYSIZE(backendNames))) {
+        solverBackend = static_cast<SolverBackend>(backend);
+      }
+      ImGui::Checkbox("Prune Misses", &pruneShots);
+
+      const char* methodNames[] = {
+          getInverseMethodName(InverseMethod::CMA_ES),
+          getInverseMethodName(InverseMethod::NELDER_MEAD)};
+      int method = static_cast<int>(inverseConfig.method);
+      if (ImGui::Combo("Search Method", &method, methodNames,
+                       IM_ARRAYSIZE(methodNames))) {
+        inverseConfig.method = static_cast<InverseMethod>(method);
+      }
+      ImGui::DragInt("Shots to Find", &inverseConfig.targetShots, 0.1f, 1,
+                     100);
+      ImGui::DragInt("Search Budget", &inverseConfig.maxSimulations, 10.0f, 1,
+                     1000000);
     }
 
-    if (staggeredBalls.empty()) {
+    if (staggeredBalls.empty() && !isSolvingInParallel()) {
       ImGui::NewLine();
 
       ImGui::DragFloat2("Start Position", glm::value_ptr(startPosition), 0.05f,
@@ -714,21 +964,38 @@ void AppLayer::imGuiRender() {
                         glm::value_ptr(startPositionHighlightColor));
       ImGui::NewLine();
 
-      ImGui::DragInt("# Balls per Dim", &paramsNumDivisions, 0.25, 1, 250);
-      ImGui::DragFloatRange2("Power", &minPower, &maxPower, 0.25f, 0.0f, 30.0);
-      ImGui::DragFloatRange2("Yaw Offset (deg)", &minYaw, &maxYaw, 1.5f, -90.0f,
-                             90.0f);
-      ImGui::DragFloatRange2("Pitch (deg)", &minPitch, &maxPitch, 1.0f, 0.0f,
-                             90.0f);
+      const char* samplingNames[] = {
+          getSamplingModeName(SamplingMode::GRID),
+          getSamplingModeName(SamplingMode::SOBOL),
+          getSamplingModeName(SamplingMode::HALTON),
+          getSamplingModeName(SamplingMode::LATIN_HYPERCUBE)};
+      int sampling = static_cast<int>(sweepConfig.sampling);
+      if (ImGui::Combo("Sampling", &sampling, samplingNames,
+                       IM_ARRAYSIZE(samplingNames))) {
+        sweepConfig.sampling = static_cast<SamplingMode>(sampling);
+      }
+      if (sweepConfig.sampling == SamplingMode::GRID) {
+        ImGui::DragInt("# Balls per Dim", &sweepConfig.numDivisions, 0.25, 1,
+                       250);
+      } else {
+        ImGui::DragInt("# Samples", &sweepConfig.numSamples, 10.0f, 1,
+                       20000000);
+        int seed = static_cast<int>(sweepConfig.samplingSeed);
+        if (ImGui::DragInt("Sample Seed", &seed, 0.25f, 0, 1000000)) {
+          sweepConfig.samplingSeed = static_cast<uint32_t>(seed);
+        }
+      }
+      ImGui::DragFloatRange2("Power", &sweepConfig.minPower,
+                             &sweepConfig.maxPower, 0.25f, 0.0f, 30.0);
+      ImGui::DragFloatRange2("Yaw Offset (deg)", &sweepConfig.minYaw,
+                             &sweepConfig.maxYaw, 1.5f, -90.0f, 90.0f);
+      ImGui::DragFloatRange2("Pitch (deg)", &sweepConfig.minPitch,
+                             &sweepConfig.maxPitch, 1.0f, 0.0f, 90.0f);
     } else {
       ImGui::Text("%d Balls Left", staggeredBalls.size());
       setupRedButton();
       if (ImGui::Button("Cancel Staggered")) {
-        staggeredBalls.clear();
-        for (Ball& ball : balls) {
-          ball.removePhysics(physicsWorld, physicsCommon, ballShapeRegistry);
-        } 
-        balls.clear();
+        clearBalls();
       }
       clearButtonStyle();
     }
@@ -766,15 +1033,25 @@ void AppLayer::imGuiRender() {
       ImGui::End();
     }
 
+    // the parallel solver reads the terrain and goal, so they can't be
+    // regenerated until it finishes
     if (showTerrainSettings) {
       ImGui::Begin("Terrain Controls", NULL, ImGuiWindowFlags_NoMove);
-      terrain.imGuiRender(goal, physicsWorld, physicsCommon);
+      if (isSolvingInParallel()) {
+        ImGui::Text("Unavailable while solving in parallel");
+      } else {
+        terrain.imGuiRender(goal, physicsWorld, physicsCommon);
+      }
       ImGui::End();
     }
 
     if (showGoalSettings) {
       ImGui::Begin("Goal Controls", NULL, ImGuiWindowFlags_NoMove);
-      goal.imGuiRender(physicsWorld, physicsCommon, terrain);
+      if (isSolvingInParallel()) {
+        ImGui::Text("Unavailable while solving in parallel");
+      } else {
+        goal.imGuiRender(physicsWorld, physicsCommon, terrain);
+      }
       ImGui::End();
     }
   }
@@ -786,25 +1063,38 @@ void AppLayer::imGuiRender() {
   }
 }
 
-void AppLayer::initializeBalls(bool staggered) {
-  for (Ball& ball : balls) {
-    ball.removePhysics(physicsWorld, physicsCommon, ballShapeRegistry);
+void AppLayer::initializeBalls(bool staggered,
+                               const std::vector<ShotParams>& sweepShots) {
+  shardedSolver.reset();
+
+  clearBalls();
+  // simultaneous shots are never retired one by one, so only staggered ones
+  // are streamed
+  if (staggered) {
+    openResultStream();
+  } else {
+    closeResultStream();
   }
-  balls.clear();
+  liveCountController.reset(liveBallCount);
 
-  const float POWER_DIV = (maxPower - minPower) / (paramsNumDivisions - 1);
-  const float YAW_OFFSET_DIV = (maxYaw - minYaw) / (paramsNumDivisions - 1);
-  const float PITCH_DIV = (maxPitch - minPitch) / (paramsNumDivisions - 1);
-
-  for (int i = 0; i < paramsNumDivisions; i++) {
-    float power = minPower + POWER_DIV * i;
-    for (int j = 0; j < paramsNumDivisions; j++) {
-      float yawOffset = minYaw + YAW_OFFSET_DIV * j;
-      for (int k = 0; k < paramsNumDivisions; k++) {
-        float pitch = minPitch + PITCH_DIV * k;
-        addBall(power, yawOffset * PI / 180, pitch * PI / 180, staggered);
-      }
-    }
+  if (ballBodyPool == nullptr || ballBodyPool->getRadius() != addBallRadius) {
+    ballBodyPool = std::make_unique<BallBodyPool>(
+        physicsWorld, physicsCommon, ballShapeRegistry, addBallRadius);
+  }
+  ballBodyPool->reserve(staggered ? liveBallCount : sweepShots.size());
+  shots.reset(addBallRadius, addBallColor);
+  shots.reserve(sweepShots.size());
+
+  flightStage.reset();
+  if (useFlightStage) {
+    reactphysics3d::Vector3 gravity = physicsWorld->getGravity();
+    flightStage = std::make_unique<FlightStage>(
+        terrain, addBallRadius, 1.0 / 60.0f,
+        glm::vec3(gravity.x, gravity.y, gravity.z));
+  }
+
+  for (const ShotParams& shot : sweepShots) {
+    addBall(shot, staggered);
   }
 
   // reverse staggered balls because staggered batches are taken from the back
@@ -813,19 +1103,94 @@ void AppLayer::initializeBalls(bool staggered) {
   }
 }
 
-void AppLayer::addBall(float power, float yawOffset, float pitch,
-                       bool staggered) {
-  glm::vec2 startPositionAbs = terrain.convertUV(startPosition);
-  glm::vec2 dirVector =
-      glm::normalize(goal.getAbsolutePosition(terrain) - startPositionAbs);
-  glm::vec2 perpVector(-dirVector.y, dirVector.x);
+void AppLayer::startParallelSolve() {
+  clearBalls();
+
+  std::vector<ShotParams> shots = sweepConfig.getShots();
+
+  // the last solver may still be pushing to the last stream
+  shardedSolver.reset();
+  openResultStream();
+  shardedSolver = std::make_unique<ShardedSolver>(
+      terrain, goal, startPosition, addBallRadius, solverThreads);
+  shardedSolver->setBackend(solverBackend);
+  shardedSolver->setAutoTune(autoTuneLiveBalls);
+  shardedSolver->setUseFlightStage(useFlightStage);
+  shardedSolver->setPrune(pruneShots);
+  shardedSolver->setStream(resultStream.get());
+  shardedSolver->start(shots, solverChunkSize, liveBallCount, maxShotTime);
+}
+
+void AppLayer::openResultStream() {
+  closeResultStream();
+  if (!streamResults) return;
+
+  resultStream = std::make_unique<ResultStream>();
+  if (!resultStream->open(streamFilePath, sweepConfig, addBallRadius,
+                          goal.getRadius())) {
+    resultStream.reset();
+  }
+}
+
+void AppLayer::closeResultStream() {
+  if (resultStream == nullptr) return;
+
+  resultStream->close();
+  std::cout << resultStream->getNumWritten() << " shots streamed to "
+            << streamFilePath << std::endl;
+  resultStream.reset();
+}
+
+void AppLayer::startInverseSearch() {
+  shardedSolver.reset();
+  clearBalls();
+  closeResultStream();
+
+  inverseDone = false;
+  inverseResult = InverseResult();
+  inverseSolver = std::make_unique<InverseSolver>(sweepConfig, inverseConfig);
+
+  // the settings are copied so the ui can keep changing them while the
+  // search runs
+  int numThreads = solverThreads;
+  int chunkSize = solverChunkSize;
+  int liveBalls = liveBallCount;
+  float shotTime = maxShotTime;
+  SolverBackend backend = solverBackend;
+  bool autoTune = autoTuneLiveBalls;
+  bool flight = useFlightStage;
+  float radius = addBallRadius;
+  inverseThread = std::thread([=]() {
+    ShardedSolver solver(terrain, goal, startPosition, radius, numThreads);
+    solver.setBackend(backend);
+    solver.setAutoTune(autoTune);
+    solver.setUseFlightStage(flight);
+    inverseResult = inverseSolver->run(
+        [&](const std::vector<ShotParams>& shots,
+            std::vector<float>& distances, std::vector<uint8_t>& states) {
+          distances = solver.solve(shots, chunkSize, liveBalls, shotTime);
+          states = solver.getStates();
+        });
+    inverseDone = true;
+  });
+}
 
-  glm::vec2 rotatedYawDir = glm::rotate(dirVector, yawOffset);
-  glm::vec2 rotatedPerp = glm::rotate(perpVector, yawOffset);
-  glm::vec3 rotatedDir =
-      glm::rotate(glm::vec3(rotatedYawDir.x, 0, rotatedYawDir.y), pitch,
-                  glm::vec3(rotatedPerp.x, 0, rotatedPerp.y));
-  glm::vec3 finalDir = rotatedDir * power;
+void AppLayer::finishInverseSearch(bool launchShots) {
+  if (inverseSolver == nullptr) return;
+
+  inverseSolver->cancel();
+  inverseThread.join();
+  inverseSolver.reset();
+
+  // the shots that were found are launched together so they can be watched
+  // going in
+  if (launchShots && !inverseResult.holedShots.empty()) {
+    initializeBalls(false, inverseResult.holedShots);
+  }
+}
+
+void AppLayer::addBall(ShotParams shot, bool staggered) {
+  glm::vec3 finalDir = getLaunchVelocity(terrain, goal, startPosition, shot);
 
   if (staggered) {
     staggeredBalls.push_back(finalDir);
@@ -835,49 +1200,58 @@ void AppLayer::addBall(float power, float yawOffset, float pitch,
 }
 
 void AppLayer::addBall(glm::vec3 velocity) {
-  glm::vec2 startPositionAbs = terrain.convertUV(startPosition);
-
-  Ball ball(startPositionAbs.x,
-            terrain.getHeightFromRelative(
-                glm::vec2(startPosition.x * terrain.getWidth(),
-                          startPosition.y * terrain.getHeight())) +
-                terrain.getPosition().y + addBallRadius * 2,
-            startPositionAbs.y, addBallRadius, addBallColor);
-  ball.addPhysics(physicsWorld, physicsCommon, ballShapeRegistry);
-  ball.setVelocity(velocity);
-
-  balls.push_back(ball);
+  glm::vec3 launchPosition =
+      getLaunchPosition(terrain, startPosition, addBallRadius);
+
+  // shots are always launched in sweep order
+  int row = shots.add(shots.size(), launchPosition);
+  if (flightStage != nullptr) {
+    shots.addFlight(row, velocity);
+  } else {
+    shots.addPhysics(row, *ballBodyPool);
+    shots.setVelocity(row, velocity);
+  }
 }
 
-void AppLayer::writeOutputFile(std::ofstream& fout) {
-  if (paramsNumDivisions * paramsNumDivisions * paramsNumDivisions !=
-      balls.size()) {
-    fout << "ERROR: "
-         << paramsNumDivisions * paramsNumDivisions * paramsNumDivisions
-         << " balls expected, " << balls.size() << " balls found." << std::endl;
-    return;
+void AppLayer::clearBalls() {
+  if (ballBodyPool != nullptr) {
+    shots.removeAllPhysics(*ballBodyPool);
+  }
+  shots.reset(addBallRadius, addBallColor);
+  for (Ball& ball : balls) {
+    ball.removePhysics(physicsWorld, physicsCommon, ballShapeRegistry);
   }
+  balls.clear();
+  staggeredBalls.clear();
+  liveShots.clear();
+}
 
-  fout << paramsNumDivisions << std::endl;
-  fout << minPower << std::endl;
-  fout << maxPower << std::endl;
-  fout << minYaw << std::endl;
-  fout << maxYaw << std::endl;
-  fout << minPitch << std::endl;
-  fout << maxPitch << std::endl;
-  fout << balls[0].getRadius() << std::endl;
-  fout << goal.getRadius() << std::endl;
-  fout << std::endl;
-  for (int i = 0; i < paramsNumDivisions; i++) {
-    for (int j = 0; j < paramsNumDivisions; j++) {
-      for (int k = 0; k < paramsNumDivisions; k++) {
-        fout << balls[i * paramsNumDivisions * paramsNumDivisions +
-                      j * paramsNumDivisions + k]
-                    .getDistFromGoal(goal, terrain);
-        if (k != paramsNumDivisions - 1) fout << " ";
-      }
-      fout << std::endl;
+void AppLayer::writeOutputFile(const std::string& path) {
+  float ballRadius = shots.getRadius();
+  const std::vector<float>* distances;
+  const std::vector<uint8_t>* states;
+  if (shardedSolver != nullptr) {
+    if (shardedSolver->isRunning() || shardedSolver->isCancelled()) {
+      std::cout << "ERROR: Parallel solve has not finished" << std::endl;
+      return;
     }
-    if (i != paramsNumDivisions - 1) fout << std::endl;
+
+    ballRadius = shardedSolver->getBallRadius();
+    distances = &shardedSolver->getDistances();
+    states = &shardedSolver->getStates();
+  } else {
+    shots.recordDistances(goal, terrain);
+    distances = &shots.getDistances();
+    states = &shots.getStates();
   }
+
+  if (binaryExport || sweepConfig.sampling != SamplingMode::GRID) {
+    writeBinaryResultFile(path, sweepConfig, ballRadius, goal.getRadius(),
+                          *distances, *states);
+    return;
+  }
+
+  std::ofstream fout(path);
+  writeResultFile(fout, sweepConfig, ballRadius, goal.getRadius(), *distances);
+  fout.close();
 }
@@ -1,14 +1,23 @@
 #pragma once
 
 #include "ball/Ball.h"
+#include "ball/BallBodyPool.h"
 #include "ball/BallModel.h"
 #include "ball/BallRenderer.h"
 #include "ball/BallShapeRegistry.h"
+#include "ball/FlightStage.h"
+#include "ball/ShotTable.h"
 #include "terrain/Terrain.h"
 #include "terrain/TerrainRenderer.h"
 #include "goal/Goal.h"
 #include "goal/GoalRenderer.h"
 #include "lights/Lights.h"
+#include "solver/InverseSolver.h"
+#include "solver/LiveCountController.h"
+#include "solver/LiveShot.h"
+#include "solver/ResultStream.h"
+#include "solver/ShardedSolver.h"
+#include "solver/Sweep.h"
 
 #include "util/opengl/PerspectiveCameraController.h"
 #include "util/plot/TimeMetrics.h"
@@ -20,7 +29,10 @@
 #include <GLFW/glfw3.h>
 #include <reactphysics3d/reactphysics3d.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 class AppLayer : public GLCore::Layer {
  public:
@@ -58,14 +70,23 @@ class AppLayer : public GLCore::Layer {
 
   bool showTimeMetrics = false;
   bool initSimultaneous = false;
+  bool initParallel = false;
   float dpiScale = 1.0;
   bool updateFont = false;
 
+  // balls launched by "Init Balls"
+  ShotTable shots;
+  // balls added one at a time from the debug window
   std::vector<Ball> balls;
   std::queue<Ball> ballsAdd;
   BallModel ballModel;
   BallRenderer ballRenderer;
   BallShapeRegistry ballShapeRegistry;
+  // rigid bodies for the shots
+  std::unique_ptr<BallBodyPool> ballBodyPool;
+  // moves the shots until they are about to land, if enabled
+  bool useFlightStage = true;
+  std::unique_ptr<FlightStage> flightStage;
 
   glm::vec3 addBallPosition;
   float addBallRadius;
@@ -76,16 +97,16 @@ class AppLayer : public GLCore::Layer {
   float startPositionHighlightRadius;
   glm::vec3 startPositionHighlightColor;
 
-  const float PI = 3.14159265f;
-  int paramsNumDivisions = 10;
-  float minPower = 20.0;
-  float maxPower = 25.0;
-  float minPitch = 30.0;
-  float maxPitch = 60.0f;
-  float minYaw = -15.0f;
-  float maxYaw = 15.0f;
-  int staggeredBatchSize = 250;
+  SweepConfig sweepConfig;
+  // staggered shots are pipelined: finished balls are retired one at a time
+  // and their rigid bodies reused for the next pending shot
+  int liveBallCount = 250;
+  bool autoTuneLiveBalls = true;
+  float maxShotTime = 120.0f;
+  LiveCountController liveCountController;
+  std::vector<LiveShot> liveShots;
   std::string outputFilePath = "";
+  bool binaryExport = true;
   bool exportReady = false;
   std::vector<glm::vec3> staggeredBalls;
 
@@ -98,6 +119,13 @@ class AppLayer : public GLCore::Layer {
   TimeMetrics timeMetrics;
 
   float physicsAccumulatedTime = 0;
+  bool maxThroughput = false;
+  float physicsBudgetMs = 12.0f;
+  int renderInterval = 10;
+  int frameCount = 0;
+  float simSpeed = 0;
+  float simSpeedSimulatedTime = 0;
+  float simSpeedRealTime = 0;
   bool physicsRunning = true;
   bool justStartedPhysics = true;
   reactphysics3d::PhysicsCommon physicsCommon;
@@ -107,8 +135,46 @@ class AppLayer : public GLCore::Layer {
   bool renderNormals = false;
   bool renderPhysicsDebugging = false;
 
-  void initializeBalls(bool staggered);
-  void addBall(float power, float yawOffset, float pitch, bool staggered);
+  // runs the whole sweep on worker threads without visualizing it; declared
+  // last so it is stopped before the terrain and goal it reads are destroyed
+  int solverThreads = std::max(1u, std::thread::hardware_concurrency());
+  int solverChunkSize = 1000;
+  SolverBackend solverBackend = SolverBackend::RP3D;
+  // stops parallel shots early once they can no longer go in
+  bool pruneShots = false;
+  // staggered and parallel shots are written to streamFilePath as they
+  // finish; the stream is declared before the solver so it outlives it
+  bool streamResults = false;
+  std::string streamFilePath = "result.golfs";
+  std::unique_ptr<ResultStream> resultStream;
+  std::unique_ptr<ShardedSolver> shardedSolver;
+  // searches for shots that go in on a background thread (with its own
+  // sharded solver) and then launches the ones it found
+  InverseConfig inverseConfig;
+  std::unique_ptr<InverseSolver> inverseSolver;
+  std::thread inverseThread;
+  std::atomic<bool> inverseDone{false};
+  InverseResult inverseResult;
+
+  bool isSolvingInParallel() {
+    return (shardedSolver != nullptr && shardedSolver->isRunning()) ||
+           inverseSolver != nullptr;
+  }
+  void startParallelSolve();
+  // opens a new stream if streamResults is set, after closing the last one
+  void openResultStream();
+  void closeResultStream();
+  void startInverseSearch();
+  // stops and joins the search thread, then launches the shots it found if
+  // launchShots is set
+  void finishInverseSearch(bool launchShots);
+  void stepPhysics(float dt);
+  bool updateStaggered(float dt);
+  void initializeBalls(bool staggered,
+                       const std::vector<ShotParams>& sweepShots);
+  void addBall(ShotParams shot, bool staggered);
   void addBall(glm::vec3 velocity);
-  void writeOutputFile(std::ofstream &fout);
+  // removes every shot and debug ball along with their physics
+  void clearBalls();
+  void writeOutputFile(const std::string &path);
 };
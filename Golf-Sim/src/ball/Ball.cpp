@@ -1,10 +1,18 @@
 #include "Ball.h"
 
+#ifndef GOLF_HEADLESS
 #include <imgui.h>
+#endif
 
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cmath>
 #include <iostream>
 
+#ifndef GOLF_HEADLESS
 #include "BallRenderer.h"
+#endif
 #include "BallShapeRegistry.h"
 #include "goal/Goal.h"
 #include "terrain/Terrain.h"
@@ -19,7 +27,9 @@ Ball::Ball(float x, float y, float z, float r, glm::vec3 color)
       color(color),
       state(BallState::ACTIVE),
       nearGoal(false),
-      rigidBody(nullptr) {}
+      rigidBody(nullptr),
+      collider(nullptr),
+      sphereShape(nullptr) {}
 
 void Ball::update(GLCore::Timestep ts, Terrain& terrain, Goal& goal,
                   reactphysics3d::PhysicsWorld* physicsWorld,
@@ -66,41 +76,21 @@ void Ball::update(GLCore::Timestep ts, Terrain& terrain, Goal& goal,
       currTransform.getPosition().x - goal.getAbsolutePosition(terrain).x;
   float goalDz =
       currTransform.getPosition().z - goal.getAbsolutePosition(terrain).y;
-  float switchRadius = goal.getRadius() + radius;
-  bool newNearGoal =
-      goalDx * goalDx + goalDz * goalDz < switchRadius * switchRadius;
-  // have to remove and add the collider because otherwise sometimes it doesn't
-  // update properly
-  if (!nearGoal && newNearGoal) {
-    this->rigidBody->removeCollider(this->collider);
-    this->collider = this->rigidBody->addCollider(
-        sphereShape, reactphysics3d::Transform::identity());
-    this->collider->setCollisionCategoryBits(CollisionCategory::BALL);
-    this->collider->setCollideWithMaskBits(CollisionCategory::GOAL);
-    this->collider->getMaterial().setBounciness(BOUNCINESS);
-    this->collider->getMaterial().setFrictionCoefficient(FRICTION);
-    this->collider->getMaterial().setMassDensity(MATERIAL_DENSITY);
-    nearGoal = true;
-  } else if (nearGoal && !newNearGoal) {
-    this->rigidBody->removeCollider(this->collider);
-    this->collider = this->rigidBody->addCollider(
-        sphereShape, reactphysics3d::Transform::identity());
-    this->collider->setCollisionCategoryBits(CollisionCategory::BALL);
-    this->collider->setCollideWithMaskBits(CollisionCategory::TERRAIN);
-    this->collider->getMaterial().setBounciness(BOUNCINESS);
-    this->collider->getMaterial().setFrictionCoefficient(FRICTION);
-    this->collider->getMaterial().setMassDensity(MATERIAL_DENSITY);
-    nearGoal = false;
-  }
+  float nearRadius = goal.getRadius() + radius;
+  // the ball always collides with both the terrain and the goal (the terrain
+  // is sunk below the goal where they overlap), so this is only needed to tell
+  // whether the ball has come to rest in the goal
+  nearGoal = goalDx * goalDx + goalDz * goalDz < nearRadius * nearRadius;
 
   // calculate if we are in the goal or not based on our current height and
   // proximity to the goal
   if (state == BallState::STATIONARY &&
-      abs(position.y - radius - goal.getBottomHeight()) < 0.2 && newNearGoal) {
+      abs(position.y - radius - goal.getBottomHeight()) < 0.2 && nearGoal) {
     state = BallState::GOAL;
   }
 }
 
+#ifndef GOLF_HEADLESS
 void Ball::render(BallRenderer& renderer) {
   glm::mat4 model = glm::mat4(1.0f);
   model = glm::translate(model, glm::vec3(position.x, position.y, position.z));
@@ -128,6 +118,9 @@ void Ball::imGuiRender(int index, reactphysics3d::PhysicsWorld* physicsWorld,
     case BallState::STATIONARY:
       stateString = "Stationary";
       break;
+    case BallState::PRUNED:
+      stateString = "Pruned";
+      break;
   }
 
   bool guiOpen = ImGui::TreeNode("Ball", "Ball %u [%s]", index, stateString);
@@ -185,28 +178,30 @@ void Ball::imGuiRender(int index, reactphysics3d::PhysicsWorld* physicsWorld,
   }
   ImGui::PopID();
 }
+#endif
 
 void Ball::addPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
                       reactphysics3d::PhysicsCommon& physicsCommon,
                       BallShapeRegistry& ballShapeRegistry) {
-  reactphysics3d::Vector3 position(position.x, position.y, position.z);
+  reactphysics3d::Vector3 physicsPosition(position.x, position.y, position.z);
   reactphysics3d::Quaternion orientation =
       reactphysics3d::Quaternion::identity();
-  reactphysics3d::Transform transform(position, orientation);
+  reactphysics3d::Transform transform(physicsPosition, orientation);
 
   this->prevTransform = transform;
 
   this->rigidBody = physicsWorld->createRigidBody(transform);
   this->rigidBody->setType(reactphysics3d::BodyType::DYNAMIC);
   this->rigidBody->setMass(radius * radius * radius);
-  this->rigidBody->setLinearDamping(0.3);
+  this->rigidBody->setLinearDamping(LINEAR_DAMPING);
 
   this->sphereShape = ballShapeRegistry.getShape(radius, physicsCommon);
 
   this->collider = this->rigidBody->addCollider(
       sphereShape, reactphysics3d::Transform::identity());
   this->collider->setCollisionCategoryBits(CollisionCategory::BALL);
-  this->collider->setCollideWithMaskBits(CollisionCategory::TERRAIN);
+  this->collider->setCollideWithMaskBits(CollisionCategory::TERRAIN |
+                                         CollisionCategory::GOAL);
   this->collider->getMaterial().setBounciness(BOUNCINESS);
   this->collider->getMaterial().setFrictionCoefficient(FRICTION);
   this->collider->getMaterial().setMassDensity(MATERIAL_DENSITY);
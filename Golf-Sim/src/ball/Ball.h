@@ -1,6 +1,6 @@
 #pragma once
 
-#include <GLCore.h>
+#include <GLCore/Core/Timestep.h>
 #include <reactphysics3d/reactphysics3d.h>
 
 #include <glm/glm.hpp>
@@ -10,7 +10,9 @@ class Goal;
 class BallRenderer;
 class BallShapeRegistry;
 
-enum class BallState { ACTIVE, OUT_OF_BOUNDS, STATIONARY, GOAL };
+// PRUNED shots were stopped early by a ShotPruner once they could no longer
+// end in the goal, so their distance is only a lower bound
+enum class BallState { ACTIVE, OUT_OF_BOUNDS, STATIONARY, GOAL, PRUNED };
 
 class Ball {
  public:
@@ -43,11 +45,12 @@ class Ball {
   bool isOutOfBounds(Terrain& terrain);
   float getDistFromGoal(Goal& goal, Terrain& terrain);
 
- private:
-  const float BOUNCINESS = 0.2;
-  const float FRICTION = 0.6;
-  const float MATERIAL_DENSITY = 10.0;
+  static constexpr float BOUNCINESS = 0.2f;
+  static constexpr float FRICTION = 0.6f;
+  static constexpr float MATERIAL_DENSITY = 10.0f;
+  static constexpr float LINEAR_DAMPING = 0.3f;
 
+ private:
   glm::vec3 position;
   float radius;
   glm::vec3 color;
@@ -0,0 +1,74 @@
+#include "BallBodyPool.h"
+
+#include <algorithm>
+
+#include "Ball.h"
+#include "BallShapeRegistry.h"
+#include "util/CollisionCategory.h"
+
+BallBodyPool::BallBodyPool(reactphysics3d::PhysicsWorld* physicsWorld,
+                           reactphysics3d::PhysicsCommon& physicsCommon,
+                           BallShapeRegistry& ballShapeRegistry, float radius,
+                           int capacity)
+    : physicsWorld(physicsWorld),
+      physicsCommon(physicsCommon),
+      ballShapeRegistry(ballShapeRegistry),
+      radius(radius) {
+  sphereShape = ballShapeRegistry.getShape(radius, physicsCommon);
+  reserve(capacity);
+}
+
+BallBodyPool::~BallBodyPool() {
+  for (reactphysics3d::RigidBody* body : bodies) {
+    physicsWorld->destroyRigidBody(body);
+  }
+  ballShapeRegistry.removeUsage(radius, physicsCommon);
+}
+
+void BallBodyPool::reserve(int capacity) {
+  while (bodies.size() < capacity) {
+    // same setup as Ball::addPhysics
+    reactphysics3d::RigidBody* body =
+        physicsWorld->createRigidBody(reactphysics3d::Transform::identity());
+    body->setType(reactphysics3d::BodyType::DYNAMIC);
+    body->setMass(radius * radius * radius);
+    body->setLinearDamping(Ball::LINEAR_DAMPING);
+
+    reactphysics3d::Collider* collider =
+        body->addCollider(sphereShape, reactphysics3d::Transform::identity());
+    collider->setCollisionCategoryBits(CollisionCategory::BALL);
+    collider->setCollideWithMaskBits(CollisionCategory::TERRAIN |
+                                     CollisionCategory::GOAL);
+    collider->getMaterial().setBounciness(Ball::BOUNCINESS);
+    collider->getMaterial().setFrictionCoefficient(Ball::FRICTION);
+    collider->getMaterial().setMassDensity(Ball::MATERIAL_DENSITY);
+
+    body->setIsActive(false);
+    bodies.push_back(body);
+    freeBodies.push_back(body);
+  }
+}
+
+reactphysics3d::RigidBody* BallBodyPool::acquire(glm::vec3 position) {
+  if (freeBodies.empty()) {
+    reserve(std::max(16, static_cast<int>(bodies.size()) * 2));
+  }
+
+  reactphysics3d::RigidBody* body = freeBodies.back();
+  freeBodies.pop_back();
+
+  body->setTransform(reactphysics3d::Transform(
+      reactphysics3d::Vector3(position.x, position.y, position.z),
+      reactphysics3d::Quaternion::identity()));
+  body->setLinearVelocity(reactphysics3d::Vector3::zero());
+  body->setAngularVelocity(reactphysics3d::Vector3::zero());
+  body->setIsActive(true);
+  body->setIsSleeping(false);
+
+  return body;
+}
+
+void BallBodyPool::release(reactphysics3d::RigidBody* body) {
+  body->setIsActive(false);
+  freeBodies.push_back(body);
+}
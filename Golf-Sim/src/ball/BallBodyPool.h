@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <vector>
+
+class BallShapeRegistry;
+
+// rigid bodies for shot balls of a single radius that are created up front and
+// then handed out and returned, so launching and retiring a ball only resets
+// and enables / disables a body instead of creating or destroying one inside
+// the physics world
+//
+// the pool grows if more bodies are acquired than were reserved, and must be
+// destroyed before its physics world
+class BallBodyPool {
+ public:
+  BallBodyPool(reactphysics3d::PhysicsWorld* physicsWorld,
+               reactphysics3d::PhysicsCommon& physicsCommon,
+               BallShapeRegistry& ballShapeRegistry, float radius,
+               int capacity = 0);
+  ~BallBodyPool();
+
+  void reserve(int capacity);
+
+  // enables a body at the given position, at rest
+  reactphysics3d::RigidBody* acquire(glm::vec3 position);
+  // disables a body
+  void release(reactphysics3d::RigidBody* body);
+
+  float getRadius() { return radius; }
+  int getCapacity() { return bodies.size(); }
+  int getNumInUse() { return bodies.size() - freeBodies.size(); }
+
+ private:
+  reactphysics3d::PhysicsWorld* physicsWorld;
+  reactphysics3d::PhysicsCommon& physicsCommon;
+  BallShapeRegistry& ballShapeRegistry;
+  float radius;
+  reactphysics3d::SphereShape* sphereShape;
+
+  std::vector<reactphysics3d::RigidBody*> bodies;
+  std::vector<reactphysics3d::RigidBody*> freeBodies;
+};
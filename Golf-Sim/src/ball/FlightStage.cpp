@@ -0,0 +1,90 @@
+#include "FlightStage.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Ball.h"
+#include "terrain/Terrain.h"
+#include "util/Geometry.h"
+
+FlightStage::FlightStage(Terrain& terrain, float ballRadius, float timeStep,
+                         glm::vec3 gravity)
+    : terrain(terrain),
+      ballRadius(ballRadius),
+      timeStep(timeStep),
+      gravity(gravity),
+      damping(1.0f / (1.0f + Ball::LINEAR_DAMPING * timeStep)) {}
+
+FlightStage::Result FlightStage::step(glm::vec3& position,
+                                      glm::vec3& velocity) {
+  if (isNearTerrain(position)) {
+    return Result::LANDING;
+  }
+
+  // same order as the physics world: gravity, then damping, then position
+  velocity = (velocity + gravity * timeStep) * damping;
+  position += velocity * timeStep;
+
+  if (position.y < terrain.getPosition().y + terrain.getMinHeight()) {
+    return Result::OUT_OF_BOUNDS;
+  }
+  return Result::FLYING;
+}
+
+bool FlightStage::isNearTerrain(glm::vec3 position) {
+  glm::vec3 terrainPos = terrain.getPosition();
+  float reach = ballRadius + CONTACT_MARGIN;
+
+  // most of a flight is spent well above the highest point of the terrain
+  if (position.y - reach > terrainPos.y + terrain.getMaxHeight()) {
+    return false;
+  }
+
+  float hSpacing = terrain.getHSpacing();
+  float vSpacing = terrain.getVSpacing();
+  float left = terrainPos.x - terrain.getWidth() / 2;
+  float bottom = terrainPos.z - terrain.getHeight() / 2;
+
+  // range of cells under the ball's reach, which is empty once the ball has
+  // left the map (it can't come back since nothing but gravity acts on it)
+  int colStart = std::max(0, (int)std::floor((position.x - reach - left) /
+                                             hSpacing));
+  int colEnd = std::min(terrain.getNumCols(),
+                        (int)std::floor((position.x + reach - left) /
+                                        hSpacing) + 1);
+  int rowStart = std::max(0, (int)std::floor((position.z - reach - bottom) /
+                                             vSpacing));
+  int rowEnd = std::min(terrain.getNumRows(),
+                        (int)std::floor((position.z + reach - bottom) /
+                                        vSpacing) + 1);
+
+  for (int row = rowStart; row < rowEnd; row++) {
+    for (int col = colStart; col < colEnd; col++) {
+      glm::vec3 botLeft = terrain.getVertexPosition(col, row);
+      glm::vec3 botRight = terrain.getVertexPosition(col + 1, row);
+      glm::vec3 topLeft = terrain.getVertexPosition(col, row + 1);
+      glm::vec3 topRight = terrain.getVertexPosition(col + 1, row + 1);
+
+      // same diagonal as the physics height field
+      glm::vec3 closest0 =
+          closestPointOnTriangle(position, botLeft, botRight, topLeft);
+      glm::vec3 closest1 =
+          closestPointOnTriangle(position, botRight, topRight, topLeft);
+      if (glm::dot(closest0 - position, closest0 - position) < reach * reach ||
+          glm::dot(closest1 - position, closest1 - position) < reach * reach) {
+        return true;
+      }
+    }
+  }
+
+  // a ball that somehow ended up below the surface (so it could reach the
+  // inside of the goal) is handed over as well
+  glm::vec2 rel(position.x - left, position.z - bottom);
+  if (rel.x >= 0 && rel.x < terrain.getWidth() && rel.y >= 0 &&
+      rel.y < terrain.getHeight() &&
+      position.y < terrainPos.y + terrain.getHeightFromRelative(rel)) {
+    return true;
+  }
+
+  return false;
+}
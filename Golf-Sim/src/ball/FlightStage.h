@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+class Terrain;
+
+// moves airborne shot balls along the same path the physics world would
+// integrate for them (gravity and linear damping, no contacts), so that a ball
+// only needs a rigid body once it gets close enough to the terrain to touch it
+//
+// the world steps positions with the velocity after gravity and damping were
+// applied (semi-implicit euler), which is reproduced here up to float rounding
+// so a ball handed over mid-flight continues exactly where the world would
+// have had it
+class FlightStage {
+ public:
+  // extra distance on top of the ball's radius at which a ball is handed
+  // over, covering the collision margin of the physics engine's shapes
+  const float CONTACT_MARGIN = 0.1f;
+
+  enum class Result { FLYING, LANDING, OUT_OF_BOUNDS };
+
+  FlightStage(Terrain& terrain, float ballRadius, float timeStep,
+              glm::vec3 gravity);
+
+  // returns LANDING (leaving the ball where it is) if the ball could touch the
+  // terrain during the next step, and otherwise advances it by one step,
+  // returning OUT_OF_BOUNDS once it has fallen below the terrain
+  Result step(glm::vec3& position, glm::vec3& velocity);
+
+  bool isNearTerrain(glm::vec3 position);
+
+ private:
+  Terrain& terrain;
+  float ballRadius;
+  float timeStep;
+  glm::vec3 gravity;
+  float damping;
+};
@@ -0,0 +1,280 @@
+#include "ShotTable.h"
+
+#ifndef GOLF_HEADLESS
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BallRenderer.h"
+#endif
+
+#include <cmath>
+
+#include "BallBodyPool.h"
+#include "FlightStage.h"
+#include "goal/Goal.h"
+#include "terrain/Terrain.h"
+
+ShotTable::ShotTable(float radius, glm::vec3 color)
+    : radius(radius), color(color) {}
+
+void ShotTable::reset(float radius, glm::vec3 color) {
+  this->radius = radius;
+  this->color = color;
+  numActive = 0;
+
+  positions.clear();
+  states.clear();
+  distances.clear();
+  paramIndices.clear();
+  slots.clear();
+  flights.clear();
+  freeRows.clear();
+
+  slotRows.clear();
+  bodies.clear();
+  prevPositions.clear();
+  nearGoal.clear();
+
+  flightRows.clear();
+  flightPositions.clear();
+  flightVelocities.clear();
+  flightPrevPositions.clear();
+}
+
+void ShotTable::reserve(int numShots) {
+  positions.reserve(numShots);
+  states.reserve(numShots);
+  distances.reserve(numShots);
+  paramIndices.reserve(numShots);
+  slots.reserve(numShots);
+  flights.reserve(numShots);
+}
+
+int ShotTable::add(int paramIndex, glm::vec3 position) {
+  int row;
+  if (!freeRows.empty()) {
+    row = freeRows.back();
+    freeRows.pop_back();
+  } else {
+    row = positions.size();
+    positions.emplace_back();
+    states.emplace_back();
+    distances.emplace_back();
+    paramIndices.emplace_back();
+    slots.emplace_back();
+    flights.emplace_back();
+  }
+
+  positions[row] = position;
+  states[row] = static_cast<uint8_t>(BallState::ACTIVE);
+  distances[row] = 0;
+  paramIndices[row] = paramIndex;
+  slots[row] = -1;
+  flights[row] = -1;
+  return row;
+}
+
+void ShotTable::release(int row) { freeRows.push_back(row); }
+
+void ShotTable::addPhysics(int row, BallBodyPool& pool) {
+  if (slots[row] != -1) return;
+
+  slots[row] = slotRows.size();
+  slotRows.push_back(row);
+  bodies.push_back(pool.acquire(positions[row]));
+  prevPositions.push_back(positions[row]);
+  nearGoal.push_back(false);
+}
+
+void ShotTable::removePhysics(int row, BallBodyPool& pool) {
+  // shots that are retired before they land never got a rigid body
+  removeFlight(row);
+
+  int slot = slots[row];
+  if (slot == -1) return;
+
+  pool.release(bodies[slot]);
+
+  // move the last slot into the removed one
+  int lastRow = slotRows.back();
+  slotRows[slot] = lastRow;
+  bodies[slot] = bodies.back();
+  prevPositions[slot] = prevPositions.back();
+  nearGoal[slot] = nearGoal.back();
+  slots[lastRow] = slot;
+
+  slotRows.pop_back();
+  bodies.pop_back();
+  prevPositions.pop_back();
+  nearGoal.pop_back();
+  slots[row] = -1;
+}
+
+void ShotTable::removeAllPhysics(BallBodyPool& pool) {
+  while (!slotRows.empty()) {
+    removePhysics(slotRows.back(), pool);
+  }
+  while (!flightRows.empty()) {
+    removeFlight(flightRows.back());
+  }
+}
+
+void ShotTable::setVelocity(int row, glm::vec3 velocity) {
+  bodies[slots[row]]->setLinearVelocity(
+      reactphysics3d::Vector3(velocity.x, velocity.y, velocity.z));
+}
+
+glm::vec3 ShotTable::getVelocity(int row) {
+  if (flights[row] != -1) {
+    return flightVelocities[flights[row]];
+  }
+  if (slots[row] == -1) {
+    return glm::vec3(0.0f);
+  }
+  const reactphysics3d::Vector3& velocity =
+      bodies[slots[row]]->getLinearVelocity();
+  return glm::vec3(velocity.x, velocity.y, velocity.z);
+}
+
+glm::vec3 ShotTable::getAngularVelocity(int row) {
+  // balls don't spin in flight
+  if (slots[row] == -1) {
+    return glm::vec3(0.0f);
+  }
+  const reactphysics3d::Vector3& velocity =
+      bodies[slots[row]]->getAngularVelocity();
+  return glm::vec3(velocity.x, velocity.y, velocity.z);
+}
+
+void ShotTable::addFlight(int row, glm::vec3 velocity) {
+  if (flights[row] != -1) return;
+
+  flights[row] = flightRows.size();
+  flightRows.push_back(row);
+  flightPositions.push_back(positions[row]);
+  flightVelocities.push_back(velocity);
+  flightPrevPositions.push_back(positions[row]);
+}
+
+void ShotTable::removeFlight(int row) {
+  int flight = flights[row];
+  if (flight == -1) return;
+
+  int lastRow = flightRows.back();
+  flightRows[flight] = lastRow;
+  flightPositions[flight] = flightPositions.back();
+  flightVelocities[flight] = flightVelocities.back();
+  flightPrevPositions[flight] = flightPrevPositions.back();
+  flights[lastRow] = flight;
+
+  flightRows.pop_back();
+  flightPositions.pop_back();
+  flightVelocities.pop_back();
+  flightPrevPositions.pop_back();
+  flights[row] = -1;
+}
+
+void ShotTable::stepFlights(FlightStage& flightStage, BallBodyPool& pool) {
+  for (int flight = flightRows.size() - 1; flight >= 0; flight--) {
+    int row = flightRows[flight];
+    FlightStage::Result result =
+        flightStage.step(flightPositions[flight], flightVelocities[flight]);
+    if (result == FlightStage::Result::FLYING) {
+      continue;
+    }
+
+    glm::vec3 velocity = flightVelocities[flight];
+    positions[row] = flightPositions[flight];
+    removeFlight(row);
+    if (result == FlightStage::Result::LANDING) {
+      addPhysics(row, pool);
+      setVelocity(row, velocity);
+    } else {
+      states[row] = static_cast<uint8_t>(BallState::OUT_OF_BOUNDS);
+    }
+  }
+}
+
+void ShotTable::update(Terrain& terrain, Goal& goal, BallBodyPool& pool,
+                       float interpolationFactor) {
+  float outOfBoundsHeight = terrain.getPosition().y + terrain.getMinHeight();
+  glm::vec2 goalPos = goal.getAbsolutePosition(terrain);
+  float nearRadius = goal.getRadius() + radius;
+  float bottomHeight = goal.getBottomHeight();
+
+  // iterate backwards so removing physics only moves slots already visited
+  numActive = 0;
+  for (int slot = slotRows.size() - 1; slot >= 0; slot--) {
+    int row = slotRows[slot];
+    BallState state = static_cast<BallState>(states[row]);
+
+    if (positions[row].y < outOfBoundsHeight) {
+      states[row] = static_cast<uint8_t>(BallState::OUT_OF_BOUNDS);
+      removePhysics(row, pool);
+      continue;
+    }
+
+    reactphysics3d::RigidBody* body = bodies[slot];
+    if (state == BallState::STATIONARY || state == BallState::ACTIVE) {
+      state = body->getLinearVelocity().lengthSquare() < 0.05
+                  ? BallState::STATIONARY
+                  : BallState::ACTIVE;
+    }
+
+    const reactphysics3d::Vector3& bodyPosition =
+        body->getTransform().getPosition();
+    glm::vec3 currPosition(bodyPosition.x, bodyPosition.y, bodyPosition.z);
+    positions[row] = prevPositions[slot] +
+                     (currPosition - prevPositions[slot]) * interpolationFactor;
+    prevPositions[slot] = currPosition;
+
+    float goalDx = currPosition.x - goalPos.x;
+    float goalDz = currPosition.z - goalPos.y;
+    nearGoal[slot] = goalDx * goalDx + goalDz * goalDz < nearRadius * nearRadius;
+
+    if (state == BallState::STATIONARY &&
+        std::abs(positions[row].y - radius - bottomHeight) < 0.2 &&
+        nearGoal[slot]) {
+      state = BallState::GOAL;
+    }
+
+    states[row] = static_cast<uint8_t>(state);
+    if (state == BallState::ACTIVE) {
+      numActive++;
+    }
+  }
+
+  for (int flight = 0; flight < flightRows.size(); flight++) {
+    int row = flightRows[flight];
+    positions[row] =
+        flightPrevPositions[flight] +
+        (flightPositions[flight] - flightPrevPositions[flight]) *
+            interpolationFactor;
+    flightPrevPositions[flight] = flightPositions[flight];
+  }
+  numActive += flightRows.size();
+}
+
+void ShotTable::recordDistance(int row, Goal& goal, Terrain& terrain) {
+  glm::vec2 goalPos = goal.getAbsolutePosition(terrain);
+  distances[row] = glm::length(
+      goalPos - glm::vec2(positions[row].x, positions[row].z));
+}
+
+void ShotTable::recordDistances(Goal& goal, Terrain& terrain) {
+  glm::vec2 goalPos = goal.getAbsolutePosition(terrain);
+  for (int row = 0; row < positions.size(); row++) {
+    distances[row] = glm::length(
+        goalPos - glm::vec2(positions[row].x, positions[row].z));
+  }
+}
+
+#ifndef GOLF_HEADLESS
+void ShotTable::render(BallRenderer& renderer) {
+  glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(radius));
+  for (const glm::vec3& position : positions) {
+    glm::mat4 model = scale;
+    model[3] = glm::vec4(position, 1.0f);
+    renderer.add(BallRenderJob{model, color});
+  }
+}
+#endif
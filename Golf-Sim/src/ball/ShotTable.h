@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ball/Ball.h"
+
+#include <glm/glm.hpp>
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <cstdint>
+#include <vector>
+
+class Terrain;
+class Goal;
+class BallBodyPool;
+class BallRenderer;
+class FlightStage;
+
+// state of every shot of a sweep, stored as separate arrays so that each pass
+// over the shots (updating, checking for active balls, rendering, exporting)
+// only streams over the fields it needs. all shots share a radius and color,
+// and their rigid bodies come from a BallBodyPool
+//
+// per shot state is kept for every row, while the rigid body, previous
+// position and goal proximity are only kept for the shots that currently have
+// physics, in slots that are compacted whenever physics is removed. shots that
+// are launched into a FlightStage instead keep their flight state in the same
+// way until they land and get their rigid body
+class ShotTable {
+ public:
+  ShotTable(float radius = 0.25f,
+            glm::vec3 color = glm::vec3(0.808f, 0.471f, 0.408f));
+
+  // removes every shot, which must not have physics anymore
+  void reset(float radius, glm::vec3 color);
+  void reserve(int numShots);
+
+  // adds a shot at rest and without physics, returning its row (which may be
+  // one that was released earlier)
+  int add(int paramIndex, glm::vec3 position);
+  // makes a row available to add again
+  void release(int row);
+
+  void addPhysics(int row, BallBodyPool& pool);
+  // also stops the shot if it is still in flight, so retiring a shot is
+  // always removePhysics (and release, if the row is to be reused)
+  void removePhysics(int row, BallBodyPool& pool);
+  // also stops every shot that is still in flight
+  void removeAllPhysics(BallBodyPool& pool);
+  void setVelocity(int row, glm::vec3 velocity);
+  // current velocity of a shot with physics or in flight (0 for the others)
+  glm::vec3 getVelocity(int row);
+  glm::vec3 getAngularVelocity(int row);
+
+  // launches a shot with the given velocity without physics, leaving it to
+  // stepFlights until it gets close to the terrain
+  void addFlight(int row, glm::vec3 velocity);
+  // advances every shot in flight by one step and hands the ones that are
+  // about to land over to the physics world. call right before stepping the
+  // world so that the landing shots are stepped by it in the same step
+  void stepFlights(FlightStage& flightStage, BallBodyPool& pool);
+
+  // same as Ball::update for every shot with physics (shots in flight are
+  // only interpolated, since they are always active)
+  void update(Terrain& terrain, Goal& goal, BallBodyPool& pool,
+              float interpolationFactor);
+
+  // stores the distance of the shot's current position from the goal as its
+  // final distance
+  void recordDistance(int row, Goal& goal, Terrain& terrain);
+  void recordDistances(Goal& goal, Terrain& terrain);
+
+#ifndef GOLF_HEADLESS
+  void render(BallRenderer& renderer);
+#endif
+
+  int size() { return positions.size(); }
+  int getNumWithPhysics() { return slotRows.size(); }
+  int getNumInFlight() { return flightRows.size(); }
+  int getNumActive() { return numActive; }
+  float getRadius() { return radius; }
+
+  glm::vec3 getPosition(int row) { return positions[row]; }
+  BallState getState(int row) { return static_cast<BallState>(states[row]); }
+  float getDistance(int row) { return distances[row]; }
+  int getParamIndex(int row) { return paramIndices[row]; }
+  bool hasPhysics(int row) { return slots[row] != -1; }
+  bool isInFlight(int row) { return flights[row] != -1; }
+  const std::vector<float>& getDistances() { return distances; }
+  const std::vector<uint8_t>& getStates() { return states; }
+
+ private:
+  float radius;
+  glm::vec3 color;
+  int numActive = 0;
+
+  // per shot
+  std::vector<glm::vec3> positions;
+  std::vector<uint8_t> states;
+  std::vector<float> distances;
+  std::vector<int> paramIndices;
+  std::vector<int> slots;
+  std::vector<int> flights;
+  std::vector<int> freeRows;
+
+  // per shot with physics
+  std::vector<int> slotRows;
+  std::vector<reactphysics3d::RigidBody*> bodies;
+  std::vector<glm::vec3> prevPositions;
+  std::vector<uint8_t> nearGoal;
+
+  // per shot in flight
+  std::vector<int> flightRows;
+  std::vector<glm::vec3> flightPositions;
+  std::vector<glm::vec3> flightVelocities;
+  std::vector<glm::vec3> flightPrevPositions;
+
+  void removeFlight(int row);
+};
@@ -4,10 +4,12 @@
 #include <reactphysics3d/collision/TriangleVertexArray.h>
 #include <reactphysics3d/collision/shapes/ConvexMeshShape.h>
 
+#ifndef GOLF_HEADLESS
 #include "goal/GoalRenderer.h"
+#include "ImGuiConstants.h"
+#endif
 #include "terrain/Terrain.h"
 #include "util/CollisionCategory.h"
-#include "ImGuiConstants.h"
 
 Goal::Goal(float x, float z, float r)
     : relativePosition(x, z), radius(r), color(0.1f, 0.35f, 0.1f) {}
@@ -20,10 +22,13 @@ void Goal::generateModel(Terrain& terrain) {
       relativePosition.y * (terrain.getHeight() - 2 * radius) + radius);
 
   goalModel.generateModel(terrain, relativeCoords, radius);
+  terrain.setGoalFootprint(goalModel.getColStart(), goalModel.getColEnd(),
+                           goalModel.getRowStart(), goalModel.getRowEnd());
 }
 
 void Goal::freeModel() { goalModel.freeModel(); }
 
+#ifndef GOLF_HEADLESS
 void Goal::render(GoalRenderer& renderer) {
   renderer.add(GoalRenderJob{goalModel, color});
 }
@@ -44,9 +49,22 @@ void Goal::imGuiRender(reactphysics3d::PhysicsWorld* physicsWorld,
   }
   clearButtonStyle();
 }
+#endif
 
 void Goal::addPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
                       reactphysics3d::PhysicsCommon& physicsCommon) {
+  physics = createPhysics(physicsWorld, physicsCommon);
+}
+
+void Goal::removePhysics(reactphysics3d::PhysicsWorld* physicsWorld,
+                         reactphysics3d::PhysicsCommon& physicsCommon) {
+  destroyPhysics(physics, physicsWorld, physicsCommon);
+}
+
+GoalPhysics Goal::createPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
+                                reactphysics3d::PhysicsCommon& physicsCommon) {
+  GoalPhysics physics;
+
   reactphysics3d::Vector3 position(goalModel.getPosition().x,
                                    goalModel.getPosition().y,
                                    goalModel.getPosition().z);
@@ -54,10 +72,10 @@ void Goal::addPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
       reactphysics3d::Quaternion::identity();
   reactphysics3d::Transform transform(position, orientation);
 
-  this->rigidBody = physicsWorld->createRigidBody(transform);
-  this->rigidBody->setType(reactphysics3d::BodyType::STATIC);
+  physics.rigidBody = physicsWorld->createRigidBody(transform);
+  physics.rigidBody->setType(reactphysics3d::BodyType::STATIC);
 
-  terrainVA = new reactphysics3d::TriangleVertexArray(
+  physics.terrainVA = new reactphysics3d::TriangleVertexArray(
       goalModel.getVerticesArray(GoalModelPart::TERRAIN_PART).size() / 3,
       goalModel.getVerticesArray(GoalModelPart::TERRAIN_PART).data(),
       3 * sizeof(float),
@@ -67,7 +85,7 @@ void Goal::addPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
       reactphysics3d::TriangleVertexArray::VertexDataType::VERTEX_FLOAT_TYPE,
       reactphysics3d::TriangleVertexArray::IndexDataType::INDEX_INTEGER_TYPE);
 
-  wallsVA = new reactphysics3d::TriangleVertexArray(
+  physics.wallsVA = new reactphysics3d::TriangleVertexArray(
       goalModel.getVerticesArray(GoalModelPart::WALLS_PART).size() / 3,
       goalModel.getVerticesArray(GoalModelPart::WALLS_PART).data(),
       3 * sizeof(float),
@@ -77,7 +95,7 @@ void Goal::addPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
       reactphysics3d::TriangleVertexArray::VertexDataType::VERTEX_FLOAT_TYPE,
       reactphysics3d::TriangleVertexArray::IndexDataType::INDEX_INTEGER_TYPE);
 
-  bottomVA = new reactphysics3d::TriangleVertexArray(
+  physics.bottomVA = new reactphysics3d::TriangleVertexArray(
       goalModel.getVerticesArray(GoalModelPart::BOTTOM_PART).size() / 3,
       goalModel.getVerticesArray(GoalModelPart::BOTTOM_PART).data(),
       3 * sizeof(float),
@@ -102,33 +120,32 @@ void Goal::addPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
   //   std::cout << x << std::endl;
   // }
 
-  triangleMesh = physicsCommon.createTriangleMesh();
-  triangleMesh->addSubpart(terrainVA);
-  triangleMesh->addSubpart(wallsVA);
-  triangleMesh->addSubpart(bottomVA);
+  physics.triangleMesh = physicsCommon.createTriangleMesh();
+  physics.triangleMesh->addSubpart(physics.terrainVA);
+  physics.triangleMesh->addSubpart(physics.wallsVA);
+  physics.triangleMesh->addSubpart(physics.bottomVA);
 
-  shape = physicsCommon.createConcaveMeshShape(triangleMesh);
-  this->collider = this->rigidBody->addCollider(shape, shapeTransform);
-  this->collider->setCollisionCategoryBits(CollisionCategory::GOAL);
-  this->collider->setCollideWithMaskBits(CollisionCategory::BALL);
+  physics.shape = physicsCommon.createConcaveMeshShape(physics.triangleMesh);
+  physics.collider =
+      physics.rigidBody->addCollider(physics.shape, shapeTransform);
+  physics.collider->setCollisionCategoryBits(CollisionCategory::GOAL);
+  physics.collider->setCollideWithMaskBits(CollisionCategory::BALL);
+
+  return physics;
 }
 
-void Goal::removePhysics(reactphysics3d::PhysicsWorld* physicsWorld,
-                         reactphysics3d::PhysicsCommon& physicsCommon) {
-  physicsWorld->destroyRigidBody(rigidBody);
-  physicsCommon.destroyConcaveMeshShape(shape);
-  physicsCommon.destroyTriangleMesh(triangleMesh);
-
-  delete terrainVA;
-  delete wallsVA;
-  delete bottomVA;
-
-  rigidBody = nullptr;
-  shape = nullptr;
-  triangleMesh = nullptr;
-  terrainVA = nullptr;
-  wallsVA = nullptr;
-  bottomVA = nullptr;
+void Goal::destroyPhysics(GoalPhysics& physics,
+                          reactphysics3d::PhysicsWorld* physicsWorld,
+                          reactphysics3d::PhysicsCommon& physicsCommon) {
+  physicsWorld->destroyRigidBody(physics.rigidBody);
+  physicsCommon.destroyConcaveMeshShape(physics.shape);
+  physicsCommon.destroyTriangleMesh(physics.triangleMesh);
+
+  delete physics.terrainVA;
+  delete physics.wallsVA;
+  delete physics.bottomVA;
+
+  physics = GoalPhysics();
 }
 
 glm::vec2 Goal::getAbsolutePosition(Terrain& terrain) {
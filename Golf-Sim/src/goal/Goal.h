@@ -8,6 +8,17 @@
 class Terrain;
 class GoalRenderer;
 
+// physics objects for one copy of the goal in a physics world
+struct GoalPhysics {
+  reactphysics3d::RigidBody* rigidBody = nullptr;
+  reactphysics3d::Collider* collider = nullptr;
+  reactphysics3d::ConcaveMeshShape* shape = nullptr;
+  reactphysics3d::TriangleMesh* triangleMesh = nullptr;
+  reactphysics3d::TriangleVertexArray* terrainVA = nullptr;
+  reactphysics3d::TriangleVertexArray* wallsVA = nullptr;
+  reactphysics3d::TriangleVertexArray* bottomVA = nullptr;
+};
+
 class Goal {
  public:
   const float PI = 3.14159265f;
@@ -28,6 +39,14 @@ class Goal {
   void removePhysics(reactphysics3d::PhysicsWorld* physicsWorld,
                      reactphysics3d::PhysicsCommon& physicsCommon);
 
+  // creates a copy of the goal collider that the caller owns (the triangle
+  // data itself stays in the goal model and is shared between copies)
+  GoalPhysics createPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
+                            reactphysics3d::PhysicsCommon& physicsCommon);
+  void destroyPhysics(GoalPhysics& physics,
+                      reactphysics3d::PhysicsWorld* physicsWorld,
+                      reactphysics3d::PhysicsCommon& physicsCommon);
+
   glm::vec2 getRelativePosition() { return relativePosition; }
   glm::vec2 getAbsolutePosition(Terrain& terrain);
   glm::vec2 getAbsolutePosition(glm::vec3 terrainPos, float terrainWidth,
@@ -42,12 +61,6 @@ class Goal {
 
   GoalModel goalModel;
 
-  reactphysics3d::RigidBody* rigidBody;
-  reactphysics3d::Collider* collider;
-  reactphysics3d::ConcaveMeshShape* shape;
-  reactphysics3d::TriangleMesh* triangleMesh;
-  reactphysics3d::TriangleVertexArray* terrainVA;
-  reactphysics3d::TriangleVertexArray* wallsVA;
-  reactphysics3d::TriangleVertexArray* bottomVA;
+  GoalPhysics physics;
   reactphysics3d::Transform prevTransform;
 };
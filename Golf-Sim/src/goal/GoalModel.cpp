@@ -1,10 +1,13 @@
 #include "GoalModel.h"
 
+#ifndef GOLF_HEADLESS
 #include <glad/glad.h>
+#endif
 #include <terrain/Terrain.h>
 #include <terrain/TerrainModel.h>
 
 #include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <memory>
 
@@ -70,9 +73,13 @@ std::vector<glm::vec2> circleLineIntersection(glm::vec2 c, float radius,
 }
 
 std::vector<glm::vec3> addHeights(std::vector<glm::vec2> v, Terrain& terrain) {
+  std::vector<float> heights(v.size());
+  terrain.getHeightsFromRelative(v.data(), heights.data(),
+                                 static_cast<int>(v.size()));
   std::vector<glm::vec3> res;
-  for (glm::vec2 p : v) {
-    res.push_back(glm::vec3(p.x, terrain.getHeightFromRelative(p), p.y));
+  res.reserve(v.size());
+  for (size_t i = 0; i < v.size(); i++) {
+    res.push_back(glm::vec3(v[i].x, heights[i], v[i].y));
   }
 
   return res;
@@ -98,17 +105,29 @@ void GoalModel::generateModel(Terrain& terrain, glm::vec2 goalCenter,
   int rr = static_cast<int>(ceilf(r / hSpacing));
   int rb = static_cast<int>(floorf(b / vSpacing));
   int rt = static_cast<int>(ceilf(t / vSpacing));
+  colStart = rl;
+  colEnd = rr;
+  rowStart = rb;
+  rowEnd = rt;
 
   float averageHeight = 0;
 
   // generate points on circle and project onto terrain
   std::vector<GoalModelPoint> points(SECTOR_COUNT);
+  std::vector<glm::vec2> sectorPositions(SECTOR_COUNT);
   for (int i = 0; i < SECTOR_COUNT; i++) {
     float angle = i * SECTOR_STEP;
-    float x = radius * cosf(angle) + goalCenter.x;
-    float y = radius * sinf(angle) + goalCenter.y;
-    points[i].pos = glm::vec2(x, y);
-    points[i].height = terrain.getHeightFromRelative(points[i].pos);
+    sectorPositions[i] = glm::vec2(radius * cosf(angle) + goalCenter.x,
+                                   radius * sinf(angle) + goalCenter.y);
+  }
+  std::vector<float> sectorHeights(SECTOR_COUNT);
+  terrain.getHeightsFromRelative(sectorPositions.data(), sectorHeights.data(),
+                                 SECTOR_COUNT);
+  for (int i = 0; i < SECTOR_COUNT; i++) {
+    float x = sectorPositions[i].x;
+    float y = sectorPositions[i].y;
+    points[i].pos = sectorPositions[i];
+    points[i].height = sectorHeights[i];
     points[i].row = y / vSpacing;
     points[i].col = x / hSpacing;
 
@@ -309,6 +328,38 @@ void GoalModel::generateModel(Terrain& terrain, glm::vec2 goalCenter,
     }
   }
 
+  // the terrain's physics height field is sunk below the goal under the
+  // bounding box (see Terrain::setGoalFootprint), which drags the ring of cells
+  // around it down as well, so the physics mesh also covers that ring with the
+  // real terrain surface (using the same diagonal as the height field)
+  for (int row = rb - 1; row <= rt; row++) {
+    for (int col = rl - 1; col <= rr; col++) {
+      bool inBox = row >= rb && row < rt && col >= rl && col < rr;
+      bool inMap = row >= 0 && row < terrain.getNumRows() && col >= 0 &&
+                   col < terrain.getNumCols();
+      if (inBox || !inMap) {
+        continue;
+      }
+
+      float tl = col * hSpacing;
+      float tr = (col + 1) * hSpacing;
+      float tb = row * vSpacing;
+      float tt = (row + 1) * vSpacing;
+      glm::vec3 topLeft = glm::vec3(tl, terrain.getHeight(col, row + 1), tt);
+      glm::vec3 topRight =
+          glm::vec3(tr, terrain.getHeight(col + 1, row + 1), tt);
+      glm::vec3 botLeft = glm::vec3(tl, terrain.getHeight(col, row), tb);
+      glm::vec3 botRight = glm::vec3(tr, terrain.getHeight(col + 1, row), tb);
+
+      addTriangle(topLeft, topRight, botRight,
+                  getNormal(topLeft, topRight, botRight),
+                  GoalModelPart::TERRAIN_PART, true);
+      addTriangle(topLeft, botRight, botLeft,
+                  getNormal(topLeft, botRight, botLeft),
+                  GoalModelPart::TERRAIN_PART, true);
+    }
+  }
+
   // add walls of the goal
   this->bottomHeight = averageHeight - GOAL_HEIGHT + terrain.getPosition().y;
 
@@ -349,6 +400,7 @@ void GoalModel::generateModel(Terrain& terrain, glm::vec2 goalCenter,
                 GoalModelPart::BOTTOM_PART);
   }
 
+#ifndef GOLF_HEADLESS
   vertexArray = std::make_unique<opengl::VertexArray>();
   vertexArray->bind();
 
@@ -359,16 +411,20 @@ void GoalModel::generateModel(Terrain& terrain, glm::vec2 goalCenter,
   vertexBuffer->setVertexAttribute(1, 3, GL_FLOAT, 3 * sizeof(float));
 
   vertexArray->unbind();
+#endif
 }
 
-void GoalModel::addVertex(glm::vec3 a, glm::vec3 norm, GoalModelPart part) {
-  fullVertexData.push_back(a.x);
-  fullVertexData.push_back(a.y);
-  fullVertexData.push_back(a.z);
+void GoalModel::addVertex(glm::vec3 a, glm::vec3 norm, GoalModelPart part,
+                          bool physicsOnly) {
+  if (!physicsOnly) {
+    fullVertexData.push_back(a.x);
+    fullVertexData.push_back(a.y);
+    fullVertexData.push_back(a.z);
 
-  fullVertexData.push_back(norm.x);
-  fullVertexData.push_back(norm.y);
-  fullVertexData.push_back(norm.z);
+    fullVertexData.push_back(norm.x);
+    fullVertexData.push_back(norm.y);
+    fullVertexData.push_back(norm.z);
+  }
 
   std::vector<float>& vertices = getVerticesArray(part);
   std::vector<unsigned int>& indices = getIndicesArray(part);
@@ -391,7 +447,9 @@ void GoalModel::addVertex(glm::vec3 a, glm::vec3 norm, GoalModelPart part) {
 
   indices.push_back(static_cast<unsigned int>(ix));
 
-  numVertices++;
+  if (!physicsOnly) {
+    numVertices++;
+  }
 }
 
 glm::vec3 GoalModel::getNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
@@ -403,7 +461,8 @@ glm::vec3 GoalModel::getNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
 }
 
 void GoalModel::addTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c,
-                            glm::vec3 norm, GoalModelPart part) {
+                            glm::vec3 norm, GoalModelPart part,
+                            bool physicsOnly) {
   if (glm::length(a - b) < 0.01 || glm::length(a - c) < 0.01 ||
       glm::length(b - c) < 0.01) {
     return;
@@ -417,16 +476,18 @@ void GoalModel::addTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c,
   // ensure the ordering is consistent
   if (triangleNorm.y < 0) {
     norm = getNormal(a, c, b);
-    addVertex(a, norm, part);
-    addVertex(c, norm, part);
-    addVertex(b, norm, part);
+    addVertex(a, norm, part, physicsOnly);
+    addVertex(c, norm, part, physicsOnly);
+    addVertex(b, norm, part, physicsOnly);
   } else {
-    addVertex(a, norm, part);
-    addVertex(b, norm, part);
-    addVertex(c, norm, part);
+    addVertex(a, norm, part, physicsOnly);
+    addVertex(b, norm, part, physicsOnly);
+    addVertex(c, norm, part, physicsOnly);
   }
 
-  numVertices += 3;
+  if (!physicsOnly) {
+    numVertices += 3;
+  }
 }
 
 std::vector<float>& GoalModel::getVerticesArray(GoalModelPart part) {
@@ -463,6 +524,8 @@ void GoalModel::freeModel() {
   bottomIndices.clear();
   numVertices = 0;
 
+#ifndef GOLF_HEADLESS
   vertexArray->free();
   vertexBuffer->free();
+#endif
 }
@@ -38,6 +38,13 @@ class GoalModel {
   int getNumVertices() { return numVertices; }
   float getBottomHeight() { return bottomHeight; }
 
+  // range of terrain cells [colStart, colEnd) x [rowStart, rowEnd) that the
+  // goal model replaces
+  int getColStart() { return colStart; }
+  int getColEnd() { return colEnd; }
+  int getRowStart() { return rowStart; }
+  int getRowEnd() { return rowEnd; }
+
  private:
   glm::vec3 pos;
   std::vector<float> fullVertexData;
@@ -52,15 +59,22 @@ class GoalModel {
 
   int numVertices;
   float bottomHeight;
+  int colStart = 0;
+  int colEnd = 0;
+  int rowStart = 0;
+  int rowEnd = 0;
 
   std::unique_ptr<opengl::VertexArray> vertexArray;
   std::unique_ptr<opengl::VertexBuffer> vertexBuffer;
   std::unique_ptr<opengl::IndexBuffer> indexBuffer;
 
-  void addVertex(glm::vec3 a, glm::vec3 norm, GoalModelPart part);
+  // physics only vertices / triangles are only added to the physics arrays,
+  // not to the rendered model
+  void addVertex(glm::vec3 a, glm::vec3 norm, GoalModelPart part,
+                 bool physicsOnly = false);
   glm::vec3 getNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c);
   void addTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 norm,
-                   GoalModelPart part);
+                   GoalModelPart part, bool physicsOnly = false);
 };
 
 struct GoalModelPoint {
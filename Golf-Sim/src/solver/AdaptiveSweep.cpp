@@ -0,0 +1,155 @@
+#include "AdaptiveSweep.h"
+
+#include <algorithm>
+
+AdaptiveSweep::AdaptiveSweep(const SweepConfig& sweepConfig, int maxLevel,
+                             float successDistance, float gradientThreshold)
+    : sweepConfig(sweepConfig),
+      maxLevel(std::max(0, maxLevel)),
+      successDistance(successDistance),
+      gradientThreshold(gradientThreshold) {
+  while (this->maxLevel > 0 &&
+         computeResolution(sweepConfig.numDivisions, this->maxLevel) >
+             MAX_RESOLUTION) {
+    this->maxLevel--;
+  }
+  resolution = computeResolution(sweepConfig.numDivisions, this->maxLevel);
+}
+
+long long AdaptiveSweep::computeResolution(int numDivisions, int maxLevel) {
+  // more than 16 levels never fit, and shifting much further would overflow
+  long long baseCells = std::max(1, numDivisions - 1);
+  return baseCells << std::min(std::max(0, maxLevel), 17);
+}
+
+void AdaptiveSweep::run(const ShotEvaluator& evaluate) {
+  samples.clear();
+  leaves.clear();
+  sampleIndices.clear();
+  pendingSamples.clear();
+
+  int baseCells = std::max(1, sweepConfig.numDivisions - 1);
+  int baseSize = 1 << maxLevel;
+
+  std::vector<AdaptiveCell> cells;
+  for (int i = 0; i < baseCells; i++) {
+    for (int j = 0; j < baseCells; j++) {
+      for (int k = 0; k < baseCells; k++) {
+        cells.push_back(AdaptiveCell{
+            static_cast<uint16_t>(i * baseSize),
+            static_cast<uint16_t>(j * baseSize),
+            static_cast<uint16_t>(k * baseSize),
+            static_cast<uint16_t>(baseSize)});
+      }
+    }
+  }
+  for (int i = 0; i <= baseCells; i++) {
+    for (int j = 0; j <= baseCells; j++) {
+      for (int k = 0; k <= baseCells; k++) {
+        request(i * baseSize, j * baseSize, k * baseSize);
+      }
+    }
+  }
+  evaluatePending(evaluate);
+
+  while (!cells.empty()) {
+    std::vector<AdaptiveCell> nextCells;
+    for (const AdaptiveCell& cell : cells) {
+      if (cell.size == 1 || !needsRefinement(cell)) {
+        leaves.push_back(cell);
+        continue;
+      }
+
+      // the 27 points of the split cell, 8 of which are its own corners
+      int half = cell.size / 2;
+      for (int i = 0; i <= 2; i++) {
+        for (int j = 0; j <= 2; j++) {
+          for (int k = 0; k <= 2; k++) {
+            request(cell.power + i * half, cell.yaw + j * half,
+                    cell.pitch + k * half);
+          }
+        }
+      }
+      for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+          for (int k = 0; k < 2; k++) {
+            nextCells.push_back(AdaptiveCell{
+                static_cast<uint16_t>(cell.power + i * half),
+                static_cast<uint16_t>(cell.yaw + j * half),
+                static_cast<uint16_t>(cell.pitch + k * half),
+                static_cast<uint16_t>(half)});
+          }
+        }
+      }
+    }
+
+    evaluatePending(evaluate);
+    cells = std::move(nextCells);
+  }
+}
+
+uint64_t AdaptiveSweep::getKey(int power, int yaw, int pitch) {
+  uint64_t side = resolution + 1;
+  return (power * side + yaw) * side + pitch;
+}
+
+void AdaptiveSweep::request(int power, int yaw, int pitch) {
+  uint64_t key = getKey(power, yaw, pitch);
+  if (sampleIndices.count(key)) return;
+
+  sampleIndices[key] = samples.size();
+  pendingSamples.push_back(samples.size());
+  samples.push_back(AdaptiveSample{static_cast<uint16_t>(power),
+                                   static_cast<uint16_t>(yaw),
+                                   static_cast<uint16_t>(pitch), 0, 0.0f});
+}
+
+void AdaptiveSweep::evaluatePending(const ShotEvaluator& evaluate) {
+  if (pendingSamples.empty()) return;
+
+  std::vector<ShotParams> shots;
+  for (int index : pendingSamples) {
+    const AdaptiveSample& sample = samples[index];
+    shots.push_back(ShotParams{
+        sweepConfig.minPower + (sweepConfig.maxPower - sweepConfig.minPower) *
+                                   sample.power / resolution,
+        sweepConfig.minYaw +
+            (sweepConfig.maxYaw - sweepConfig.minYaw) * sample.yaw / resolution,
+        sweepConfig.minPitch + (sweepConfig.maxPitch - sweepConfig.minPitch) *
+                                   sample.pitch / resolution});
+  }
+
+  std::vector<float> distances;
+  std::vector<uint8_t> states;
+  evaluate(shots, distances, states);
+
+  for (int i = 0; i < pendingSamples.size(); i++) {
+    samples[pendingSamples[i]].distance = distances[i];
+    samples[pendingSamples[i]].state = states[i];
+  }
+  pendingSamples.clear();
+}
+
+float AdaptiveSweep::getDistance(int power, int yaw, int pitch) {
+  // every corner of a cell is requested before the cell is looked at
+  return samples[sampleIndices.at(getKey(power, yaw, pitch))].distance;
+}
+
+bool AdaptiveSweep::needsRefinement(const AdaptiveCell& cell) {
+  float minDistance = getDistance(cell.power, cell.yaw, cell.pitch);
+  float maxDistance = minDistance;
+  for (int corner = 1; corner < 8; corner++) {
+    float distance =
+        getDistance(cell.power + ((corner >> 2) & 1) * cell.size,
+                    cell.yaw + ((corner >> 1) & 1) * cell.size,
+                    cell.pitch + (corner & 1) * cell.size);
+    minDistance = std::min(minDistance, distance);
+    maxDistance = std::max(maxDistance, distance);
+  }
+
+  bool straddles =
+      minDistance < successDistance && maxDistance >= successDistance;
+  bool steep = gradientThreshold > 0 &&
+               maxDistance - minDistance > gradientThreshold;
+  return straddles || steep;
+}
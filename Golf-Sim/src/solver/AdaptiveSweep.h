@@ -0,0 +1,82 @@
+#pragma once
+
+#include "solver/Sweep.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// a shot of an adaptive sweep, at integer coordinates of the finest lattice
+// (power, yaw, pitch, each from 0 to getResolution())
+struct AdaptiveSample {
+  uint16_t power;
+  uint16_t yaw;
+  uint16_t pitch;
+  uint8_t state;
+  float distance;
+};
+
+// an octree cell of the lattice, from its origin to origin + size on each axis
+struct AdaptiveCell {
+  uint16_t power;
+  uint16_t yaw;
+  uint16_t pitch;
+  uint16_t size;
+};
+
+// sweeps the power / yaw / pitch cube with an octree instead of a uniform
+// grid: the sweep's numDivisions points per axis form the coarse grid, and
+// every cell whose corners straddle the success distance (or whose corner
+// distances differ by more than the gradient threshold) is split into eight,
+// down to maxLevel splits. each level is simulated as a single batch
+//
+// the success region is a thin surface through the cube, so the finest level
+// resolves it as well as a uniform grid of getResolution() + 1 points per axis
+// would, for a small fraction of the shots
+class AdaptiveSweep {
+ public:
+  // lattice coordinates are 16 bit
+  static const int MAX_RESOLUTION = 65535;
+
+  // cells per axis of the finest lattice of a numDivisions point grid refined
+  // maxLevel times, which has to be at most MAX_RESOLUTION
+  static long long computeResolution(int numDivisions, int maxLevel);
+
+  // a gradient threshold of 0 or less only refines cells that straddle the
+  // success distance. maxLevel is lowered if the finest lattice wouldn't fit
+  // in MAX_RESOLUTION
+  AdaptiveSweep(const SweepConfig& sweepConfig, int maxLevel,
+                float successDistance, float gradientThreshold);
+
+  void run(const ShotEvaluator& evaluate);
+
+  // cells per axis of the finest lattice
+  int getResolution() { return resolution; }
+  const SweepConfig& getSweepConfig() { return sweepConfig; }
+  const std::vector<AdaptiveSample>& getSamples() { return samples; }
+  // the cells that weren't split, which together cover the whole cube
+  const std::vector<AdaptiveCell>& getLeaves() { return leaves; }
+  // shots a uniform grid with the same finest resolution would need
+  long long getNumUniformShots() {
+    return (long long)(resolution + 1) * (resolution + 1) * (resolution + 1);
+  }
+
+ private:
+  SweepConfig sweepConfig;
+  int maxLevel;
+  float successDistance;
+  float gradientThreshold;
+  int resolution;
+
+  std::vector<AdaptiveSample> samples;
+  std::vector<AdaptiveCell> leaves;
+  // sample index by lattice position
+  std::unordered_map<uint64_t, int> sampleIndices;
+  std::vector<int> pendingSamples;
+
+  uint64_t getKey(int power, int yaw, int pitch);
+  void request(int power, int yaw, int pitch);
+  void evaluatePending(const ShotEvaluator& evaluate);
+  float getDistance(int power, int yaw, int pitch);
+  bool needsRefinement(const AdaptiveCell& cell);
+};
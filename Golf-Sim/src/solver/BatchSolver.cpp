@@ -0,0 +1,149 @@
+#include "BatchSolver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+#include "ball/ShotTable.h"
+#include "solver/LiveShot.h"
+
+BatchSolver::BatchSolver(Terrain& terrain, Goal& goal, glm::vec2 startPosition,
+                         float ballRadius)
+    : ShotIntegrator(startPosition),
+      terrain(terrain),
+      goal(goal),
+      ballRadius(ballRadius) {
+  physicsWorld = physicsCommon.createPhysicsWorld();
+
+  // balls only ever touch a few chunks of a large map, so the rest are never
+  // added to this world
+  terrainPhysics = terrain.createPhysics(physicsWorld, physicsCommon, true);
+  goalPhysics = goal.createPhysics(physicsWorld, physicsCommon);
+  ballBodyPool = std::make_unique<BallBodyPool>(physicsWorld, physicsCommon,
+                                                ballShapeRegistry, ballRadius);
+
+  reactphysics3d::Vector3 gravity = physicsWorld->getGravity();
+  flightStage = std::make_unique<FlightStage>(
+      terrain, ballRadius, TIME_STEP,
+      glm::vec3(gravity.x, gravity.y, gravity.z));
+}
+
+BatchSolver::~BatchSolver() {
+  ballBodyPool.reset();
+  terrain.destroyPhysics(terrainPhysics, physicsWorld, physicsCommon);
+  goal.destroyPhysics(goalPhysics, physicsWorld, physicsCommon);
+
+  physicsCommon.destroyPhysicsWorld(physicsWorld);
+}
+
+void BatchSolver::run(const std::vector<ShotParams>& shots,
+                      const ShotSource& nextChunk, const ShotSink& onSolved,
+                      int liveBalls, float maxShotTime) {
+  glm::vec3 launchPosition =
+      getLaunchPosition(terrain, startPosition, ballRadius);
+  liveCountController.reset(liveBalls);
+  ballBodyPool->reserve(liveBalls);
+  if (prune) {
+    pruner.build(terrain, goal, ballRadius, -physicsWorld->getGravity().y);
+  }
+
+  std::deque<int> pending;
+  bool sourceEmpty = false;
+
+  // rows of finished shots are released and reused, so the table only ever
+  // holds about as many rows as there are live balls
+  ShotTable table(ballRadius);
+  std::vector<LiveShot> liveShots;
+  while (true) {
+    int target = autoTune ? liveCountController.getTarget() : liveBalls;
+
+    while (!sourceEmpty && pending.size() < target) {
+      WorkChunk chunk;
+      if (!nextChunk(chunk)) {
+        sourceEmpty = true;
+        break;
+      }
+      for (int i = chunk.begin; i < chunk.end; i++) {
+        pending.push_back(i);
+      }
+    }
+
+    while (liveShots.size() < target && !pending.empty()) {
+      int index = pending.front();
+      pending.pop_front();
+
+      int row = table.add(index, launchPosition);
+      glm::vec3 velocity =
+          getLaunchVelocity(terrain, goal, startPosition, shots[index]);
+      if (useFlightStage) {
+        table.addFlight(row, velocity);
+      } else {
+        table.addPhysics(row, *ballBodyPool);
+        table.setVelocity(row, velocity);
+      }
+      liveShots.push_back(LiveShot{row});
+    }
+
+    if (liveShots.empty()) {
+      break;
+    }
+
+    auto stepStart = std::chrono::steady_clock::now();
+    table.stepFlights(*flightStage, *ballBodyPool);
+    // nothing but the balls moves in the world, so it can be skipped while
+    // every ball is still in flight
+    if (table.getNumWithPhysics() > 0) {
+      loadTerrainChunks(table, liveShots);
+      physicsWorld->update(TIME_STEP);
+    }
+    numSteps++;
+
+    // an interpolation factor of 1 snaps the balls to the latest step
+    table.update(terrain, goal, *ballBodyPool, 1.0f);
+    std::chrono::duration<double> stepTime =
+        std::chrono::steady_clock::now() - stepStart;
+    liveCountController.record(liveShots.size(), 1, stepTime.count());
+
+    // balls in flight are cheap to step, so only the ones in the physics world
+    // are worth pruning
+    for (int i = liveShots.size() - 1; i >= 0; i--) {
+      int row = liveShots[i].row;
+      float distanceBound;
+      if (updateLiveShot(liveShots[i], table.getState(row), TIME_STEP,
+                         maxShotTime)) {
+        table.recordDistance(row, goal, terrain);
+        onSolved(table.getParamIndex(row), table.getDistance(row),
+                 table.getState(row), table.getPosition(row));
+      } else if (prune && table.hasPhysics(row) &&
+                 pruner.canPrune(table.getPosition(row), table.getVelocity(row),
+                                 table.getAngularVelocity(row),
+                                 distanceBound)) {
+        onSolved(table.getParamIndex(row), distanceBound, BallState::PRUNED,
+                 table.getPosition(row));
+      } else {
+        continue;
+      }
+
+      table.removePhysics(row, *ballBodyPool);
+      table.release(row);
+
+      liveShots[i] = liveShots.back();
+      liveShots.pop_back();
+    }
+  }
+}
+
+void BatchSolver::loadTerrainChunks(ShotTable& table,
+                                    const std::vector<LiveShot>& liveShots) {
+  // anything the ball could reach this step, plus a cell to spare
+  float spare = std::max(terrain.getHSpacing(), terrain.getVSpacing());
+  for (const LiveShot& shot : liveShots) {
+    if (!table.hasPhysics(shot.row)) continue;
+    glm::vec3 position = table.getPosition(shot.row);
+    float reach = ballRadius +
+                  glm::length(table.getVelocity(shot.row)) * TIME_STEP + spare;
+    terrain.loadChunks(terrainPhysics, physicsCommon,
+                       glm::vec2(position.x - reach, position.z - reach),
+                       glm::vec2(position.x + reach, position.z + reach));
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ball/BallBodyPool.h"
+#include "ball/BallShapeRegistry.h"
+#include "ball/FlightStage.h"
+#include "ball/ShotTable.h"
+#include "goal/Goal.h"
+#include "solver/LiveCountController.h"
+#include "solver/LiveShot.h"
+#include "solver/ShotIntegrator.h"
+#include "solver/ShotPruner.h"
+#include "solver/Sweep.h"
+#include "terrain/Terrain.h"
+
+#include <glm/glm.hpp>
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <memory>
+#include <vector>
+
+// the reactphysics3d backend: runs shots stepping its own physics world at a
+// fixed time step as fast as the CPU allows (the world gets its own copies of
+// the terrain and goal colliders, so one solver can run per thread)
+//
+// shots are pipelined: as soon as a ball finishes its distance is reported
+// and its rigid body goes back to the body pool for the next pending shot, so
+// the world always holds the target number of live balls. balls are launched
+// into a FlightStage and only get a rigid body once they are about to land
+class BatchSolver : public ShotIntegrator {
+ public:
+  const float TIME_STEP = 1.0 / 60.0f;
+
+  BatchSolver(Terrain& terrain, Goal& goal, glm::vec2 startPosition,
+              float ballRadius);
+  ~BatchSolver() override;
+
+  void run(const std::vector<ShotParams>& shots, const ShotSource& nextChunk,
+           const ShotSink& onSolved, int liveBalls,
+           float maxShotTime) override;
+
+  // when enabled, liveBalls is only the starting point and the number of live
+  // balls is tuned for the most ball steps per second while solving
+  void setAutoTune(bool autoTune) { this->autoTune = autoTune; }
+  // when disabled, balls get their rigid body as soon as they are launched
+  void setUseFlightStage(bool useFlightStage) {
+    this->useFlightStage = useFlightStage;
+  }
+  long long getNumSteps() override { return numSteps; }
+
+ private:
+  Terrain& terrain;
+  Goal& goal;
+  float ballRadius;
+
+  bool autoTune = true;
+  bool useFlightStage = true;
+  long long numSteps = 0;
+  LiveCountController liveCountController;
+  ShotPruner pruner;
+
+  reactphysics3d::PhysicsCommon physicsCommon;
+  reactphysics3d::PhysicsWorld* physicsWorld;
+  TerrainPhysics terrainPhysics;
+  GoalPhysics goalPhysics;
+  BallShapeRegistry ballShapeRegistry;
+  std::unique_ptr<BallBodyPool> ballBodyPool;
+  std::unique_ptr<FlightStage> flightStage;
+
+  // adds the terrain chunks around every ball in the physics world that this
+  // world doesn't have yet
+  void loadTerrainChunks(ShotTable& table,
+                         const std::vector<LiveShot>& liveShots);
+};
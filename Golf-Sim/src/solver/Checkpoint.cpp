@@ -0,0 +1,104 @@
+#include "Checkpoint.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "util/MappedFile.h"
+
+namespace {
+
+size_t alignTo8(size_t offset) { return (offset + 7) & ~size_t(7); }
+
+}  // namespace
+
+bool SweepCheckpoint::create(const std::string& path,
+                             const std::string& config) {
+  this->path = path;
+  this->config = config;
+  shots.clear();
+
+  CheckpointHeader header;
+  std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+  header.version = CHECKPOINT_VERSION;
+  header.configSize = config.size();
+  header.recordSize = sizeof(CheckpointShot);
+
+  std::ofstream fout(path, std::ios::binary);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fout.write(config.data(), config.size());
+  std::string padding(alignTo8(config.size()) - config.size(), '\0');
+  fout.write(padding.data(), padding.size());
+  if (!fout) {
+    std::cout << "ERROR: could not write " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool SweepCheckpoint::resume(const std::string& path) {
+  this->path = path;
+  config.clear();
+  shots.clear();
+
+  MappedFile file;
+  if (!file.openRead(path)) {
+    return false;
+  }
+  const CheckpointHeader* header =
+      reinterpret_cast<const CheckpointHeader*>(file.getData());
+  if (file.getSize() < sizeof(CheckpointHeader) ||
+      std::memcmp(header->magic, CHECKPOINT_MAGIC,
+                  sizeof(CHECKPOINT_MAGIC)) != 0 ||
+      header->recordSize != sizeof(CheckpointShot)) {
+    std::cout << "ERROR: " << path << " is not a checkpoint file"
+              << std::endl;
+    return false;
+  }
+  if (header->version != CHECKPOINT_VERSION) {
+    std::cout << "ERROR: " << path << " has unsupported version "
+              << header->version << std::endl;
+    return false;
+  }
+
+  size_t recordsOffset =
+      sizeof(CheckpointHeader) + alignTo8(header->configSize);
+  if (file.getSize() < recordsOffset) {
+    std::cout << "ERROR: " << path << " is truncated" << std::endl;
+    return false;
+  }
+  config.assign(
+      reinterpret_cast<const char*>(file.getData() + sizeof(CheckpointHeader)),
+      header->configSize);
+
+  size_t numShots = (file.getSize() - recordsOffset) / sizeof(CheckpointShot);
+  const CheckpointShot* records =
+      reinterpret_cast<const CheckpointShot*>(file.getData() + recordsOffset);
+  shots.assign(records, records + numShots);
+
+  // drop a shot that was only partly written, so appended shots line up
+  size_t validSize = recordsOffset + numShots * sizeof(CheckpointShot);
+  if (validSize != file.getSize()) {
+    file.close();
+    std::error_code error;
+    std::filesystem::resize_file(path, validSize, error);
+    if (error) {
+      std::cout << "ERROR: could not repair " << path << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SweepCheckpoint::append(const std::vector<CheckpointShot>& shots) {
+  std::ofstream fout(path, std::ios::binary | std::ios::app);
+  fout.write(reinterpret_cast<const char*>(shots.data()),
+             shots.size() * sizeof(CheckpointShot));
+  fout.flush();
+  if (!fout) {
+    std::cout << "ERROR: could not append to " << path << std::endl;
+    return false;
+  }
+  return true;
+}
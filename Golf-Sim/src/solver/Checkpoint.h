@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// checkpoint file of a long sweep: this header, the run's configuration as
+// text (padded to a multiple of 8 bytes), then a CheckpointShot for every
+// shot finished so far. shots are only ever appended in batches, so the file
+// is never rewritten, and a batch cut short by a crash only loses the shots
+// that weren't completely written
+const char CHECKPOINT_MAGIC[4] = {'G', 'C', 'K', 'P'};
+const uint32_t CHECKPOINT_VERSION = 1;
+
+struct CheckpointHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t configSize;
+  uint32_t recordSize;
+};
+static_assert(sizeof(CheckpointHeader) == 16,
+              "checkpoint header must be 16 bytes");
+
+struct CheckpointShot {
+  // index of the shot in the sweep
+  uint32_t index;
+  float distance;
+  uint8_t state;
+  uint8_t padding[3];
+};
+static_assert(sizeof(CheckpointShot) == 12,
+              "checkpoint record must be 12 bytes");
+
+class SweepCheckpoint {
+ public:
+  // starts a new checkpoint file (replacing any existing one) for a run with
+  // the given configuration
+  bool create(const std::string& path, const std::string& config);
+  // reads an existing checkpoint file's configuration and finished shots,
+  // after which more shots can be appended to it
+  bool resume(const std::string& path);
+  // appends a batch of finished shots and flushes it to disk
+  bool append(const std::vector<CheckpointShot>& shots);
+
+  const std::string& getConfig() { return config; }
+  // every shot in the file when it was resumed (none for new files)
+  const std::vector<CheckpointShot>& getShots() { return shots; }
+
+ private:
+  std::string path;
+  std::string config;
+  std::vector<CheckpointShot> shots;
+};
@@ -0,0 +1,333 @@
+#include "HeightFieldIntegrator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+#include "goal/Goal.h"
+#include "terrain/Terrain.h"
+#include "util/Geometry.h"
+
+HeightFieldIntegrator::HeightFieldIntegrator(Terrain& terrain, Goal& goal,
+                                             glm::vec2 startPosition,
+                                             float ballRadius)
+    : ShotIntegrator(startPosition),
+      terrain(terrain),
+      goal(goal),
+      ballRadius(ballRadius) {}
+
+void HeightFieldIntegrator::run(const std::vector<ShotParams>& shots,
+                                const ShotSource& nextChunk,
+                                const ShotSink& onSolved, int liveBalls,
+                                float maxShotTime) {
+  glm::vec3 launchPosition =
+      getLaunchPosition(terrain, startPosition, ballRadius);
+  surfaceTop = terrain.getPosition().y + terrain.getMaxHeight();
+  outOfBoundsHeight = terrain.getPosition().y + terrain.getMinHeight();
+  goalPos = goal.getAbsolutePosition(terrain);
+  goalBottom = goal.getBottomHeight();
+  if (prune) {
+    pruner.build(terrain, goal, ballRadius, -GRAVITY.y);
+  }
+
+  liveBalls = std::max(1, liveBalls);
+  reserve(liveBalls);
+
+  std::deque<int> pending;
+  bool sourceEmpty = false;
+  while (true) {
+    while (!sourceEmpty && pending.size() < liveBalls) {
+      WorkChunk chunk;
+      if (!nextChunk(chunk)) {
+        sourceEmpty = true;
+        break;
+      }
+      for (int i = chunk.begin; i < chunk.end; i++) {
+        pending.push_back(i);
+      }
+    }
+
+    while (numLive < liveBalls && !pending.empty()) {
+      int index = pending.front();
+      pending.pop_front();
+      launch(index, launchPosition,
+             getLaunchVelocity(terrain, goal, startPosition, shots[index]));
+    }
+
+    if (numLive == 0) {
+      break;
+    }
+
+    // same order as a physics world step: contacts are found at the current
+    // positions, then velocities are integrated and corrected by the contacts,
+    // and finally positions are integrated
+    integrateVelocities();
+    for (int lane = 0; lane < numLive; lane++) {
+      if (touching[lane]) {
+        collide(lane);
+      }
+    }
+    integratePositions();
+    numSteps++;
+
+    for (int lane = numLive - 1; lane >= 0; lane--) {
+      BallState state = getState(lane);
+      glm::vec3 position(px[lane], py[lane], pz[lane]);
+      float distanceBound;
+      if (updateLiveShot(liveShots[lane], state, TIME_STEP, maxShotTime)) {
+        onSolved(liveShots[lane].row,
+                 glm::length(goalPos - glm::vec2(position.x, position.z)),
+                 state, position);
+      } else if (prune &&
+                 pruner.canPrune(position,
+                                 glm::vec3(vx[lane], vy[lane], vz[lane]),
+                                 glm::vec3(wx[lane], wy[lane], wz[lane]),
+                                 distanceBound)) {
+        onSolved(liveShots[lane].row, distanceBound, BallState::PRUNED,
+                 position);
+      } else {
+        continue;
+      }
+      remove(lane);
+    }
+  }
+}
+
+void HeightFieldIntegrator::reserve(int numBalls) {
+  int capacity = (numBalls + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH;
+  if (capacity <= px.size()) return;
+
+  for (std::vector<float>* field :
+       {&px, &py, &pz, &vx, &vy, &vz, &wx, &wy, &wz}) {
+    field->resize(capacity, 0.0f);
+  }
+  touching.resize(capacity, false);
+  liveShots.reserve(numBalls);
+}
+
+void HeightFieldIntegrator::launch(int index, glm::vec3 position,
+                                   glm::vec3 velocity) {
+  reserve(numLive + 1);
+
+  int lane = numLive++;
+  px[lane] = position.x;
+  py[lane] = position.y;
+  pz[lane] = position.z;
+  vx[lane] = velocity.x;
+  vy[lane] = velocity.y;
+  vz[lane] = velocity.z;
+  wx[lane] = 0;
+  wy[lane] = 0;
+  wz[lane] = 0;
+  touching[lane] = true;
+  liveShots.push_back(LiveShot{index});
+}
+
+void HeightFieldIntegrator::remove(int lane) {
+  // move the last live ball into the lane
+  int last = --numLive;
+  for (std::vector<float>* field :
+       {&px, &py, &pz, &vx, &vy, &vz, &wx, &wy, &wz}) {
+    (*field)[lane] = (*field)[last];
+    (*field)[last] = 0;
+  }
+  touching[lane] = touching[last];
+  liveShots[lane] = liveShots.back();
+  liveShots.pop_back();
+}
+
+void HeightFieldIntegrator::integrateVelocities() {
+  float damping = 1.0f / (1.0f + Ball::LINEAR_DAMPING * TIME_STEP);
+  int numLanes = (numLive + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH;
+  for (int group = 0; group < numLanes; group += LANE_WIDTH) {
+    for (int lane = group; lane < group + LANE_WIDTH; lane++) {
+      vx[lane] = (vx[lane] + GRAVITY.x * TIME_STEP) * damping;
+      vy[lane] = (vy[lane] + GRAVITY.y * TIME_STEP) * damping;
+      vz[lane] = (vz[lane] + GRAVITY.z * TIME_STEP) * damping;
+    }
+  }
+}
+
+void HeightFieldIntegrator::integratePositions() {
+  // a ball can only touch something once its bottom is below the highest
+  // point of the terrain (the goal's cup is always below the terrain)
+  float touchHeight = surfaceTop + ballRadius;
+  int numLanes = (numLive + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH;
+  for (int group = 0; group < numLanes; group += LANE_WIDTH) {
+    for (int lane = group; lane < group + LANE_WIDTH; lane++) {
+      px[lane] += vx[lane] * TIME_STEP;
+      py[lane] += vy[lane] * TIME_STEP;
+      pz[lane] += vz[lane] * TIME_STEP;
+      touching[lane] = py[lane] < touchHeight;
+    }
+  }
+}
+
+void HeightFieldIntegrator::collide(int lane) {
+  glm::vec3 normal;
+  float depth;
+  if (!findContact(glm::vec3(px[lane], py[lane], pz[lane]), normal, depth)) {
+    return;
+  }
+
+  // push the ball out of whatever it is touching
+  px[lane] += normal.x * depth;
+  py[lane] += normal.y * depth;
+  pz[lane] += normal.z * depth;
+
+  glm::vec3 v(vx[lane], vy[lane], vz[lane]);
+  glm::vec3 w(wx[lane], wy[lane], wz[lane]);
+  float normalSpeed = glm::dot(v, normal);
+  if (normalSpeed >= 0) {
+    return;
+  }
+
+  float restitution =
+      normalSpeed < -RESTITUTION_THRESHOLD ? Ball::BOUNCINESS : 0.0f;
+  float normalImpulse = -(1 + restitution) * normalSpeed;
+  v += normal * normalImpulse;
+
+  // friction stops the contact point from slipping, up to the friction cone.
+  // for a solid sphere of unit mass (I = 2/5 r^2) an impulse j against the
+  // slip changes the slip speed by 3.5 j
+  glm::vec3 arm = -normal * ballRadius;
+  glm::vec3 contactVelocity = v + glm::cross(w, arm);
+  glm::vec3 slip =
+      contactVelocity - normal * glm::dot(contactVelocity, normal);
+  float slipSpeed = glm::length(slip);
+  if (slipSpeed > 1e-6f) {
+    glm::vec3 frictionImpulse =
+        -slip / slipSpeed *
+        std::min(slipSpeed / 3.5f, Ball::FRICTION * normalImpulse);
+    v += frictionImpulse;
+    w += glm::cross(arm, frictionImpulse) / (0.4f * ballRadius * ballRadius);
+  }
+
+  vx[lane] = v.x;
+  vy[lane] = v.y;
+  vz[lane] = v.z;
+  wx[lane] = w.x;
+  wy[lane] = w.y;
+  wz[lane] = w.z;
+}
+
+bool HeightFieldIntegrator::findContact(glm::vec3 position, glm::vec3& normal,
+                                        float& depth) {
+  bool found = false;
+  depth = 0;
+
+  glm::vec3 terrainPos = terrain.getPosition();
+  float left = terrainPos.x - terrain.getWidth() / 2;
+  float bottom = terrainPos.z - terrain.getHeight() / 2;
+  glm::vec2 rel(position.x - left, position.z - bottom);
+  bool inMap = rel.x >= 0 && rel.x <= terrain.getWidth() && rel.y >= 0 &&
+               rel.y <= terrain.getHeight();
+
+  float goalDx = position.x - goalPos.x;
+  float goalDz = position.z - goalPos.y;
+  float goalDist = std::sqrt(goalDx * goalDx + goalDz * goalDz);
+  float goalRadius = goal.getRadius();
+
+  // inside the cup only the walls and the bottom can be touched
+  if (inMap && goalDist < goalRadius &&
+      position.y < terrainPos.y + terrain.getHeightFromRelative(rel)) {
+    float wallDepth = goalDist + ballRadius - goalRadius;
+    if (wallDepth > depth && goalDist > 1e-6f) {
+      normal = glm::vec3(-goalDx, 0, -goalDz) / goalDist;
+      depth = wallDepth;
+      found = true;
+    }
+    float bottomDepth = goalBottom + ballRadius - position.y;
+    if (bottomDepth > depth) {
+      normal = glm::vec3(0, 1, 0);
+      depth = bottomDepth;
+      found = true;
+    }
+    return found;
+  }
+
+  // the deepest contact wins, since neighbouring triangles usually report the
+  // same contact through their shared edge
+  auto addContact = [&](glm::vec3 closest) {
+    glm::vec3 offset = position - closest;
+    float distSq = glm::dot(offset, offset);
+    if (distSq >= ballRadius * ballRadius) return;
+
+    float dist = std::sqrt(distSq);
+    if (ballRadius - dist > depth) {
+      depth = ballRadius - dist;
+      normal = dist > 1e-6f ? offset / dist : glm::vec3(0, 1, 0);
+      found = true;
+    }
+  };
+  auto inCup = [&](glm::vec3 point) {
+    float dx = point.x - goalPos.x;
+    float dz = point.z - goalPos.y;
+    return dx * dx + dz * dz < goalRadius * goalRadius;
+  };
+
+  float hSpacing = terrain.getHSpacing();
+  float vSpacing = terrain.getVSpacing();
+  int colStart = std::max(
+      0, static_cast<int>(std::floor((rel.x - ballRadius) / hSpacing)));
+  int colEnd = std::min(
+      terrain.getNumCols(),
+      static_cast<int>(std::floor((rel.x + ballRadius) / hSpacing)) + 1);
+  int rowStart = std::max(
+      0, static_cast<int>(std::floor((rel.y - ballRadius) / vSpacing)));
+  int rowEnd = std::min(
+      terrain.getNumRows(),
+      static_cast<int>(std::floor((rel.y + ballRadius) / vSpacing)) + 1);
+
+  for (int row = rowStart; row < rowEnd; row++) {
+    for (int col = colStart; col < colEnd; col++) {
+      glm::vec3 botLeft = terrain.getVertexPosition(col, row);
+      glm::vec3 botRight = terrain.getVertexPosition(col + 1, row);
+      glm::vec3 topLeft = terrain.getVertexPosition(col, row + 1);
+      glm::vec3 topRight = terrain.getVertexPosition(col + 1, row + 1);
+
+      // same diagonal as the physics height field, and nothing where the cup
+      // is cut out of the terrain
+      glm::vec3 closest0 =
+          closestPointOnTriangle(position, botLeft, botRight, topLeft);
+      glm::vec3 closest1 =
+          closestPointOnTriangle(position, botRight, topRight, topLeft);
+      if (!inCup(closest0)) addContact(closest0);
+      if (!inCup(closest1)) addContact(closest1);
+    }
+  }
+
+  // the rim of the cup
+  if (goalDist > 1e-6f && std::abs(goalDist - goalRadius) < ballRadius) {
+    glm::vec2 rimPos =
+        goalPos + glm::vec2(goalDx, goalDz) / goalDist * goalRadius;
+    glm::vec2 rimRel(rimPos.x - left, rimPos.y - bottom);
+    addContact(glm::vec3(
+        rimPos.x, terrainPos.y + terrain.getHeightFromRelative(rimRel),
+        rimPos.y));
+  }
+
+  return found;
+}
+
+BallState HeightFieldIntegrator::getState(int lane) {
+  if (py[lane] < outOfBoundsHeight) {
+    return BallState::OUT_OF_BOUNDS;
+  }
+
+  float speedSq =
+      vx[lane] * vx[lane] + vy[lane] * vy[lane] + vz[lane] * vz[lane];
+  if (speedSq >= 0.05f) {
+    return BallState::ACTIVE;
+  }
+
+  // same test Ball uses for coming to rest in the goal
+  float goalDx = px[lane] - goalPos.x;
+  float goalDz = pz[lane] - goalPos.y;
+  float nearRadius = goal.getRadius() + ballRadius;
+  if (goalDx * goalDx + goalDz * goalDz < nearRadius * nearRadius &&
+      std::abs(py[lane] - ballRadius - goalBottom) < 0.2f) {
+    return BallState::GOAL;
+  }
+  return BallState::STATIONARY;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ball/Ball.h"
+#include "solver/LiveShot.h"
+#include "solver/ShotIntegrator.h"
+#include "solver/ShotPruner.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class Terrain;
+class Goal;
+
+// the height field backend: instead of a general purpose physics engine, it
+// only knows about the two things a shot can ever touch, the terrain's height
+// map (using the same triangles as the physics height field) and the goal's
+// cup (a vertical cylinder with a flat bottom cut into the terrain)
+//
+// live balls are stored as separate arrays padded to a multiple of
+// LANE_WIDTH, and the integration and the test for whether a ball is close
+// enough to the terrain to touch it run over whole lane groups so that the
+// compiler can vectorize them. only the balls that pass that test look up
+// their contacts
+//
+// each contact is resolved with a single impulse per step, using Ball's
+// bounciness, friction and damping on a solid sphere, so results are close to
+// but not the same as reactphysics3d's iterative solver
+class HeightFieldIntegrator : public ShotIntegrator {
+ public:
+  static const int LANE_WIDTH = 8;
+  const float TIME_STEP = 1.0 / 60.0f;
+  // default gravity of a reactphysics3d world
+  const glm::vec3 GRAVITY = glm::vec3(0.0f, -9.81f, 0.0f);
+  // contacts that close slower than this don't bounce (reactphysics3d's
+  // default restitution velocity threshold)
+  const float RESTITUTION_THRESHOLD = 0.5f;
+
+  HeightFieldIntegrator(Terrain& terrain, Goal& goal, glm::vec2 startPosition,
+                        float ballRadius);
+
+  void run(const std::vector<ShotParams>& shots, const ShotSource& nextChunk,
+           const ShotSink& onSolved, int liveBalls,
+           float maxShotTime) override;
+
+  long long getNumSteps() override { return numSteps; }
+
+ private:
+  Terrain& terrain;
+  Goal& goal;
+  float ballRadius;
+  long long numSteps = 0;
+
+  // read from the terrain and goal at the start of each run
+  float surfaceTop;
+  float outOfBoundsHeight;
+  glm::vec2 goalPos;
+  float goalBottom;
+  ShotPruner pruner;
+
+  // per live ball, padded to a multiple of LANE_WIDTH (the padding lanes are
+  // integrated too but never collided or retired)
+  std::vector<float> px, py, pz;
+  std::vector<float> vx, vy, vz;
+  std::vector<float> wx, wy, wz;
+  std::vector<uint8_t> touching;
+  int numLive = 0;
+  // the row of each live shot is its index in the sweep
+  std::vector<LiveShot> liveShots;
+
+  void reserve(int numBalls);
+  void launch(int index, glm::vec3 position, glm::vec3 velocity);
+  void remove(int lane);
+
+  void integrateVelocities();
+  void integratePositions();
+  void collide(int lane);
+  bool findContact(glm::vec3 position, glm::vec3& normal, float& depth);
+  BallState getState(int lane);
+};
@@ -0,0 +1,491 @@
+#include "InverseSolver.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include "ball/Ball.h"
+#include "solver/Sampling.h"
+
+namespace {
+
+const int DIMENSIONS = 3;
+// a search whose steps have shrunk below this has converged
+const float MIN_STEP = 1e-4f;
+
+glm::vec3 clampToUnit(glm::vec3 point) {
+  return glm::clamp(point, glm::vec3(0.0f), glm::vec3(1.0f));
+}
+
+// eigenvectors (the columns of vectors) and eigenvalues of a symmetric matrix,
+// found with jacobi rotations
+void decomposeSymmetric(const double matrix[3][3], double vectors[3][3],
+                        double values[3]) {
+  double a[3][3];
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      a[i][j] = matrix[i][j];
+      vectors[i][j] = i == j ? 1 : 0;
+    }
+  }
+
+  for (int sweep = 0; sweep < 50; sweep++) {
+    double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] +
+                         a[1][2] * a[1][2];
+    if (offDiagonal < 1e-30) break;
+
+    for (int p = 0; p < 2; p++) {
+      for (int q = p + 1; q < 3; q++) {
+        if (std::abs(a[p][q]) < 1e-30) continue;
+
+        double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        double t = (theta >= 0 ? 1 : -1) /
+                   (std::abs(theta) + std::sqrt(theta * theta + 1));
+        double c = 1 / std::sqrt(t * t + 1);
+        double s = t * c;
+
+        for (int k = 0; k < 3; k++) {
+          double akp = a[k][p], akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < 3; k++) {
+          double apk = a[p][k], aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (int k = 0; k < 3; k++) {
+          double vkp = vectors[k][p], vkq = vectors[k][q];
+          vectors[k][p] = c * vkp - s * vkq;
+          vectors[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < 3; i++) values[i] = a[i][i];
+}
+
+// covariance matrix adaptation evolution strategy (Hansen's tutorial version)
+class CmaEsSearch : public InverseSearch {
+ public:
+  CmaEsSearch(int populationSize, uint32_t seed)
+      : lambda(std::max(4, populationSize)), random(seed) {
+    mu = lambda / 2;
+    weights.resize(mu);
+    double sum = 0;
+    for (int i = 0; i < mu; i++) {
+      weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+      sum += weights[i];
+    }
+    double sumSquares = 0;
+    for (double& w : weights) {
+      w /= sum;
+      sumSquares += w * w;
+    }
+    muEff = 1 / sumSquares;
+
+    const double n = DIMENSIONS;
+    cc = (4 + muEff / n) / (n + 4 + 2 * muEff / n);
+    cs = (muEff + 2) / (n + muEff + 5);
+    c1 = 2 / ((n + 1.3) * (n + 1.3) + muEff);
+    cmu = std::min(1 - c1, 2 * (muEff - 2 + 1 / muEff) /
+                               ((n + 2) * (n + 2) + muEff));
+    damps = 1 + 2 * std::max(0.0, std::sqrt((muEff - 1) / (n + 1)) - 1) + cs;
+    chiN = std::sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+  }
+
+  void start(glm::vec3 point, float step) override {
+    for (int i = 0; i < DIMENSIONS; i++) {
+      mean[i] = point[i];
+      pc[i] = 0;
+      ps[i] = 0;
+      scales[i] = 1;
+      for (int j = 0; j < DIMENSIONS; j++) {
+        covariance[i][j] = i == j ? 1 : 0;
+        basis[i][j] = i == j ? 1 : 0;
+      }
+    }
+    sigma = step;
+    generation = 0;
+  }
+
+  void ask(std::vector<glm::vec3>& points) override {
+    std::normal_distribution<double> normal;
+    candidates.resize(lambda);
+    for (glm::vec3& candidate : candidates) {
+      double z[DIMENSIONS];
+      for (double& value : z) value = normal(random);
+      for (int k = 0; k < DIMENSIONS; k++) {
+        double y = 0;
+        for (int p = 0; p < DIMENSIONS; p++) {
+          y += basis[k][p] * scales[p] * z[p];
+        }
+        candidate[k] = static_cast<float>(mean[k] + sigma * y);
+      }
+      // shots outside of the ranges are moved onto their edge, and the search
+      // learns from where they were actually simulated
+      candidate = clampToUnit(candidate);
+      points.push_back(candidate);
+    }
+  }
+
+  void tell(const float* distances) override {
+    std::vector<int> order(lambda);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return distances[a] < distances[b]; });
+
+    double oldMean[DIMENSIONS];
+    std::copy(mean, mean + DIMENSIONS, oldMean);
+    std::vector<std::array<double, DIMENSIONS>> steps(mu);
+    double meanStep[DIMENSIONS] = {0, 0, 0};
+    for (int i = 0; i < mu; i++) {
+      for (int k = 0; k < DIMENSIONS; k++) {
+        steps[i][k] = (candidates[order[i]][k] - oldMean[k]) / sigma;
+        meanStep[k] += weights[i] * steps[i][k];
+      }
+    }
+    for (int k = 0; k < DIMENSIONS; k++) {
+      mean[k] = oldMean[k] + sigma * meanStep[k];
+    }
+
+    // C^-1/2 * meanStep = B * D^-1 * B^T * meanStep
+    double whitened[DIMENSIONS];
+    for (int p = 0; p < DIMENSIONS; p++) {
+      double projected = 0;
+      for (int k = 0; k < DIMENSIONS; k++) {
+        projected += basis[k][p] * meanStep[k];
+      }
+      whitened[p] = projected / scales[p];
+    }
+    double psLength = 0;
+    for (int k = 0; k < DIMENSIONS; k++) {
+      double rotated = 0;
+      for (int p = 0; p < DIMENSIONS; p++) {
+        rotated += basis[k][p] * whitened[p];
+      }
+      ps[k] = (1 - cs) * ps[k] + std::sqrt(cs * (2 - cs) * muEff) * rotated;
+      psLength += ps[k] * ps[k];
+    }
+    psLength = std::sqrt(psLength);
+
+    generation++;
+    bool hsig = psLength /
+                    std::sqrt(1 - std::pow(1 - cs, 2.0 * generation)) /
+                    chiN <
+                1.4 + 2.0 / (DIMENSIONS + 1);
+    for (int k = 0; k < DIMENSIONS; k++) {
+      pc[k] = (1 - cc) * pc[k] +
+              (hsig ? std::sqrt(cc * (2 - cc) * muEff) : 0) * meanStep[k];
+    }
+
+    for (int i = 0; i < DIMENSIONS; i++) {
+      for (int j = 0; j < DIMENSIONS; j++) {
+        double rankMu = 0;
+        for (int s = 0; s < mu; s++) {
+          rankMu += weights[s] * steps[s][i] * steps[s][j];
+        }
+        covariance[i][j] =
+            (1 - c1 - cmu) * covariance[i][j] +
+            c1 * (pc[i] * pc[j] +
+                  (hsig ? 0 : cc * (2 - cc)) * covariance[i][j]) +
+            cmu * rankMu;
+      }
+    }
+    sigma *= std::exp((cs / damps) * (psLength / chiN - 1));
+
+    double values[DIMENSIONS];
+    decomposeSymmetric(covariance, basis, values);
+    for (int p = 0; p < DIMENSIONS; p++) {
+      scales[p] = std::sqrt(std::max(values[p], 1e-20));
+    }
+  }
+
+  bool isConverged() override {
+    double maxScale = *std::max_element(scales, scales + DIMENSIONS);
+    return !std::isfinite(sigma) || sigma * maxScale < MIN_STEP;
+  }
+
+ private:
+  int lambda;
+  int mu;
+  std::vector<double> weights;
+  double muEff, cc, cs, c1, cmu, damps, chiN;
+  std::mt19937 random;
+
+  double mean[DIMENSIONS];
+  double sigma;
+  double covariance[DIMENSIONS][DIMENSIONS];
+  // eigenvectors (columns) and the square roots of the eigenvalues of the
+  // covariance matrix
+  double basis[DIMENSIONS][DIMENSIONS];
+  double scales[DIMENSIONS];
+  double pc[DIMENSIONS];
+  double ps[DIMENSIONS];
+  int generation;
+
+  std::vector<glm::vec3> candidates;
+};
+
+// nelder-mead simplex, asking for one step at a time (or the whole simplex
+// when it starts or shrinks)
+class NelderMeadSearch : public InverseSearch {
+ public:
+  void start(glm::vec3 point, float step) override {
+    vertices[0] = clampToUnit(point);
+    for (int i = 0; i < DIMENSIONS; i++) {
+      glm::vec3 vertex = point;
+      // step away from the nearest edge so the simplex isn't flattened
+      vertex[i] += point[i] + step <= 1.0f ? step : -step;
+      vertices[i + 1] = clampToUnit(vertex);
+    }
+    phase = Phase::EVALUATE_ALL;
+  }
+
+  void ask(std::vector<glm::vec3>& points) override {
+    pending.clear();
+    if (phase == Phase::EVALUATE_ALL) {
+      pending.assign(vertices, vertices + DIMENSIONS + 1);
+    } else if (phase == Phase::SHRINK) {
+      for (int i = 1; i <= DIMENSIONS; i++) {
+        vertices[i] = vertices[0] + 0.5f * (vertices[i] - vertices[0]);
+        pending.push_back(vertices[i]);
+      }
+    } else {
+      glm::vec3 centroid(0.0f);
+      for (int i = 0; i < DIMENSIONS; i++) centroid += vertices[i];
+      centroid /= DIMENSIONS;
+      glm::vec3 worst = vertices[DIMENSIONS];
+
+      float scale = 1.0f;
+      if (phase == Phase::EXPAND) {
+        scale = 2.0f;
+      } else if (phase == Phase::CONTRACT_OUTSIDE) {
+        scale = 0.5f;
+      } else if (phase == Phase::CONTRACT_INSIDE) {
+        scale = -0.5f;
+      }
+      pending.push_back(clampToUnit(centroid + scale * (centroid - worst)));
+    }
+    points.insert(points.end(), pending.begin(), pending.end());
+  }
+
+  void tell(const float* distances) override {
+    switch (phase) {
+      case Phase::EVALUATE_ALL:
+        for (int i = 0; i <= DIMENSIONS; i++) values[i] = distances[i];
+        sortVertices();
+        phase = Phase::REFLECT;
+        break;
+      case Phase::SHRINK:
+        for (int i = 1; i <= DIMENSIONS; i++) values[i] = distances[i - 1];
+        sortVertices();
+        phase = Phase::REFLECT;
+        break;
+      case Phase::REFLECT:
+        reflected = pending[0];
+        reflectedValue = distances[0];
+        if (reflectedValue < values[0]) {
+          phase = Phase::EXPAND;
+        } else if (reflectedValue < values[DIMENSIONS - 1]) {
+          replaceWorst(reflected, reflectedValue);
+        } else if (reflectedValue < values[DIMENSIONS]) {
+          phase = Phase::CONTRACT_OUTSIDE;
+        } else {
+          phase = Phase::CONTRACT_INSIDE;
+        }
+        break;
+      case Phase::EXPAND:
+        if (distances[0] < reflectedValue) {
+          replaceWorst(pending[0], distances[0]);
+        } else {
+          replaceWorst(reflected, reflectedValue);
+        }
+        break;
+      case Phase::CONTRACT_OUTSIDE:
+      case Phase::CONTRACT_INSIDE:
+        if (distances[0] < std::min(reflectedValue, values[DIMENSIONS])) {
+          replaceWorst(pending[0], distances[0]);
+        } else {
+          phase = Phase::SHRINK;
+        }
+        break;
+    }
+  }
+
+  bool isConverged() override {
+    float size = 0;
+    for (int i = 1; i <= DIMENSIONS; i++) {
+      size = std::max(size, glm::length(vertices[i] - vertices[0]));
+    }
+    return size < MIN_STEP;
+  }
+
+ private:
+  enum class Phase {
+    EVALUATE_ALL,
+    REFLECT,
+    EXPAND,
+    CONTRACT_OUTSIDE,
+    CONTRACT_INSIDE,
+    SHRINK
+  };
+
+  // sorted from best to worst after every step
+  glm::vec3 vertices[DIMENSIONS + 1];
+  float values[DIMENSIONS + 1];
+  Phase phase = Phase::EVALUATE_ALL;
+  std::vector<glm::vec3> pending;
+  glm::vec3 reflected;
+  float reflectedValue;
+
+  void replaceWorst(glm::vec3 vertex, float value) {
+    vertices[DIMENSIONS] = vertex;
+    values[DIMENSIONS] = value;
+    sortVertices();
+    phase = Phase::REFLECT;
+  }
+
+  void sortVertices() {
+    for (int i = 1; i <= DIMENSIONS; i++) {
+      for (int j = i; j > 0 && values[j] < values[j - 1]; j--) {
+        std::swap(values[j], values[j - 1]);
+        std::swap(vertices[j], vertices[j - 1]);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+const char* getInverseMethodName(InverseMethod method) {
+  switch (method) {
+    case InverseMethod::CMA_ES:
+      return "cmaes";
+    case InverseMethod::NELDER_MEAD:
+      return "neldermead";
+  }
+  return "";
+}
+
+bool parseInverseMethod(const std::string& name, InverseMethod& method) {
+  for (InverseMethod candidate :
+       {InverseMethod::CMA_ES, InverseMethod::NELDER_MEAD}) {
+    if (name == getInverseMethodName(candidate)) {
+      method = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+InverseSolver::InverseSolver(const SweepConfig& sweepConfig,
+                             const InverseConfig& inverseConfig)
+    : sweepConfig(sweepConfig), inverseConfig(inverseConfig) {}
+
+InverseResult InverseSolver::run(const ShotEvaluator& evaluate) {
+  InverseResult result;
+  result.bestDistance = INFINITY;
+  std::vector<glm::vec3> holedPoints;
+
+  searches.clear();
+  iterations.clear();
+  nextStart = 0;
+  numSimulations = 0;
+  for (int i = 0; i < std::max(1, inverseConfig.numSearches); i++) {
+    if (inverseConfig.method == InverseMethod::CMA_ES) {
+      searches.push_back(std::make_unique<CmaEsSearch>(
+          inverseConfig.populationSize, inverseConfig.seed * 7919u + i));
+    } else {
+      searches.push_back(std::make_unique<NelderMeadSearch>());
+    }
+    iterations.push_back(0);
+    restart(i);
+  }
+
+  std::vector<glm::vec3> points;
+  std::vector<int> firstPoints;
+  std::vector<ShotParams> shots;
+  std::vector<float> distances;
+  std::vector<uint8_t> states;
+  while (holedPoints.size() < inverseConfig.targetShots && !cancelled) {
+    points.clear();
+    firstPoints.clear();
+    for (auto& search : searches) {
+      firstPoints.push_back(points.size());
+      search->ask(points);
+    }
+    firstPoints.push_back(points.size());
+    if (result.numSimulations + points.size() > inverseConfig.maxSimulations) {
+      break;
+    }
+
+    shots.clear();
+    for (const glm::vec3& point : points) {
+      shots.push_back(getShotParams(point));
+    }
+    evaluate(shots, distances, states);
+    result.numSimulations += shots.size();
+    result.numBatches++;
+    numSimulations = result.numSimulations;
+
+    for (int i = 0; i < searches.size(); i++) {
+      bool holed = false;
+      for (int j = firstPoints[i]; j < firstPoints[i + 1]; j++) {
+        if (distances[j] < result.bestDistance) {
+          result.bestDistance = distances[j];
+          result.bestShot = shots[j];
+        }
+        if (states[j] != static_cast<uint8_t>(BallState::GOAL)) continue;
+
+        holed = true;
+        if (isNewShot(points[j], holedPoints)) {
+          holedPoints.push_back(points[j]);
+          result.holedShots.push_back(shots[j]);
+          result.holedDistances.push_back(distances[j]);
+        }
+      }
+
+      searches[i]->tell(distances.data() + firstPoints[i]);
+      iterations[i]++;
+      // a search that holed out starts over somewhere else to find a
+      // different shot
+      if (holed || searches[i]->isConverged() ||
+          iterations[i] >= inverseConfig.maxIterations) {
+        restart(i);
+      }
+    }
+  }
+
+  return result;
+}
+
+void InverseSolver::restart(int search) {
+  // start points are spread over the whole parameter space, and never the
+  // same from one restart to the next
+  glm::vec3 start = getSobolPoint(nextStart++, inverseConfig.seed);
+  searches[search]->start(start, inverseConfig.initialStep);
+  iterations[search] = 0;
+}
+
+ShotParams InverseSolver::getShotParams(glm::vec3 point) {
+  return ShotParams{
+      sweepConfig.minPower + (sweepConfig.maxPower - sweepConfig.minPower) *
+                                 point.x,
+      sweepConfig.minYaw + (sweepConfig.maxYaw - sweepConfig.minYaw) * point.y,
+      sweepConfig.minPitch + (sweepConfig.maxPitch - sweepConfig.minPitch) *
+                                 point.z};
+}
+
+bool InverseSolver::isNewShot(glm::vec3 point,
+                              const std::vector<glm::vec3>& holedPoints) {
+  for (const glm::vec3& holed : holedPoints) {
+    if (glm::length(point - holed) < inverseConfig.minSeparation) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "solver/Sweep.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// derivative-free optimizer used by each search of an InverseSolver
+enum class InverseMethod { CMA_ES, NELDER_MEAD };
+
+const char* getInverseMethodName(InverseMethod method);
+// returns false if the name isn't one of getInverseMethodName's
+bool parseInverseMethod(const std::string& name, InverseMethod& method);
+
+struct InverseConfig {
+  InverseMethod method = InverseMethod::CMA_ES;
+  // independent searches run side by side, so that every batch has enough
+  // shots to keep all of the solver threads busy
+  int numSearches = 8;
+  // shots per generation of each CMA-ES search
+  int populationSize = 12;
+  // stop once this many different shots have gone in
+  int targetShots = 5;
+  // stop once this many shots have been simulated
+  int maxSimulations = 5000;
+  // holed shots closer than this to one found before (in parameter ranges
+  // scaled to 0 - 1) are treated as the same shot
+  float minSeparation = 0.02f;
+  // step size a search starts with, in parameter ranges scaled to 0 - 1
+  float initialStep = 0.15f;
+  // a search that hasn't holed out after this many batches starts over
+  int maxIterations = 60;
+  uint32_t seed = 0;
+};
+
+struct InverseResult {
+  std::vector<ShotParams> holedShots;
+  std::vector<float> holedDistances;
+  // closest shot found, holed or not
+  ShotParams bestShot = ShotParams{0, 0, 0};
+  float bestDistance = 0;
+  int numSimulations = 0;
+  int numBatches = 0;
+};
+
+// one optimizer run, asked for the shots it wants simulated next and then told
+// their distances. points are in the parameter ranges scaled to 0 - 1
+class InverseSearch {
+ public:
+  virtual ~InverseSearch() = default;
+
+  virtual void start(glm::vec3 point, float step) = 0;
+  virtual void ask(std::vector<glm::vec3>& points) = 0;
+  // distances of the points from the last ask, in the same order
+  virtual void tell(const float* distances) = 0;
+  virtual bool isConverged() = 0;
+};
+
+// finds shots that go in by treating the final distance from the goal as a
+// black box function of power, yaw and pitch and minimizing it, instead of
+// simulating every shot of a sweep. every search starts from the next point of
+// a sobol sequence over the sweep's ranges and starts over from a new one once
+// it holes out or converges; the shots all of the searches ask for are
+// simulated together as one batch, so they run in parallel across the solver's
+// physics worlds
+class InverseSolver {
+ public:
+  // only the ranges of the sweep config are used
+  InverseSolver(const SweepConfig& sweepConfig,
+                const InverseConfig& inverseConfig);
+
+  InverseResult run(const ShotEvaluator& evaluate);
+  // stops run before its next batch; safe to call from any thread
+  void cancel() { cancelled = true; }
+  // shots simulated so far by run, safe to call from any thread
+  int getNumSimulations() { return numSimulations; }
+
+ private:
+  SweepConfig sweepConfig;
+  InverseConfig inverseConfig;
+  std::vector<std::unique_ptr<InverseSearch>> searches;
+  std::vector<int> iterations;
+  uint32_t nextStart = 0;
+  std::atomic<bool> cancelled{false};
+  std::atomic<int> numSimulations{0};
+
+  void restart(int search);
+  ShotParams getShotParams(glm::vec3 point);
+  bool isNewShot(glm::vec3 point, const std::vector<glm::vec3>& holedPoints);
+};
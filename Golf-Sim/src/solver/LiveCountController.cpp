@@ -0,0 +1,45 @@
+#include "LiveCountController.h"
+
+#include <algorithm>
+
+LiveCountController::LiveCountController(int initialTarget, int minTarget,
+                                         int maxTarget)
+    : minTarget(minTarget), maxTarget(maxTarget) {
+  reset(initialTarget);
+}
+
+void LiveCountController::reset(int initialTarget) {
+  target = std::clamp(initialTarget, minTarget, maxTarget);
+  direction = 1;
+  windowBallSteps = 0;
+  windowSteps = 0;
+  windowSeconds = 0;
+  lastRate = 0;
+}
+
+void LiveCountController::record(long long ballSteps, int numSteps,
+                                  double seconds) {
+  windowBallSteps += ballSteps;
+  windowSteps += numSteps;
+  windowSeconds += seconds;
+  if (windowSteps < WINDOW_STEPS || windowSeconds <= 0) {
+    return;
+  }
+
+  double rate = windowBallSteps / windowSeconds;
+  if (lastRate > 0 && rate < lastRate) {
+    direction = -direction;
+  }
+  lastRate = rate;
+
+  int newTarget = direction > 0 ? static_cast<int>(target * STEP_FACTOR)
+                                : static_cast<int>(target / STEP_FACTOR);
+  if (newTarget == target) {
+    newTarget += direction;
+  }
+  target = std::clamp(newTarget, minTarget, maxTarget);
+
+  windowBallSteps = 0;
+  windowSteps = 0;
+  windowSeconds = 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// picks how many balls to keep in flight at once by hill climbing on the
+// number of ball steps simulated per second of real time: the target keeps
+// moving in the same direction while throughput improves and turns around
+// once it drops
+class LiveCountController {
+ public:
+  // number of physics steps each throughput measurement is taken over
+  const int WINDOW_STEPS = 60;
+  const float STEP_FACTOR = 1.25f;
+
+  LiveCountController(int initialTarget = 250, int minTarget = 16,
+                      int maxTarget = 10000);
+  void reset(int initialTarget);
+
+  // records physics steps that simulated ballSteps ball steps in total
+  // (summed over every step) and took the given real time
+  void record(long long ballSteps, int numSteps, double seconds);
+
+  int getTarget() { return target; }
+  double getBallStepsPerSecond() { return lastRate; }
+
+ private:
+  int target;
+  int minTarget;
+  int maxTarget;
+  int direction = 1;
+
+  long long windowBallSteps = 0;
+  int windowSteps = 0;
+  double windowSeconds = 0;
+  double lastRate = 0;
+};
@@ -0,0 +1,14 @@
+#include "LiveShot.h"
+
+bool updateLiveShot(LiveShot& shot, BallState state, float dt,
+                    float maxShotTime) {
+  shot.time += dt;
+  if (state == BallState::ACTIVE) {
+    shot.settleTime = 0;
+  } else {
+    shot.settleTime += dt;
+  }
+
+  return state == BallState::OUT_OF_BOUNDS ||
+         shot.settleTime >= SETTLE_TIME || shot.time >= maxShotTime;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "ball/Ball.h"
+
+// how long a ball has to stay stationary (or in the goal) before it is
+// retired, since balls can slow down enough to count as stationary for a
+// moment at the top of a bounce or while rolling over a crest
+const float SETTLE_TIME = 0.5f;
+
+// a shot whose ball is currently being simulated
+struct LiveShot {
+  // row of the shot in its ShotTable (or just the shot's index for
+  // integrators without one)
+  int row;
+  float time = 0;
+  float settleTime = 0;
+};
+
+// advances the shot's timers by dt simulated seconds given its ball's current
+// state and returns true once the ball is finished: out of bounds, settled for
+// SETTLE_TIME, or simulated for longer than maxShotTime
+bool updateLiveShot(LiveShot& shot, BallState state, float dt,
+                    float maxShotTime);
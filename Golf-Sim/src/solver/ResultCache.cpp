@@ -0,0 +1,242 @@
+#include "ResultCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "ball/Ball.h"
+#include "goal/Goal.h"
+#include "solver/LiveShot.h"
+#include "terrain/Terrain.h"
+
+namespace {
+
+// 64 bit FNV-1a
+struct Hasher {
+  uint64_t hash = 14695981039346656037ull;
+
+  void add(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+  template <typename T>
+  void add(T value) {
+    add(&value, sizeof(value));
+  }
+};
+
+bool writeHeader(const std::string& path) {
+  std::ofstream fout(path, std::ios::binary);
+  CacheHeader header;
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+  header.version = CACHE_VERSION;
+  header.headerSize = sizeof(CacheHeader);
+  header.recordSize = sizeof(CacheRecord);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return static_cast<bool>(fout);
+}
+
+}  // namespace
+
+uint64_t computeSceneKey(Terrain& terrain, Goal& goal, glm::vec2 startPosition,
+                         float ballRadius, SolverBackend backend,
+                         float maxShotTime, bool prune) {
+  Hasher hasher;
+  hasher.add(CACHE_VERSION);
+
+  // the physics height map is the height map with the goal's footprint sunk,
+  // so the height map and the goal cover it
+  hasher.add(terrain.getPosition());
+  hasher.add(terrain.getWidth());
+  hasher.add(terrain.getHeight());
+  hasher.add(terrain.getNumCols());
+  hasher.add(terrain.getNumRows());
+  for (int row = 0; row <= terrain.getNumRows(); row++) {
+    for (int col = 0; col <= terrain.getNumCols(); col++) {
+      hasher.add(terrain.getHeight(col, row));
+    }
+  }
+
+  hasher.add(goal.getRelativePosition());
+  hasher.add(goal.getRadius());
+  hasher.add(goal.getBottomHeight());
+  hasher.add(startPosition);
+  hasher.add(ballRadius);
+
+  hasher.add(Ball::BOUNCINESS);
+  hasher.add(Ball::FRICTION);
+  hasher.add(Ball::MATERIAL_DENSITY);
+  hasher.add(Ball::LINEAR_DAMPING);
+  hasher.add(SETTLE_TIME);
+  hasher.add(static_cast<int>(backend));
+  hasher.add(maxShotTime);
+  hasher.add(prune);
+  return hasher.hash;
+}
+
+bool ResultCache::open(const std::string& path, uint64_t sceneKey) {
+  close();
+  this->path = path;
+  this->sceneKey = sceneKey;
+
+  std::error_code error;
+  if (!std::filesystem::exists(path, error) ||
+      std::filesystem::file_size(path, error) == 0) {
+    if (!writeHeader(path)) {
+      std::cout << "ERROR: could not create " << path << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  if (!file.openRead(path)) {
+    return false;
+  }
+  const CacheHeader* header =
+      reinterpret_cast<const CacheHeader*>(file.getData());
+  if (file.getSize() < sizeof(CacheHeader) ||
+      std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+      header->recordSize != sizeof(CacheRecord)) {
+    std::cout << "ERROR: " << path << " is not a results cache" << std::endl;
+    close();
+    return false;
+  }
+  if (header->version != CACHE_VERSION) {
+    std::cout << "ERROR: " << path << " has unsupported version "
+              << header->version << std::endl;
+    close();
+    return false;
+  }
+
+  // drop a record that was only partly written, so new records line up
+  size_t headerSize = header->headerSize;
+  size_t numRecords = (file.getSize() - headerSize) / sizeof(CacheRecord);
+  size_t validSize = headerSize + numRecords * sizeof(CacheRecord);
+  if (validSize != file.getSize()) {
+    file.close();
+    std::filesystem::resize_file(path, validSize, error);
+    if (error || !file.openRead(path)) {
+      std::cout << "ERROR: could not repair " << path << std::endl;
+      close();
+      return false;
+    }
+  }
+
+  const CacheRecord* records =
+      reinterpret_cast<const CacheRecord*>(file.getData() + headerSize);
+  for (size_t i = 0; i < numRecords; i++) {
+    if (records[i].sceneKey != sceneKey) continue;
+    ShotParams shot{records[i].power, records[i].yawOffset, records[i].pitch};
+    // a later record for the same shot replaces an earlier one
+    index[getShotKey(shot)] = mapped.size();
+    mapped.push_back(&records[i]);
+  }
+  return true;
+}
+
+void ResultCache::close() {
+  file.close();
+  mapped.clear();
+  added.clear();
+  numFlushed = 0;
+  index.clear();
+}
+
+bool ResultCache::lookup(const ShotParams& shot, float& distance,
+                         uint8_t& state) {
+  const CacheRecord* record = find(shot);
+  if (record == nullptr) {
+    numMisses++;
+    return false;
+  }
+  numHits++;
+  distance = record->distance;
+  state = record->state;
+  return true;
+}
+
+void ResultCache::add(const ShotParams& shot, float distance, uint8_t state) {
+  CacheRecord record = {};
+  record.sceneKey = sceneKey;
+  record.power = shot.power;
+  record.yawOffset = shot.yawOffset;
+  record.pitch = shot.pitch;
+  record.distance = distance;
+  record.state = state;
+  index[getShotKey(shot)] = mapped.size() + added.size();
+  added.push_back(record);
+}
+
+bool ResultCache::flush() {
+  if (numFlushed == added.size()) return true;
+
+  std::ofstream fout(path, std::ios::binary | std::ios::app);
+  fout.write(reinterpret_cast<const char*>(added.data() + numFlushed),
+             (added.size() - numFlushed) * sizeof(CacheRecord));
+  if (!fout) {
+    std::cout << "ERROR: could not append to " << path << std::endl;
+    return false;
+  }
+  numFlushed = added.size();
+  return true;
+}
+
+ShotEvaluator ResultCache::wrap(const ShotEvaluator& evaluate) {
+  return [this, evaluate](const std::vector<ShotParams>& shots,
+                          std::vector<float>& distances,
+                          std::vector<uint8_t>& states) {
+    distances.assign(shots.size(), 0);
+    states.assign(shots.size(), 0);
+
+    std::vector<ShotParams> missing;
+    std::vector<int> missingIndices;
+    for (int i = 0; i < shots.size(); i++) {
+      if (!lookup(shots[i], distances[i], states[i])) {
+        missing.push_back(shots[i]);
+        missingIndices.push_back(i);
+      }
+    }
+    if (missing.empty()) return;
+
+    std::vector<float> missingDistances;
+    std::vector<uint8_t> missingStates;
+    evaluate(missing, missingDistances, missingStates);
+    for (int i = 0; i < missing.size(); i++) {
+      distances[missingIndices[i]] = missingDistances[i];
+      states[missingIndices[i]] = missingStates[i];
+      add(missing[i], missingDistances[i], missingStates[i]);
+    }
+    // shots that couldn't be appended stay in memory and are tried again
+    // with the next batch
+    if (!flush()) {
+      std::cout << "ERROR: " << getNumUnflushed() << " solved shots are not in "
+                << path << " yet" << std::endl;
+    }
+  };
+}
+
+uint64_t ResultCache::getShotKey(const ShotParams& shot) {
+  Hasher hasher;
+  hasher.add(shot.power);
+  hasher.add(shot.yawOffset);
+  hasher.add(shot.pitch);
+  return hasher.hash;
+}
+
+const CacheRecord* ResultCache::find(const ShotParams& shot) {
+  auto it = index.find(getShotKey(shot));
+  if (it == index.end()) return nullptr;
+
+  const CacheRecord* record = it->second < mapped.size()
+                                  ? mapped[it->second]
+                                  : &added[it->second - mapped.size()];
+  // the key is only a hash, so make sure it's really the same shot
+  if (record->power != shot.power || record->yawOffset != shot.yawOffset ||
+      record->pitch != shot.pitch) {
+    return nullptr;
+  }
+  return record;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "solver/ShotIntegrator.h"
+#include "solver/Sweep.h"
+#include "util/MappedFile.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Terrain;
+class Goal;
+
+// results cache file: this header followed by CacheRecords, one per solved
+// shot. records are only ever appended, so any number of sweeps (of any
+// scenes) can share a file, and a record cut short by a crash is dropped the
+// next time the file is opened
+const char CACHE_MAGIC[4] = {'G', 'O', 'L', 'C'};
+// bump whenever a change to the solvers changes their results, which makes
+// every older record a miss
+const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t headerSize;
+  uint32_t recordSize;
+};
+static_assert(sizeof(CacheHeader) == 16, "cache header must be 16 bytes");
+
+struct CacheRecord {
+  uint64_t sceneKey;
+  float power;
+  float yawOffset;
+  float pitch;
+  float distance;
+  uint8_t state;
+  uint8_t padding[7];
+};
+static_assert(sizeof(CacheRecord) == 32, "cache record must be 32 bytes");
+
+// hash of everything besides a shot's parameters that its result depends on:
+// the terrain's height map and placement, the goal, the start position, the
+// ball's radius and physics constants, and how the shot is simulated
+uint64_t computeSceneKey(Terrain& terrain, Goal& goal, glm::vec2 startPosition,
+                         float ballRadius, SolverBackend backend,
+                         float maxShotTime, bool prune);
+
+// content-addressed store of solved shots for one scene, looked up by the
+// exact parameters of a shot. the file is mapped when it is opened and only
+// the records of the scene are indexed; shots solved since then are kept in
+// memory until they are appended by flush
+class ResultCache {
+ public:
+  // creates the file if it doesn't exist. returns false (after printing an
+  // error) if it isn't a cache file or can't be written
+  bool open(const std::string& path, uint64_t sceneKey);
+  void close();
+
+  bool lookup(const ShotParams& shot, float& distance, uint8_t& state);
+  void add(const ShotParams& shot, float distance, uint8_t state);
+  // appends every shot added since the last flush to the file
+  bool flush();
+
+  // serves every shot it can from the cache and passes only the rest on to
+  // evaluate, adding (and flushing) their results. the returned evaluator
+  // refers to this cache, which has to outlive it
+  ShotEvaluator wrap(const ShotEvaluator& evaluate);
+
+  int getNumRecords() { return index.size(); }
+  long long getNumHits() { return numHits; }
+  long long getNumMisses() { return numMisses; }
+  // shots added but not in the file, because appending to it failed
+  size_t getNumUnflushed() { return added.size() - numFlushed; }
+
+ private:
+  std::string path;
+  uint64_t sceneKey = 0;
+  MappedFile file;
+  // records of this scene that were already in the file when it was opened
+  std::vector<const CacheRecord*> mapped;
+  // records added since it was opened, and the ones not yet flushed
+  std::vector<CacheRecord> added;
+  size_t numFlushed = 0;
+  // shot key to index into mapped, or mapped.size() + index into added
+  std::unordered_map<uint64_t, size_t> index;
+  long long numHits = 0;
+  long long numMisses = 0;
+
+  uint64_t getShotKey(const ShotParams& shot);
+  const CacheRecord* find(const ShotParams& shot);
+};
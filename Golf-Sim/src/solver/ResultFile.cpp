@@ -0,0 +1,502 @@
+#include "ResultFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "ball/Ball.h"
+
+void writeResultFile(std::ostream& fout, const SweepConfig& sweepConfig,
+                     float ballRadius, float goalRadius,
+                     const std::vector<float>& distances) {
+  const int n = sweepConfig.numDivisions;
+  if (sweepConfig.sampling != SamplingMode::GRID) {
+    fout << "ERROR: only grid sweeps can be written as text, not "
+         << getSamplingModeName(sweepConfig.sampling) << " sweeps"
+         << std::endl;
+    return;
+  }
+  if (sweepConfig.getNumShots() != distances.size()) {
+    fout << "ERROR: " << sweepConfig.getNumShots() << " balls expected, "
+         << distances.size() << " balls found." << std::endl;
+    return;
+  }
+
+  fout << n << std::endl;
+  fout << sweepConfig.minPower << std::endl;
+  fout << sweepConfig.maxPower << std::endl;
+  fout << sweepConfig.minYaw << std::endl;
+  fout << sweepConfig.maxYaw << std::endl;
+  fout << sweepConfig.minPitch << std::endl;
+  fout << sweepConfig.maxPitch << std::endl;
+  fout << ballRadius << std::endl;
+  fout << goalRadius << std::endl;
+  fout << std::endl;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      for (int k = 0; k < n; k++) {
+        fout << distances[i * n * n + j * n + k];
+        if (k != n - 1) fout << " ";
+      }
+      fout << std::endl;
+    }
+    if (i != n - 1) fout << std::endl;
+  }
+}
+
+namespace {
+
+bool isLittleEndian() {
+  uint32_t value = 1;
+  return *reinterpret_cast<uint8_t*>(&value) == 1;
+}
+
+size_t alignTo8(size_t offset) { return (offset + 7) & ~size_t(7); }
+
+}  // namespace
+
+void fillResultHeader(ResultHeader& header, const SweepConfig& sweepConfig,
+                      float ballRadius, float goalRadius, uint32_t flags,
+                      uint64_t numShots) {
+  std::memcpy(header.magic, RESULT_MAGIC, sizeof(header.magic));
+  header.version = RESULT_VERSION;
+  header.headerSize = sizeof(ResultHeader);
+  header.numDivisions = sweepConfig.numDivisions;
+  header.flags = flags;
+  header.dimensionOrder[0] = RESULT_DIM_POWER;
+  header.dimensionOrder[1] = RESULT_DIM_YAW;
+  header.dimensionOrder[2] = RESULT_DIM_PITCH;
+  header.dimensionOrder[3] = 0;
+  header.minPower = sweepConfig.minPower;
+  header.maxPower = sweepConfig.maxPower;
+  header.minYaw = sweepConfig.minYaw;
+  header.maxYaw = sweepConfig.maxYaw;
+  header.minPitch = sweepConfig.minPitch;
+  header.maxPitch = sweepConfig.maxPitch;
+  header.ballRadius = ballRadius;
+  header.goalRadius = goalRadius;
+  header.numShots = numShots;
+}
+
+bool MappedResultFile::create(const std::string& path,
+                              const SweepConfig& sweepConfig, float ballRadius,
+                              float goalRadius, bool hasStates) {
+  if (!isLittleEndian()) {
+    std::cout << "ERROR: binary results files can only be written on "
+                 "little-endian machines"
+              << std::endl;
+    return false;
+  }
+
+  bool isGrid = sweepConfig.sampling == SamplingMode::GRID;
+  uint64_t numShots = sweepConfig.getNumShots();
+  size_t size = sizeof(ResultHeader) + numShots * sizeof(float) +
+                (hasStates ? numShots : 0);
+  if (!isGrid) {
+    size = alignTo8(size) + numShots * 3 * sizeof(float);
+  }
+  if (!file.create(path, size)) {
+    return false;
+  }
+
+  uint32_t flags =
+      (hasStates ? RESULT_HAS_STATES : 0) | (isGrid ? 0 : RESULT_SAMPLES);
+  ResultHeader header;
+  fillResultHeader(header, sweepConfig, ballRadius, goalRadius, flags,
+                   numShots);
+  if (!isGrid) {
+    header.numDivisions = 0;
+  }
+  std::memcpy(file.getData(), &header, sizeof(header));
+
+  if (!isGrid) {
+    float* params = getSampleParams();
+    for (const ShotParams& shot : sweepConfig.getShots()) {
+      *params++ = shot.power;
+      *params++ = shot.yawOffset;
+      *params++ = shot.pitch;
+    }
+  }
+
+  return true;
+}
+
+bool MappedResultFile::open(const std::string& path) {
+  if (!file.openRead(path)) {
+    return false;
+  }
+
+  if (file.getSize() < sizeof(ResultHeader) ||
+      std::memcmp(getHeader().magic, RESULT_MAGIC, sizeof(RESULT_MAGIC)) != 0) {
+    std::cout << "ERROR: " << path << " is not a binary results file"
+              << std::endl;
+    close();
+    return false;
+  }
+
+  const ResultHeader& header = getHeader();
+  if (header.version != RESULT_VERSION) {
+    std::cout << "ERROR: " << path << " has unsupported version "
+              << header.version << std::endl;
+    close();
+    return false;
+  }
+
+  // every shot takes at least 4 bytes, which also keeps the sizes below from
+  // overflowing
+  if (header.headerSize < sizeof(ResultHeader) ||
+      header.numShots > file.getSize() / sizeof(float)) {
+    std::cout << "ERROR: " << path << " is truncated" << std::endl;
+    close();
+    return false;
+  }
+  size_t expectedSize = header.headerSize + header.numShots * sizeof(float) +
+                        ((header.flags & RESULT_HAS_STATES) ? header.numShots
+                                                            : 0);
+  if (header.flags & RESULT_SAMPLES) {
+    expectedSize =
+        getSampleParamsOffset() + header.numShots * 3 * sizeof(float);
+  } else if (header.flags & RESULT_SPARSE_TREE) {
+    // coordinates and the number of leaves, which has to be read before the
+    // size of the leaves is known
+    expectedSize = getLeavesOffset() + sizeof(uint64_t);
+  }
+  if (file.getSize() < expectedSize) {
+    std::cout << "ERROR: " << path << " is truncated" << std::endl;
+    close();
+    return false;
+  }
+
+  // grids hold numDivisions^3 shots, and no file could hold a grid of more
+  // than 2^21 points per axis
+  uint64_t n = header.numDivisions;
+  if (header.flags & RESULT_SPARSE_TREE) {
+    if (!(header.flags & RESULT_HAS_STATES) ||
+        getNumLeaves() > (file.getSize() - expectedSize) /
+                             (4 * sizeof(uint16_t))) {
+      std::cout << "ERROR: " << path << " is truncated" << std::endl;
+      close();
+      return false;
+    }
+    if (!isSparseTreeInLattice()) {
+      std::cout << "ERROR: " << path << " has samples outside of its lattice"
+                << std::endl;
+      close();
+      return false;
+    }
+  } else if (!(header.flags & RESULT_SAMPLES) &&
+             (n > (1 << 21) || header.numShots != n * n * n)) {
+    std::cout << "ERROR: " << path << " has " << header.numShots
+              << " shots instead of " << n << "^3" << std::endl;
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool MappedResultFile::isSparseTreeInLattice() {
+  const uint64_t n = getHeader().numDivisions;
+  const uint16_t* coords = getSampleCoords();
+  for (uint64_t i = 0; i < getNumShots() * 3; i++) {
+    if (coords[i] >= n) return false;
+  }
+  // every corner of a leaf has to be on the lattice too
+  const uint16_t* leaves = getLeaves();
+  for (uint64_t l = 0; l < getNumLeaves(); l++) {
+    uint64_t size = leaves[l * 4 + 3];
+    if (size == 0 || leaves[l * 4] + size >= n ||
+        leaves[l * 4 + 1] + size >= n || leaves[l * 4 + 2] + size >= n) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SweepConfig MappedResultFile::getSweepConfig() {
+  const ResultHeader& header = getHeader();
+
+  SweepConfig sweepConfig;
+  sweepConfig.numDivisions = header.numDivisions;
+  sweepConfig.numSamples = header.numShots;
+  sweepConfig.minPower = header.minPower;
+  sweepConfig.maxPower = header.maxPower;
+  sweepConfig.minYaw = header.minYaw;
+  sweepConfig.maxYaw = header.maxYaw;
+  sweepConfig.minPitch = header.minPitch;
+  sweepConfig.maxPitch = header.maxPitch;
+  return sweepConfig;
+}
+
+uint8_t* MappedResultFile::getStates() {
+  const ResultHeader& header = getHeader();
+  if (!(header.flags & RESULT_HAS_STATES)) {
+    return nullptr;
+  }
+  return file.getData() + header.headerSize + header.numShots * sizeof(float);
+}
+
+float* MappedResultFile::getSampleParams() {
+  if (!(getHeader().flags & RESULT_SAMPLES)) {
+    return nullptr;
+  }
+  return reinterpret_cast<float*>(file.getData() + getSampleParamsOffset());
+}
+
+size_t MappedResultFile::getSampleParamsOffset() {
+  const ResultHeader& header = getHeader();
+  return alignTo8(header.headerSize + header.numShots * sizeof(float) +
+                  ((header.flags & RESULT_HAS_STATES) ? header.numShots : 0));
+}
+
+uint16_t* MappedResultFile::getSampleCoords() {
+  const ResultHeader& header = getHeader();
+  if (!(header.flags & RESULT_SPARSE_TREE)) {
+    return nullptr;
+  }
+  return reinterpret_cast<uint16_t*>(
+      file.getData() + alignTo8(header.headerSize +
+                                header.numShots * (sizeof(float) + 1)));
+}
+
+uint64_t MappedResultFile::getNumLeaves() {
+  if (!(getHeader().flags & RESULT_SPARSE_TREE)) {
+    return 0;
+  }
+  uint64_t numLeaves;
+  std::memcpy(&numLeaves, file.getData() + getLeavesOffset(),
+              sizeof(numLeaves));
+  return numLeaves;
+}
+
+uint16_t* MappedResultFile::getLeaves() {
+  if (!(getHeader().flags & RESULT_SPARSE_TREE)) {
+    return nullptr;
+  }
+  return reinterpret_cast<uint16_t*>(file.getData() + getLeavesOffset() +
+                                     sizeof(uint64_t));
+}
+
+size_t MappedResultFile::getLeavesOffset() {
+  const ResultHeader& header = getHeader();
+  size_t coordsOffset =
+      alignTo8(header.headerSize + header.numShots * (sizeof(float) + 1));
+  return alignTo8(coordsOffset + header.numShots * 3 * sizeof(uint16_t));
+}
+
+bool writeBinaryResultFile(const std::string& path,
+                           const SweepConfig& sweepConfig, float ballRadius,
+                           float goalRadius, const std::vector<float>& distances,
+                           const std::vector<uint8_t>& states) {
+  if (sweepConfig.getNumShots() != distances.size() ||
+      (!states.empty() && states.size() != distances.size())) {
+    std::cout << "ERROR: " << sweepConfig.getNumShots() << " balls expected, "
+              << distances.size() << " balls found." << std::endl;
+    return false;
+  }
+
+  MappedResultFile file;
+  if (!file.create(path, sweepConfig, ballRadius, goalRadius,
+                   !states.empty())) {
+    return false;
+  }
+
+  std::memcpy(file.getDistances(), distances.data(),
+              distances.size() * sizeof(float));
+  if (!states.empty()) {
+    std::memcpy(file.getStates(), states.data(), states.size());
+  }
+  return true;
+}
+
+bool writeSparseTreeResultFile(const std::string& path, AdaptiveSweep& sweep,
+                               float ballRadius, float goalRadius) {
+  if (!isLittleEndian()) {
+    std::cout << "ERROR: binary results files can only be written on "
+                 "little-endian machines"
+              << std::endl;
+    return false;
+  }
+
+  const std::vector<AdaptiveSample>& samples = sweep.getSamples();
+  const std::vector<AdaptiveCell>& leaves = sweep.getLeaves();
+  uint64_t numShots = samples.size();
+  uint64_t numLeaves = leaves.size();
+
+  size_t distancesOffset = sizeof(ResultHeader);
+  size_t statesOffset = distancesOffset + numShots * sizeof(float);
+  size_t coordsOffset = alignTo8(statesOffset + numShots);
+  size_t leavesOffset =
+      alignTo8(coordsOffset + numShots * 3 * sizeof(uint16_t));
+  size_t size = leavesOffset + sizeof(uint64_t) +
+                numLeaves * 4 * sizeof(uint16_t);
+
+  MappedFile file;
+  if (!file.create(path, size)) {
+    return false;
+  }
+
+  SweepConfig sweepConfig = sweep.getSweepConfig();
+  sweepConfig.numDivisions = sweep.getResolution() + 1;
+  ResultHeader header;
+  fillResultHeader(header, sweepConfig, ballRadius, goalRadius,
+                   RESULT_HAS_STATES | RESULT_SPARSE_TREE, numShots);
+  std::memcpy(file.getData(), &header, sizeof(header));
+
+  float* distances = reinterpret_cast<float*>(file.getData() + distancesOffset);
+  uint8_t* states = file.getData() + statesOffset;
+  uint16_t* coords = reinterpret_cast<uint16_t*>(file.getData() + coordsOffset);
+  for (uint64_t i = 0; i < numShots; i++) {
+    distances[i] = samples[i].distance;
+    states[i] = samples[i].state;
+    coords[i * 3 + 0] = samples[i].power;
+    coords[i * 3 + 1] = samples[i].yaw;
+    coords[i * 3 + 2] = samples[i].pitch;
+  }
+
+  std::memcpy(file.getData() + leavesOffset, &numLeaves, sizeof(numLeaves));
+  uint16_t* cells = reinterpret_cast<uint16_t*>(file.getData() + leavesOffset +
+                                                sizeof(uint64_t));
+  for (uint64_t i = 0; i < numLeaves; i++) {
+    cells[i * 4 + 0] = leaves[i].power;
+    cells[i * 4 + 1] = leaves[i].yaw;
+    cells[i * 4 + 2] = leaves[i].pitch;
+    cells[i * 4 + 3] = leaves[i].size;
+  }
+
+  return true;
+}
+
+namespace {
+
+bool readTextResultGrid(const std::string& path, SweepConfig& sweepConfig,
+                        float& ballRadius, float& goalRadius,
+                        std::vector<float>& distances) {
+  std::ifstream fin(path);
+  if (!fin) {
+    std::cout << "ERROR: could not open " << path << std::endl;
+    return false;
+  }
+
+  sweepConfig = SweepConfig();
+  fin >> sweepConfig.numDivisions >> sweepConfig.minPower >>
+      sweepConfig.maxPower >> sweepConfig.minYaw >> sweepConfig.maxYaw >>
+      sweepConfig.minPitch >> sweepConfig.maxPitch >> ballRadius >> goalRadius;
+  distances.resize(sweepConfig.getNumShots());
+  for (float& distance : distances) {
+    fin >> distance;
+  }
+  if (!fin) {
+    std::cout << "ERROR: " << path << " is not a results file" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// fills the finest lattice of a sparse tree file
+void fillSparseTree(MappedResultFile& file, std::vector<float>& distances,
+                    std::vector<uint8_t>& states) {
+  const int n = file.getHeader().numDivisions;
+  const float* sampleDistances = file.getDistances();
+  const uint8_t* sampleStates = file.getStates();
+  const uint16_t* coords = file.getSampleCoords();
+  auto getIndex = [n](size_t power, size_t yaw, size_t pitch) {
+    return (power * n + yaw) * n + pitch;
+  };
+
+  distances.assign(static_cast<size_t>(n) * n * n, 0.0f);
+  states.assign(distances.size(), static_cast<uint8_t>(BallState::ACTIVE));
+  for (uint64_t i = 0; i < file.getNumShots(); i++) {
+    size_t index =
+        getIndex(coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2]);
+    distances[index] = sampleDistances[i];
+    states[index] = sampleStates[i];
+  }
+
+  // leaves of size 1 have no points but their corners
+  std::vector<float> filled = distances;
+  const uint16_t* leaves = file.getLeaves();
+  for (uint64_t l = 0; l < file.getNumLeaves(); l++) {
+    int power = leaves[l * 4], yaw = leaves[l * 4 + 1];
+    int pitch = leaves[l * 4 + 2], size = leaves[l * 4 + 3];
+    if (size == 1) continue;
+
+    float mean = 0;
+    for (int corner = 0; corner < 8; corner++) {
+      mean += distances[getIndex(power + ((corner >> 2) & 1) * size,
+                                 yaw + ((corner >> 1) & 1) * size,
+                                 pitch + (corner & 1) * size)];
+    }
+    mean /= 8;
+
+    for (int i = 0; i <= size; i++) {
+      for (int j = 0; j <= size; j++) {
+        for (int k = 0; k <= size; k++) {
+          filled[getIndex(power + i, yaw + j, pitch + k)] = mean;
+        }
+      }
+    }
+  }
+
+  // the simulated shots win over any cell that was filled around them
+  for (uint64_t i = 0; i < file.getNumShots(); i++) {
+    size_t index =
+        getIndex(coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2]);
+    filled[index] = distances[index];
+  }
+  distances = std::move(filled);
+}
+
+}  // namespace
+
+bool readResultGrid(const std::string& path, SweepConfig& sweepConfig,
+                    float& ballRadius, float& goalRadius,
+                    std::vector<float>& distances,
+                    std::vector<uint8_t>& states) {
+  states.clear();
+  char magic[sizeof(RESULT_MAGIC)] = {};
+  {
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin) {
+      std::cout << "ERROR: could not open " << path << std::endl;
+      return false;
+    }
+    fin.read(magic, sizeof(magic));
+  }
+  if (std::memcmp(magic, RESULT_MAGIC, sizeof(RESULT_MAGIC)) != 0) {
+    return readTextResultGrid(path, sweepConfig, ballRadius, goalRadius,
+                              distances);
+  }
+
+  MappedResultFile file;
+  if (!file.open(path)) {
+    return false;
+  }
+  const ResultHeader& header = file.getHeader();
+  if (header.flags & RESULT_SAMPLES) {
+    std::cout << "ERROR: " << path << " holds samples rather than a grid"
+              << std::endl;
+    return false;
+  }
+
+  sweepConfig = file.getSweepConfig();
+  ballRadius = header.ballRadius;
+  goalRadius = header.goalRadius;
+  if (header.flags & RESULT_SPARSE_TREE) {
+    uint64_t n = header.numDivisions;
+    if (n * n * n > MAX_GRID_POINTS) {
+      std::cout << "ERROR: " << path << " has " << n << " points per axis, "
+                << "too many to fill in as a grid of at most "
+                << MAX_GRID_POINTS << " points" << std::endl;
+      return false;
+    }
+    fillSparseTree(file, distances, states);
+  } else {
+    distances.assign(file.getDistances(),
+                     file.getDistances() + file.getNumShots());
+    if (file.getStates() != nullptr) {
+      states.assign(file.getStates(), file.getStates() + file.getNumShots());
+    }
+  }
+  return true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "solver/AdaptiveSweep.h"
+#include "solver/Sweep.h"
+#include "util/MappedFile.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// writes the text .golf results file read by Params-Viz, with one distance
+// from the goal per shot of the sweep (in SweepConfig index order). only grid
+// sweeps can be written as text
+void writeResultFile(std::ostream& fout, const SweepConfig& sweepConfig,
+                     float ballRadius, float goalRadius,
+                     const std::vector<float>& distances);
+
+// binary .golf results file (version 2): this header, then numShots
+// little-endian float32 distances, then (if RESULT_HAS_STATES is set) one
+// BallState byte per shot. shots are stored in SweepConfig index order, which
+// dimensionOrder spells out from the slowest to the fastest changing dimension
+//
+// sweeps that aren't a grid set RESULT_SAMPLES and numDivisions to 0, and
+// follow the states with the (power, yaw, pitch) float32 parameters of each
+// shot, starting on an 8 byte boundary
+const char RESULT_MAGIC[4] = {'G', 'O', 'L', 'F'};
+const uint32_t RESULT_VERSION = 2;
+const uint32_t RESULT_HAS_STATES = 1;
+// the file holds the samples of an adaptive sweep rather than a full grid, see
+// writeSparseTreeResultFile
+const uint32_t RESULT_SPARSE_TREE = 2;
+const uint32_t RESULT_SAMPLES = 4;
+
+enum ResultDimension : uint8_t {
+  RESULT_DIM_POWER = 0,
+  RESULT_DIM_YAW = 1,
+  RESULT_DIM_PITCH = 2
+};
+
+struct ResultHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t headerSize;
+  uint32_t numDivisions;
+  uint32_t flags;
+  uint8_t dimensionOrder[4];
+  float minPower;
+  float maxPower;
+  float minYaw;
+  float maxYaw;
+  float minPitch;
+  float maxPitch;
+  float ballRadius;
+  float goalRadius;
+  uint64_t numShots;
+};
+static_assert(sizeof(ResultHeader) == 64, "result header must be 64 bytes");
+
+// fills in a version 2 header for numShots shots of the sweep, with the
+// dimensions in SweepConfig index order
+void fillResultHeader(ResultHeader& header, const SweepConfig& sweepConfig,
+                      float ballRadius, float goalRadius, uint32_t flags,
+                      uint64_t numShots);
+
+// a binary results file mapped into memory, so that writing a sweep is a
+// single copy into the mapping and reading it doesn't copy at all
+class MappedResultFile {
+ public:
+  // creates the file with room for every shot of the sweep (and their
+  // parameters, if it isn't a grid), leaving the distances (and states) to be
+  // filled in through getDistances / getStates
+  bool create(const std::string& path, const SweepConfig& sweepConfig,
+              float ballRadius, float goalRadius, bool hasStates);
+  // returns false (after printing an error) if the file isn't a valid
+  // version 2 results file, including any section that doesn't fit in the
+  // file and sparse tree samples or leaves outside of the lattice
+  bool open(const std::string& path);
+  void close() { file.close(); }
+
+  const ResultHeader& getHeader() {
+    return *reinterpret_cast<ResultHeader*>(file.getData());
+  }
+  // the sampling mode isn't stored, so for files with RESULT_SAMPLES this is
+  // only the ranges, with each shot's parameters in getSampleParams
+  SweepConfig getSweepConfig();
+  uint64_t getNumShots() { return getHeader().numShots; }
+  float* getDistances() {
+    return reinterpret_cast<float*>(file.getData() + getHeader().headerSize);
+  }
+  // nullptr if the file has no states
+  uint8_t* getStates();
+  // power, yaw and pitch of each shot, or nullptr for grid sweeps
+  float* getSampleParams();
+  // lattice coordinates of each shot and the leaf cells (origin and size) of
+  // sparse tree files, or nullptr for others
+  uint16_t* getSampleCoords();
+  uint64_t getNumLeaves();
+  uint16_t* getLeaves();
+
+ private:
+  MappedFile file;
+
+  size_t getSampleParamsOffset();
+  size_t getLeavesOffset();
+  // whether every sample and leaf corner of a sparse tree file is inside the
+  // lattice
+  bool isSparseTreeInLattice();
+};
+
+// writes a binary results file in one go, with states left out if it is empty
+bool writeBinaryResultFile(const std::string& path,
+                           const SweepConfig& sweepConfig, float ballRadius,
+                           float goalRadius, const std::vector<float>& distances,
+                           const std::vector<uint8_t>& states);
+
+// sparse tree results file: the binary layout above, where numDivisions is the
+// number of points per axis of the finest lattice and numShots the number of
+// samples, followed by (each section starting on an 8 byte boundary)
+//   uint16 lattice coordinates (power, yaw, pitch) of each sample
+//   uint64 number of leaf cells
+//   uint16 origin (power, yaw, pitch) and size of each leaf cell
+// every leaf's eight corners are samples, so a reader can rebuild the octree
+// or interpolate any shot from the leaf containing it
+bool writeSparseTreeResultFile(const std::string& path, AdaptiveSweep& sweep,
+                               float ballRadius, float goalRadius);
+
+// the most points readResultGrid expands a sparse tree file into
+const uint64_t MAX_GRID_POINTS = 1ull << 27;
+
+// reads a text or binary results file into a full grid of distances (in
+// SweepConfig index order). the leaf cells of sparse tree files are filled in
+// with the mean of their corners, which keeps every cell on the same side of
+// the goal's edge as its corners. states gets the BallState of each shot,
+// or is left empty for files without them (filled in cells are ACTIVE).
+// returns false (after printing an error) for files that aren't grids, like
+// sobol sweeps
+bool readResultGrid(const std::string& path, SweepConfig& sweepConfig,
+                    float& ballRadius, float& goalRadius,
+                    std::vector<float>& distances,
+                    std::vector<uint8_t>& states);
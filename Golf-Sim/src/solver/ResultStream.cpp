@@ -0,0 +1,152 @@
+#include "ResultStream.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+bool readStreamFile(const std::string& path, ResultHeader& header,
+                    std::vector<StreamRecord>& records) {
+  // read rather than mapped, since the file is usually still open for
+  // writing in the process streaming it
+  std::ifstream fin(path, std::ios::binary | std::ios::ate);
+  if (!fin) {
+    std::cout << "ERROR: could not open " << path << std::endl;
+    return false;
+  }
+  size_t size = fin.tellg();
+  fin.seekg(0);
+  if (size < sizeof(ResultHeader) ||
+      !fin.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    std::cout << "ERROR: " << path << " is not a streamed results file"
+              << std::endl;
+    return false;
+  }
+  if (std::memcmp(header.magic, STREAM_MAGIC, sizeof(STREAM_MAGIC)) != 0 ||
+      header.headerSize < sizeof(ResultHeader) || header.headerSize > size) {
+    std::cout << "ERROR: " << path << " is not a streamed results file"
+              << std::endl;
+    return false;
+  }
+  if (header.version != STREAM_VERSION) {
+    std::cout << "ERROR: " << path << " has unsupported version "
+              << header.version << std::endl;
+    return false;
+  }
+
+  // a record that is still being written is left out
+  size_t numRecords = (size - header.headerSize) / sizeof(StreamRecord);
+  records.resize(numRecords);
+  fin.seekg(header.headerSize);
+  if (!fin.read(reinterpret_cast<char*>(records.data()),
+                numRecords * sizeof(StreamRecord))) {
+    std::cout << "ERROR: could not read " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+ResultStream::~ResultStream() { close(); }
+
+bool ResultStream::open(const std::string& path,
+                        const SweepConfig& sweepConfig, float ballRadius,
+                        float goalRadius, int firstIndex) {
+  close();
+  this->path = path;
+  this->firstIndex = firstIndex;
+
+  bool isGrid = sweepConfig.sampling == SamplingMode::GRID;
+  ResultHeader header;
+  fillResultHeader(header, sweepConfig, ballRadius, goalRadius,
+                   isGrid ? 0 : RESULT_SAMPLES, sweepConfig.getNumShots());
+  std::memcpy(header.magic, STREAM_MAGIC, sizeof(header.magic));
+  header.version = STREAM_VERSION;
+  if (!isGrid) {
+    header.numDivisions = 0;
+  }
+
+  fout.open(path, std::ios::binary | std::ios::trunc);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fout.flush();
+  if (!fout) {
+    std::cout << "ERROR: could not write " << path << std::endl;
+    fout.close();
+    return false;
+  }
+
+  front.clear();
+  back.clear();
+  front.reserve(BUFFER_SHOTS);
+  back.reserve(BUFFER_SHOTS);
+  closing = false;
+  failed = false;
+  numWritten = 0;
+  writer = std::thread(&ResultStream::runWriter, this);
+  return true;
+}
+
+bool ResultStream::close() {
+  if (!writer.joinable()) return true;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closing = true;
+  }
+  wake.notify_one();
+  writer.join();
+  fout.close();
+  return !failed;
+}
+
+void ResultStream::push(int index, float distance, BallState state,
+                        glm::vec3 position) {
+  StreamRecord record = {};
+  record.index = firstIndex + index;
+  record.distance = distance;
+  record.x = position.x;
+  record.y = position.y;
+  record.z = position.z;
+  record.state = static_cast<uint8_t>(state);
+
+  bool full;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    // if the writer is still busy with the other buffer this one just keeps
+    // growing, rather than holding up the caller
+    front.push_back(record);
+    full = front.size() == BUFFER_SHOTS;
+  }
+  if (full) {
+    wake.notify_one();
+  }
+}
+
+void ResultStream::runWriter() {
+  bool done = false;
+  while (!done) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait_for(lock, FLUSH_INTERVAL, [&]() {
+        return closing || front.size() >= BUFFER_SHOTS;
+      });
+      std::swap(front, back);
+      done = closing;
+    }
+    if (back.empty()) continue;
+
+    // after a failed write the shots are still drained, so memory use stays
+    // the same, but nothing more is written
+    if (!failed) {
+      fout.write(reinterpret_cast<const char*>(back.data()),
+                 back.size() * sizeof(StreamRecord));
+      // flushed right away so readers tailing the file see every shot
+      fout.flush();
+      if (!fout) {
+        std::cout << "ERROR: could not append to " << path << std::endl;
+        failed = true;
+      } else {
+        numWritten += back.size();
+      }
+    }
+    back.clear();
+  }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ball/Ball.h"
+#include "solver/ResultFile.h"
+#include "solver/Sweep.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// streamed results file: a ResultHeader (see ResultFile.h) with this magic and
+// version instead, followed by a StreamRecord for every finished shot in the
+// order they finished. numShots is the number of shots in the whole sweep, so
+// a reader tailing the file can tell how far along the sweep is, and sweeps
+// that aren't a grid set RESULT_SAMPLES and numDivisions to 0 (their
+// parameters come from SweepConfig::getShots)
+const char STREAM_MAGIC[4] = {'G', 'O', 'L', 'S'};
+const uint32_t STREAM_VERSION = 1;
+
+struct StreamRecord {
+  // index of the shot in the sweep
+  uint32_t index;
+  float distance;
+  // where the ball ended up
+  float x;
+  float y;
+  float z;
+  uint8_t state;
+  uint8_t padding[3];
+};
+static_assert(sizeof(StreamRecord) == 24, "stream record must be 24 bytes");
+
+// reads the header and every complete record of a streamed results file,
+// which may still be being written. returns false (after printing an error) if
+// it isn't a streamed results file
+bool readStreamFile(const std::string& path, ResultHeader& header,
+                    std::vector<StreamRecord>& records);
+
+// writes shots to a streamed results file as they finish. push only appends to
+// an in-memory buffer, which a background thread swaps out and writes while
+// the next one fills up, so the threads simulating shots never wait on the
+// disk. the file is flushed at least every FLUSH_INTERVAL, and only the shots
+// not yet written are ever held in memory
+class ResultStream {
+ public:
+  static constexpr int BUFFER_SHOTS = 4096;
+  static constexpr std::chrono::milliseconds FLUSH_INTERVAL{500};
+
+  ~ResultStream();
+
+  // creates the file (replacing any existing one) and starts the writer
+  // thread. returns false (after printing an error) if it can't be written.
+  // streams of only part of the sweep start at firstIndex, which is added to
+  // every pushed index
+  bool open(const std::string& path, const SweepConfig& sweepConfig,
+            float ballRadius, float goalRadius, int firstIndex = 0);
+  // writes every shot pushed so far and stops the writer thread, returning
+  // false if any of them couldn't be written
+  bool close();
+
+  // safe to call from any number of threads at once
+  void push(int index, float distance, BallState state, glm::vec3 position);
+
+  bool isOpen() { return writer.joinable(); }
+  long long getNumWritten() { return numWritten; }
+
+ private:
+  std::string path;
+  int firstIndex = 0;
+  std::ofstream fout;
+  std::thread writer;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  // shots being pushed, and shots being written by the writer thread
+  std::vector<StreamRecord> front;
+  std::vector<StreamRecord> back;
+  bool closing = false;
+  // only touched by the writer thread until it is joined
+  bool failed = false;
+  std::atomic<long long> numWritten{0};
+
+  void runWriter();
+};
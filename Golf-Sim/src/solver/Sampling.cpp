@@ -0,0 +1,184 @@
+#include "Sampling.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace {
+
+const int SOBOL_BITS = 32;
+
+// direction numbers of the first three sobol dimensions, from the primitive
+// polynomials x, x + 1 and x^2 + x + 1 (Joe and Kuo's initial values)
+struct SobolDirections {
+  uint32_t v[3][SOBOL_BITS];
+
+  SobolDirections() {
+    for (int k = 0; k < SOBOL_BITS; k++) {
+      v[0][k] = 1u << (31 - k);
+    }
+
+    // x + 1: degree 1, m = {1}
+    v[1][0] = 1u << 31;
+    for (int k = 1; k < SOBOL_BITS; k++) {
+      v[1][k] = v[1][k - 1] ^ (v[1][k - 1] >> 1);
+    }
+
+    // x^2 + x + 1: degree 2, a = 1, m = {1, 3}
+    v[2][0] = 1u << 31;
+    v[2][1] = 3u << 30;
+    for (int k = 2; k < SOBOL_BITS; k++) {
+      v[2][k] = v[2][k - 2] ^ (v[2][k - 2] >> 2) ^ v[2][k - 1];
+    }
+  }
+};
+
+const SobolDirections SOBOL_DIRECTIONS;
+
+// the largest values round up to 1 as a float, so those are clamped to stay
+// in [0, 1)
+float toUnit(uint32_t value) {
+  return std::min(value * (1.0f / 4294967296.0f), 0.99999994f);
+}
+
+float radicalInverse(uint32_t index, uint32_t base) {
+  double inverse = 0;
+  double scale = 1.0 / base;
+  while (index > 0) {
+    inverse += (index % base) * scale;
+    index /= base;
+    scale /= base;
+  }
+  return static_cast<float>(inverse);
+}
+
+uint32_t reverseBits(uint32_t value) {
+  uint32_t reversed = 0;
+  for (int i = 0; i < 32; i++) {
+    reversed = (reversed << 1) | (value & 1);
+    value >>= 1;
+  }
+  return reversed;
+}
+
+// per-dimension random bits for a seed (the murmur3 finalizer)
+uint32_t hashSeed(uint32_t seed, uint32_t dimension) {
+  uint32_t h = seed * 0x9e3779b9u + dimension;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+// wraps into [0, 1) without ever rounding up to 1
+float wrapUnit(float value) {
+  value -= static_cast<int>(value);
+  return std::min(value, 0.99999994f);
+}
+
+}  // namespace
+
+const char* getSamplingModeName(SamplingMode mode) {
+  switch (mode) {
+    case SamplingMode::GRID:
+      return "grid";
+    case SamplingMode::SOBOL:
+      return "sobol";
+    case SamplingMode::HALTON:
+      return "halton";
+    case SamplingMode::LATIN_HYPERCUBE:
+      return "lhs";
+  }
+  return "";
+}
+
+bool parseSamplingMode(const std::string& name, SamplingMode& mode) {
+  for (SamplingMode candidate :
+       {SamplingMode::GRID, SamplingMode::SOBOL, SamplingMode::HALTON,
+        SamplingMode::LATIN_HYPERCUBE}) {
+    if (name == getSamplingModeName(candidate)) {
+      mode = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<glm::vec3> getUnitSamples(SamplingMode mode, int numSamples,
+                                      uint32_t seed) {
+  std::vector<glm::vec3> samples;
+  if (mode == SamplingMode::LATIN_HYPERCUBE) {
+    return getLatinHypercubePoints(numSamples, seed);
+  }
+
+  samples.reserve(std::max(0, numSamples));
+  for (int i = 0; i < numSamples; i++) {
+    samples.push_back(mode == SamplingMode::SOBOL ? getSobolPoint(i, seed)
+                                                  : getHaltonPoint(i, seed));
+  }
+  return samples;
+}
+
+glm::vec3 getSobolPoint(uint32_t index, uint32_t seed) {
+  uint32_t x[3] = {0, 0, 0};
+  if (seed != 0) {
+    for (int d = 0; d < 3; d++) x[d] = hashSeed(seed, d);
+  }
+
+  for (int k = 0; index != 0; k++, index >>= 1) {
+    if (index & 1) {
+      for (int d = 0; d < 3; d++) x[d] ^= SOBOL_DIRECTIONS.v[d][k];
+    }
+  }
+  return glm::vec3(toUnit(x[0]), toUnit(x[1]), toUnit(x[2]));
+}
+
+glm::vec3 getHaltonPoint(uint32_t index, uint32_t seed) {
+  glm::vec3 shift(0.0f);
+  if (seed != 0) {
+    shift = glm::vec3(toUnit(hashSeed(seed, 0)), toUnit(hashSeed(seed, 1)),
+                      toUnit(hashSeed(seed, 2)));
+  }
+
+  return glm::vec3(wrapUnit(radicalInverse(index, 2) + shift.x),
+                   wrapUnit(radicalInverse(index, 3) + shift.y),
+                   wrapUnit(radicalInverse(index, 5) + shift.z));
+}
+
+std::vector<glm::vec3> getLatinHypercubePoints(int numSamples, uint32_t seed) {
+  std::vector<glm::vec3> samples;
+  if (numSamples <= 0) return samples;
+
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+  // sample i is in power stratum i, and in the yaw and pitch strata given by
+  // a random permutation
+  std::vector<int> strata[2];
+  for (std::vector<int>& permutation : strata) {
+    permutation.resize(numSamples);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::shuffle(permutation.begin(), permutation.end(), random);
+  }
+
+  samples.resize(numSamples);
+  for (int i = 0; i < numSamples; i++) {
+    samples[i] = glm::vec3((i + unit(random)) / numSamples,
+                           (strata[0][i] + unit(random)) / numSamples,
+                           (strata[1][i] + unit(random)) / numSamples);
+    samples[i] = glm::min(samples[i], glm::vec3(0.99999994f));
+  }
+
+  std::vector<int> order(numSamples);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [](int a, int b) {
+    return reverseBits(a) < reverseBits(b);
+  });
+
+  std::vector<glm::vec3> ordered;
+  ordered.reserve(numSamples);
+  for (int i : order) ordered.push_back(samples[i]);
+  return ordered;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// how the shots of a sweep are spread over the power / yaw / pitch ranges
+enum class SamplingMode {
+  // numDivisions evenly spaced values per dimension
+  GRID,
+  // low-discrepancy sequences, where every prefix covers the ranges evenly
+  SOBOL,
+  HALTON,
+  // one sample per stratum of each dimension
+  LATIN_HYPERCUBE
+};
+
+const char* getSamplingModeName(SamplingMode mode);
+// returns false if the name isn't one of getSamplingModeName's
+bool parseSamplingMode(const std::string& name, SamplingMode& mode);
+
+// points of the unit cube, in the order they should be simulated. a seed of 0
+// gives the plain sequences, any other seed randomizes them (a digital shift
+// for sobol, a random shift for halton and the strata permutations for latin
+// hypercube sampling). not defined for GRID
+std::vector<glm::vec3> getUnitSamples(SamplingMode mode, int numSamples,
+                                      uint32_t seed);
+
+glm::vec3 getSobolPoint(uint32_t index, uint32_t seed);
+glm::vec3 getHaltonPoint(uint32_t index, uint32_t seed);
+// latin hypercube samples are ordered by the bit-reversed index of their power
+// stratum, so that a sweep stopped early still covers the power range evenly
+std::vector<glm::vec3> getLatinHypercubePoints(int numSamples, uint32_t seed);
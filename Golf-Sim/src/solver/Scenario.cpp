@@ -0,0 +1,28 @@
+#include "Scenario.h"
+
+std::vector<Scenario> ScenarioBatch::getScenarios() const {
+  std::vector<Scenario> scenarios;
+  scenarios.reserve(getNumScenarios());
+  for (float goalRadius : goalRadii) {
+    for (glm::vec2 goalPosition : goalPositions) {
+      for (glm::vec2 startPosition : startPositions) {
+        scenarios.push_back(Scenario{startPosition, goalPosition, goalRadius});
+      }
+    }
+  }
+  return scenarios;
+}
+
+std::vector<glm::vec2> getGridPositions(glm::vec2 min, glm::vec2 max, int n) {
+  std::vector<glm::vec2> positions;
+  if (n <= 0) return positions;
+  if (n == 1) return {(min + max) / 2.0f};
+
+  glm::vec2 step = (max - min) / static_cast<float>(n - 1);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      positions.push_back(min + step * glm::vec2(i, j));
+    }
+  }
+  return positions;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// a start position and goal to run a whole sweep for, with both positions in
+// relative (0 - 1) terrain coordinates
+struct Scenario {
+  glm::vec2 startPosition;
+  glm::vec2 goalPosition;
+  float goalRadius;
+};
+
+// every combination of a set of start positions, goal positions and goal
+// radii, all on the same terrain
+struct ScenarioBatch {
+  std::vector<glm::vec2> startPositions;
+  std::vector<glm::vec2> goalPositions;
+  std::vector<float> goalRadii;
+
+  int getNumScenarios() const {
+    return startPositions.size() * goalPositions.size() * goalRadii.size();
+  }
+  // ordered by goal, so a goal only has to be built once for all of the start
+  // positions it is swept from
+  std::vector<Scenario> getScenarios() const;
+};
+
+// the points of an n by n grid spanning [min, max] on both axes
+std::vector<glm::vec2> getGridPositions(glm::vec2 min, glm::vec2 max, int n);
@@ -0,0 +1,126 @@
+#include "ShardedSolver.h"
+
+#include <algorithm>
+
+#include "solver/BatchSolver.h"
+#include "solver/HeightFieldIntegrator.h"
+#include "solver/ResultStream.h"
+
+ShardedSolver::ShardedSolver(Terrain& terrain, Goal& goal,
+                             glm::vec2 startPosition, float ballRadius,
+                             int numThreads)
+    : terrain(terrain),
+      goal(goal),
+      startPosition(startPosition),
+      ballRadius(ballRadius),
+      numThreads(std::max(1, numThreads)) {}
+
+ShardedSolver::~ShardedSolver() {
+  cancel();
+  wait();
+}
+
+void ShardedSolver::start(const std::vector<ShotParams>& shots, int chunkSize,
+                          int liveBalls, float maxShotTime) {
+  wait();
+
+  this->shots = shots;
+  this->liveBalls = std::max(1, liveBalls);
+  this->maxShotTime = maxShotTime;
+  distances = std::vector<float>(keepResults ? shots.size() : 0);
+  states = std::vector<uint8_t>(keepResults ? shots.size() : 0);
+  numCompleted = 0;
+  numSteps = 0;
+  cancelled = false;
+
+  // no point in starting more threads than there are chunks
+  chunkSize = std::max(1, chunkSize);
+  int numChunks = (shots.size() + chunkSize - 1) / chunkSize;
+  int numWorkers = std::max(1, std::min(numThreads, numChunks));
+
+  workQueue.reset(shots.size(), chunkSize, numWorkers);
+  if (integrators.size() < numWorkers) {
+    integrators.resize(numWorkers);
+  }
+  numRunning = numWorkers;
+  for (int i = 0; i < numWorkers; i++) {
+    workers.emplace_back(&ShardedSolver::runWorker, this, i);
+  }
+}
+
+void ShardedSolver::wait() {
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+}
+
+void ShardedSolver::cancel() {
+  cancelled = true;
+  workQueue.clear();
+}
+
+void ShardedSolver::setBackend(SolverBackend backend) {
+  if (backend != this->backend) integrators.clear();
+  this->backend = backend;
+}
+
+void ShardedSolver::setAutoTune(bool autoTune) {
+  if (autoTune != this->autoTune) integrators.clear();
+  this->autoTune = autoTune;
+}
+
+void ShardedSolver::setUseFlightStage(bool useFlightStage) {
+  if (useFlightStage != this->useFlightStage) integrators.clear();
+  this->useFlightStage = useFlightStage;
+}
+
+std::vector<float> ShardedSolver::solve(const std::vector<ShotParams>& shots,
+                                        int chunkSize, int liveBalls,
+                                        float maxShotTime) {
+  start(shots, chunkSize, liveBalls, maxShotTime);
+  wait();
+  return distances;
+}
+
+void ShardedSolver::runWorker(int worker) {
+  // the integrator (and with it any physics world) is only ever used by this
+  // worker, so nothing in it is shared with the other workers
+  std::unique_ptr<ShotIntegrator>& integrator = integrators[worker];
+  if (integrator == nullptr) {
+    if (backend == SolverBackend::RP3D) {
+      auto solver = std::make_unique<BatchSolver>(terrain, goal, startPosition,
+                                                  ballRadius);
+      solver->setAutoTune(autoTune);
+      solver->setUseFlightStage(useFlightStage);
+      integrator = std::move(solver);
+    } else {
+      integrator = std::make_unique<HeightFieldIntegrator>(
+          terrain, goal, startPosition, ballRadius);
+    }
+  }
+  integrator->setStartPosition(startPosition);
+  integrator->setPrune(prune);
+  long long stepsBefore = integrator->getNumSteps();
+
+  // chunks never overlap, so the results can be written without locking
+  integrator->run(
+      shots,
+      [&](WorkChunk& chunk) {
+        return !cancelled && workQueue.pop(worker, chunk);
+      },
+      [&](int index, float distance, BallState state, glm::vec3 position) {
+        if (keepResults) {
+          distances[index] = distance;
+          states[index] = static_cast<uint8_t>(state);
+        }
+        if (stream != nullptr) {
+          stream->push(index, distance, state, position);
+        }
+        numCompleted++;
+      },
+      liveBalls, maxShotTime);
+
+  numSteps += integrator->getNumSteps() - stepsBefore;
+  numRunning--;
+}
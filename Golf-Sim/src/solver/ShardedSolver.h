@@ -0,0 +1,110 @@
+#pragma once
+
+#include "solver/ShotIntegrator.h"
+#include "solver/Sweep.h"
+#include "solver/WorkQueue.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class Terrain;
+class Goal;
+class ResultStream;
+
+// splits a list of shots across worker threads that each run their own
+// ShotIntegrator (for the reactphysics3d backend, their own physics world and
+// copies of the terrain and goal colliders). balls never collide with each
+// other, so every shot can be simulated in any world and the results are
+// simply written back by index
+//
+// each worker keeps its integrator (and physics world) from one solve to the
+// next, so the terrain and goal must not be regenerated for as long as the
+// solver is used. only the start position can be moved between solves
+class ShardedSolver {
+ public:
+  ShardedSolver(Terrain& terrain, Goal& goal, glm::vec2 startPosition,
+                float ballRadius, int numThreads);
+  ~ShardedSolver();
+
+  // starts solving in the background, handing the shots out in chunks of
+  // chunkSize (each worker keeps about liveBalls balls in flight)
+  void start(const std::vector<ShotParams>& shots, int chunkSize,
+             int liveBalls, float maxShotTime);
+  void wait();
+  // stops handing out chunks; chunks that already started still finish
+  void cancel();
+
+  // blocking version of start, returning the final distance of each shot from
+  // the goal in the same order as shots
+  std::vector<float> solve(const std::vector<ShotParams>& shots, int chunkSize,
+                           int liveBalls, float maxShotTime);
+
+  // see ShotIntegrator::setStartPosition. only between solves
+  void setStartPosition(glm::vec2 startPosition) {
+    this->startPosition = startPosition;
+  }
+  // changing these between solves rebuilds the integrators
+  void setBackend(SolverBackend backend);
+  // see BatchSolver::setAutoTune
+  void setAutoTune(bool autoTune);
+  // see BatchSolver::setUseFlightStage
+  void setUseFlightStage(bool useFlightStage);
+  // see ShotIntegrator::setPrune
+  void setPrune(bool prune) { this->prune = prune; }
+  // also pushes every shot to the stream as soon as it finishes (nullptr for
+  // none). without keepResults getDistances and getStates stay empty, so
+  // memory use doesn't grow with the number of shots. the stream has to stay
+  // open until the solve has finished
+  void setStream(ResultStream* stream, bool keepResults = true) {
+    this->stream = stream;
+    this->keepResults = keepResults;
+  }
+
+  bool isRunning() { return numRunning > 0; }
+  bool isCancelled() { return cancelled; }
+  int getNumThreads() { return numThreads; }
+  float getBallRadius() { return ballRadius; }
+  int getNumShots() { return shots.size(); }
+  int getNumCompleted() { return numCompleted; }
+  long long getNumSteps() { return numSteps; }
+  // only valid once the solve has finished without being cancelled (and
+  // results are kept)
+  const std::vector<float>& getDistances() { return distances; }
+  // the BallState each shot ended in, valid at the same time as getDistances
+  const std::vector<uint8_t>& getStates() { return states; }
+
+ private:
+  Terrain& terrain;
+  Goal& goal;
+  glm::vec2 startPosition;
+  float ballRadius;
+  int numThreads;
+
+  std::vector<ShotParams> shots;
+  std::vector<float> distances;
+  std::vector<uint8_t> states;
+  int liveBalls = 0;
+  float maxShotTime = 0;
+  SolverBackend backend = SolverBackend::RP3D;
+  bool autoTune = true;
+  bool useFlightStage = true;
+  bool prune = false;
+  ResultStream* stream = nullptr;
+  bool keepResults = true;
+
+  WorkQueue workQueue;
+  std::vector<std::thread> workers;
+  // one per worker, created by the worker on its first solve
+  std::vector<std::unique_ptr<ShotIntegrator>> integrators;
+  std::atomic<int> numRunning{0};
+  std::atomic<int> numCompleted{0};
+  std::atomic<long long> numSteps{0};
+  std::atomic<bool> cancelled{false};
+
+  void runWorker(int worker);
+};
@@ -0,0 +1,22 @@
+#include "ShotIntegrator.h"
+
+const char* getBackendName(SolverBackend backend) {
+  switch (backend) {
+    case SolverBackend::RP3D:
+      return "rp3d";
+    case SolverBackend::HEIGHT_FIELD:
+      return "heightfield";
+  }
+  return "";
+}
+
+bool parseBackendName(const std::string& name, SolverBackend& backend) {
+  for (SolverBackend candidate :
+       {SolverBackend::RP3D, SolverBackend::HEIGHT_FIELD}) {
+    if (name == getBackendName(candidate)) {
+      backend = candidate;
+      return true;
+    }
+  }
+  return false;
+}
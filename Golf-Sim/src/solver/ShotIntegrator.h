@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ball/Ball.h"
+#include "solver/Sweep.h"
+#include "solver/WorkQueue.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// hands out the next chunk of shot indices, returning false once there are
+// none left
+using ShotSource = std::function<bool(WorkChunk& chunk)>;
+// receives the final distance from the goal of a finished shot, along with the
+// state and position its ball ended in (still ACTIVE if it was cut off, and
+// PRUNED if the distance is only a lower bound and the position is where it was
+// stopped)
+using ShotSink = std::function<void(int index, float distance, BallState state,
+                                    glm::vec3 position)>;
+
+// physics used to simulate the shots of a sweep
+enum class SolverBackend {
+  // reactphysics3d, the same physics the simulator shows
+  RP3D,
+  // HeightFieldIntegrator, which only knows about balls on the height map and
+  // the goal's cup
+  HEIGHT_FIELD
+};
+
+// simulates shots without any rendering, one thread per integrator
+class ShotIntegrator {
+ public:
+  virtual ~ShotIntegrator() = default;
+
+  // simulates the shots handed out by nextChunk with about liveBalls of them
+  // in flight at once, reporting each one to onSolved as it finishes (a shot
+  // is cut off once it has run for maxShotTime simulated seconds)
+  virtual void run(const std::vector<ShotParams>& shots,
+                   const ShotSource& nextChunk, const ShotSink& onSolved,
+                   int liveBalls, float maxShotTime) = 0;
+
+  virtual long long getNumSteps() = 0;
+
+  // when enabled, shots are stopped as soon as a ShotPruner rules out the goal
+  // and reported as PRUNED, with a lower bound on their distance
+  void setPrune(bool prune) { this->prune = prune; }
+  // moves where the shots of the following runs are launched from
+  void setStartPosition(glm::vec2 startPosition) {
+    this->startPosition = startPosition;
+  }
+
+ protected:
+  explicit ShotIntegrator(glm::vec2 startPosition)
+      : startPosition(startPosition) {}
+
+  glm::vec2 startPosition;
+  bool prune = false;
+};
+
+const char* getBackendName(SolverBackend backend);
+// returns false if the name isn't one of getBackendName's
+bool parseBackendName(const std::string& name, SolverBackend& backend);
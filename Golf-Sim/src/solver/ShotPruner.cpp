@@ -0,0 +1,178 @@
+#include "ShotPruner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+#include "ball/Ball.h"
+#include "goal/Goal.h"
+#include "terrain/Terrain.h"
+
+void ShotPruner::build(Terrain& terrain, Goal& goal, float ballRadius,
+                       float gravity) {
+  const float INFINITE_HEIGHT = std::numeric_limits<float>::infinity();
+
+  glm::vec3 terrainPos = terrain.getPosition();
+  numCols = terrain.getNumCols();
+  numRows = terrain.getNumRows();
+  left = terrainPos.x - terrain.getWidth() / 2;
+  bottom = terrainPos.z - terrain.getHeight() / 2;
+  hSpacing = terrain.getHSpacing();
+  vSpacing = terrain.getVSpacing();
+  this->ballRadius = ballRadius;
+  this->gravity = gravity;
+  outOfBoundsHeight = terrainPos.y + terrain.getMinHeight();
+
+  glm::vec2 goalPos = goal.getAbsolutePosition(terrain);
+  float nearRadius = goal.getRadius() + ballRadius;
+  holedDistance = std::max(0.0f, goal.getRadius() - ballRadius);
+  // a ball that leaves the map ends up off it, so at least as far from the
+  // goal as the closest edge
+  edgeDistance = std::max(
+      0.0f, std::min({goalPos.x - left, left + terrain.getWidth() - goalPos.x,
+                      goalPos.y - bottom,
+                      bottom + terrain.getHeight() - goalPos.y}));
+
+  // the terrain's triangles never go below the lowest corner of their cell,
+  // and the physics height map is lower where the goal's footprint is sunk
+  auto getVertexHeight = [&](int col, int row) {
+    return std::min(terrain.getHeight(col, row),
+                    terrain.getPhysicsHeight(col, row));
+  };
+
+  int numCells = numCols * numRows;
+  std::vector<float> floors(numCells);
+  std::vector<float> distances(numCells);
+  barriers.assign(numCells, INFINITE_HEIGHT);
+
+  // cells the ball can end in the goal from start at -infinity, and the rest
+  // get the highest floor along the lowest path to one of them
+  using Entry = std::pair<float, int>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  for (int row = 0; row < numRows; row++) {
+    for (int col = 0; col < numCols; col++) {
+      int cell = row * numCols + col;
+      floors[cell] =
+          terrainPos.y + std::min({getVertexHeight(col, row),
+                                   getVertexHeight(col + 1, row),
+                                   getVertexHeight(col, row + 1),
+                                   getVertexHeight(col + 1, row + 1)});
+
+      glm::vec2 cellMin(left + col * hSpacing, bottom + row * vSpacing);
+      glm::vec2 closest =
+          glm::clamp(goalPos, cellMin, cellMin + glm::vec2(hSpacing, vSpacing));
+      distances[cell] = glm::length(closest - goalPos);
+      if (distances[cell] < nearRadius) {
+        barriers[cell] = -INFINITE_HEIGHT;
+        queue.push(Entry(barriers[cell], cell));
+      }
+    }
+  }
+
+  // the goal isn't on the map, so nothing can be ruled out
+  enabled = !queue.empty();
+  if (!enabled) return;
+
+  while (!queue.empty()) {
+    Entry entry = queue.top();
+    queue.pop();
+    int cell = entry.second;
+    if (entry.first > barriers[cell]) continue;
+
+    int col = cell % numCols;
+    int row = cell / numCols;
+    // cells that only share a corner are neighbours too, since a ball can
+    // cross right through the corner
+    for (int dRow = -1; dRow <= 1; dRow++) {
+      for (int dCol = -1; dCol <= 1; dCol++) {
+        int nCol = col + dCol;
+        int nRow = row + dRow;
+        if (nCol < 0 || nCol >= numCols || nRow < 0 || nRow >= numRows) {
+          continue;
+        }
+
+        int neighbour = nRow * numCols + nCol;
+        float barrier = std::max(barriers[cell], floors[neighbour]);
+        if (barrier < barriers[neighbour]) {
+          barriers[neighbour] = barrier;
+          queue.push(Entry(barrier, neighbour));
+        }
+      }
+    }
+  }
+
+  std::vector<int> order(numCells);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](int a, int b) { return barriers[a] > barriers[b]; });
+
+  sortedBarriers.clear();
+  minDistances.clear();
+  sortedEdgeBarriers.clear();
+  minEdgeDistances.clear();
+  for (int cell : order) {
+    int col = cell % numCols;
+    int row = cell / numCols;
+    bool onEdge =
+        col == 0 || col == numCols - 1 || row == 0 || row == numRows - 1;
+    std::vector<float>& sorted = onEdge ? sortedEdgeBarriers : sortedBarriers;
+    std::vector<float>& minimums = onEdge ? minEdgeDistances : minDistances;
+
+    sorted.push_back(barriers[cell]);
+    minimums.push_back(minimums.empty()
+                           ? distances[cell]
+                           : std::min(minimums.back(), distances[cell]));
+  }
+}
+
+bool ShotPruner::canPrune(glm::vec3 position, glm::vec3 velocity,
+                          glm::vec3 angularVelocity, float& distanceBound) {
+  if (!enabled) return false;
+
+  float x = (position.x - left) / hSpacing;
+  float z = (position.z - bottom) / vSpacing;
+  if (!(x >= 0 && x < numCols && z >= 0 && z < numRows)) return false;
+  int cell = static_cast<int>(z) * numCols + static_cast<int>(x);
+
+  // kinetic energy per unit mass of a solid sphere (I = 2/5 m r^2), as the
+  // height it could lift the ball by
+  float energy = 0.5f * glm::dot(velocity, velocity) +
+                 0.2f * ballRadius * ballRadius *
+                     glm::dot(angularVelocity, angularVelocity);
+  float climb = energy / gravity * (1 + ENERGY_MARGIN) + HEIGHT_MARGIN;
+  // the terrain right below a ball is always at least a radius below its
+  // center, so this is the highest terrain the ball can ever be over
+  float reach = position.y + climb - ballRadius;
+  if (barriers[cell] <= reach) return false;
+
+  // every cell the ball can get to from here has a barrier above its reach.
+  // a ball that leaves the map through an edge cell can still drift sideways
+  // until it falls out of bounds, but with nothing left to push it, damping
+  // stops it within its speed over the damping (and its speed is bounded by
+  // how far it can fall)
+  float fallHeight = std::max(0.0f, reach + ballRadius - outOfBoundsHeight);
+  float drift = std::sqrt(2 * gravity * fallHeight) / Ball::LINEAR_DAMPING;
+  float edgeBound = std::max(
+      getMinDistance(sortedEdgeBarriers, minEdgeDistances, reach) - drift,
+      edgeDistance);
+  distanceBound = std::min(
+      getMinDistance(sortedBarriers, minDistances, reach), edgeBound);
+  // the ball can't end in the goal, so its bound must never read as holed
+  distanceBound = std::max(holedDistance, distanceBound);
+  return true;
+}
+
+float ShotPruner::getMinDistance(const std::vector<float>& sorted,
+                                 const std::vector<float>& distances,
+                                 float height) {
+  // number of cells with a barrier above the height
+  int count = std::lower_bound(sorted.begin(), sorted.end(), height,
+                               std::greater<float>()) -
+              sorted.begin();
+  if (count == 0) return std::numeric_limits<float>::infinity();
+  return distances[count - 1];
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class Terrain;
+class Goal;
+
+// conservative early termination for shots that can no longer end in the goal
+//
+// damping, friction and bounces only ever take energy away from a ball, so it
+// can never get higher than the height its kinetic plus potential energy would
+// lift it to, and it stays in whatever part of the terrain is below that
+// height around it. build finds, for every cell of the height map, the lowest
+// height a ball has to clear to get from the cell to the goal (the highest
+// point of the lowest path between them), so checking a ball is one lookup
+//
+// a pruned ball also gets a lower bound on its final distance: the distance
+// from the goal to the closest cell it could still reach, and never less than
+// the distance a shot counts as holed at
+class ShotPruner {
+ public:
+  // the ball is assumed to be able to climb this much higher (relative to the
+  // height its energy lifts it by, and absolute), which covers the energy the
+  // physics adds when pushing balls out of the terrain and integration error
+  const float ENERGY_MARGIN = 0.1f;
+  const float HEIGHT_MARGIN = 0.1f;
+
+  // reads the terrain's height maps (including the goal's sunk footprint) and
+  // the goal, which must not change until the next build
+  void build(Terrain& terrain, Goal& goal, float ballRadius, float gravity);
+
+  // returns true if a ball with the given state can never end in the goal,
+  // setting distanceBound to a lower bound on its final distance from it.
+  // balls that are off the map are never pruned
+  bool canPrune(glm::vec3 position, glm::vec3 velocity,
+                glm::vec3 angularVelocity, float& distanceBound);
+
+ private:
+  bool enabled = false;
+  int numCols = 0;
+  int numRows = 0;
+  float left = 0;
+  float bottom = 0;
+  float hSpacing = 1;
+  float vSpacing = 1;
+  float ballRadius = 0;
+  float gravity = 0;
+  float outOfBoundsHeight = 0;
+  // distance below which a shot counts as holed, and from the goal to the
+  // closest edge of the map
+  float holedDistance = 0;
+  float edgeDistance = 0;
+
+  // per cell, the lowest height the bottom of a ball has to clear to get to
+  // the goal (-infinity for the cells the ball can go in from)
+  std::vector<float> barriers;
+  // barriers sorted from highest to lowest, and the smallest distance from
+  // the goal of any cell up to that point in the order. cells on the edge of
+  // the map are kept separately, since balls can leave the map through them
+  std::vector<float> sortedBarriers;
+  std::vector<float> minDistances;
+  std::vector<float> sortedEdgeBarriers;
+  std::vector<float> minEdgeDistances;
+
+  float getMinDistance(const std::vector<float>& sorted,
+                       const std::vector<float>& distances, float height);
+};
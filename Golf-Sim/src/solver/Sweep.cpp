@@ -0,0 +1,72 @@
+#include "Sweep.h"
+
+#include <glm/gtx/rotate_vector.hpp>
+
+#include "goal/Goal.h"
+#include "terrain/Terrain.h"
+
+const float PI = 3.14159265f;
+
+ShotParams SweepConfig::getShotParams(int index) const {
+  const float POWER_DIV = (maxPower - minPower) / (numDivisions - 1);
+  const float YAW_OFFSET_DIV = (maxYaw - minYaw) / (numDivisions - 1);
+  const float PITCH_DIV = (maxPitch - minPitch) / (numDivisions - 1);
+
+  int i = index / (numDivisions * numDivisions);
+  int j = (index / numDivisions) % numDivisions;
+  int k = index % numDivisions;
+
+  return ShotParams{minPower + POWER_DIV * i, minYaw + YAW_OFFSET_DIV * j,
+                    minPitch + PITCH_DIV * k};
+}
+
+std::vector<ShotParams> SweepConfig::getShots() const {
+  std::vector<ShotParams> shots;
+  if (sampling == SamplingMode::GRID) {
+    shots.reserve(getNumShots());
+    for (int i = 0; i < getNumShots(); i++) {
+      shots.push_back(getShotParams(i));
+    }
+    return shots;
+  }
+
+  std::vector<glm::vec3> samples =
+      getUnitSamples(sampling, numSamples, samplingSeed);
+  shots.reserve(samples.size());
+  for (const glm::vec3& sample : samples) {
+    shots.push_back(ShotParams{minPower + (maxPower - minPower) * sample.x,
+                               minYaw + (maxYaw - minYaw) * sample.y,
+                               minPitch + (maxPitch - minPitch) * sample.z});
+  }
+  return shots;
+}
+
+glm::vec3 getLaunchPosition(Terrain& terrain, glm::vec2 startPosition,
+                            float ballRadius) {
+  glm::vec2 startPositionAbs = terrain.convertUV(startPosition);
+
+  return glm::vec3(startPositionAbs.x,
+                   terrain.getHeightFromRelative(
+                       glm::vec2(startPosition.x * terrain.getWidth(),
+                                 startPosition.y * terrain.getHeight())) +
+                       terrain.getPosition().y + ballRadius * 2,
+                   startPositionAbs.y);
+}
+
+glm::vec3 getLaunchVelocity(Terrain& terrain, Goal& goal,
+                            glm::vec2 startPosition, ShotParams shot) {
+  float yawOffset = shot.yawOffset * PI / 180;
+  float pitch = shot.pitch * PI / 180;
+
+  glm::vec2 startPositionAbs = terrain.convertUV(startPosition);
+  glm::vec2 dirVector =
+      glm::normalize(goal.getAbsolutePosition(terrain) - startPositionAbs);
+  glm::vec2 perpVector(-dirVector.y, dirVector.x);
+
+  glm::vec2 rotatedYawDir = glm::rotate(dirVector, yawOffset);
+  glm::vec2 rotatedPerp = glm::rotate(perpVector, yawOffset);
+  glm::vec3 rotatedDir =
+      glm::rotate(glm::vec3(rotatedYawDir.x, 0, rotatedYawDir.y), pitch,
+                  glm::vec3(rotatedPerp.x, 0, rotatedPerp.y));
+  return rotatedDir * shot.power;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "solver/Sampling.h"
+
+class Terrain;
+class Goal;
+
+// a single golf shot, with yaw offset and pitch given in degrees
+struct ShotParams {
+  float power;
+  float yawOffset;
+  float pitch;
+};
+
+// shots over the power / yaw offset / pitch ranges: either a uniform grid,
+// indexed in power-major, pitch-minor order (the order the .golf output file
+// expects), or numSamples shots from one of the other sampling modes
+struct SweepConfig {
+  SamplingMode sampling = SamplingMode::GRID;
+  int numDivisions = 10;
+  int numSamples = 1000;
+  uint32_t samplingSeed = 0;
+  float minPower = 20.0;
+  float maxPower = 25.0;
+  float minYaw = -15.0f;
+  float maxYaw = 15.0f;
+  float minPitch = 30.0;
+  float maxPitch = 60.0f;
+
+  int getNumShots() const {
+    if (sampling != SamplingMode::GRID) return numSamples;
+    return numDivisions * numDivisions * numDivisions;
+  }
+  // only for GRID sampling
+  ShotParams getShotParams(int index) const;
+  // every shot of the sweep, in the order they should be simulated
+  std::vector<ShotParams> getShots() const;
+};
+
+// simulates the given shots, filling in the final distance and BallState of
+// each one
+using ShotEvaluator =
+    std::function<void(const std::vector<ShotParams>& shots,
+                       std::vector<float>& distances,
+                       std::vector<uint8_t>& states)>;
+
+// position a ball of the given radius is launched from for a start position
+// given in relative (0 - 1) terrain coordinates
+glm::vec3 getLaunchPosition(Terrain& terrain, glm::vec2 startPosition,
+                            float ballRadius);
+glm::vec3 getLaunchVelocity(Terrain& terrain, Goal& goal,
+                            glm::vec2 startPosition, ShotParams shot);
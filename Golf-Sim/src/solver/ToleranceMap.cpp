@@ -0,0 +1,217 @@
+#include "ToleranceMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+// squared euclidean distance: f(x, i) = (x - i)^2 + g(i)
+struct EuclideanMetric {
+  static int64_t f(int64_t x, int64_t i, int64_t g) {
+    return (x - i) * (x - i) + g;
+  }
+  static int64_t sep(int64_t i, int64_t u, int64_t gi, int64_t gu) {
+    int64_t numerator = u * u - i * i + gu - gi;
+    int64_t denominator = 2 * (u - i);
+    // floor division, the numerator can be negative
+    return numerator >= 0 ? numerator / denominator
+                          : -((-numerator + denominator - 1) / denominator);
+  }
+};
+
+// chessboard distance: f(x, i) = max(|x - i|, g(i))
+struct ChessboardMetric {
+  static int64_t f(int64_t x, int64_t i, int64_t g) {
+    return std::max(std::abs(x - i), g);
+  }
+  static int64_t sep(int64_t i, int64_t u, int64_t gi, int64_t gu) {
+    if (gi <= gu) {
+      return std::max(i + gu, (i + u) / 2);
+    }
+    return std::min(u - gi, (i + u) / 2);
+  }
+};
+
+// one pass of Meijster's algorithm along a line of length n: replaces g(i)
+// with min over i of f(x, i) for every x
+template <typename Metric>
+void transformLine(int64_t* line, int n, std::vector<int>& s,
+                   std::vector<int>& t, std::vector<int64_t>& g) {
+  g.assign(line, line + n);
+
+  int q = 0;
+  s[0] = 0;
+  t[0] = 0;
+  for (int u = 1; u < n; u++) {
+    while (q >= 0 &&
+           Metric::f(t[q], s[q], g[s[q]]) > Metric::f(t[q], u, g[u])) {
+      q--;
+    }
+    if (q < 0) {
+      q = 0;
+      s[0] = u;
+    } else {
+      int64_t w = 1 + Metric::sep(s[q], u, g[s[q]], g[u]);
+      if (w < n) {
+        q++;
+        s[q] = u;
+        t[q] = static_cast<int>(w);
+      }
+    }
+  }
+
+  for (int u = n - 1; u >= 0; u--) {
+    line[u] = Metric::f(u, s[q], g[s[q]]);
+    if (u == t[q]) q--;
+  }
+}
+
+// runs transformLine over every line of the grid along one axis
+template <typename Metric>
+void transformAxis(std::vector<int64_t>& values, int n, int axis,
+                   int numThreads) {
+  int stride = axis == 0 ? n * n : (axis == 1 ? n : 1);
+  int numLines = n * n;
+
+  auto transformLines = [&](int begin, int end) {
+    std::vector<int> s(n), t(n);
+    std::vector<int64_t> g, line(n);
+    for (int l = begin; l < end; l++) {
+      // first element of line l, with the other two axes given by l
+      int a = l / n, b = l % n;
+      int first;
+      if (axis == 0) {
+        first = a * n + b;
+      } else if (axis == 1) {
+        first = a * n * n + b;
+      } else {
+        first = a * n * n + b * n;
+      }
+
+      for (int i = 0; i < n; i++) line[i] = values[first + i * stride];
+      transformLine<Metric>(line.data(), n, s, t, g);
+      for (int i = 0; i < n; i++) values[first + i * stride] = line[i];
+    }
+  };
+
+  numThreads = std::max(1, std::min(numThreads, numLines));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++) {
+    threads.emplace_back(transformLines, numLines * i / numThreads,
+                         numLines * (i + 1) / numThreads);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// distance from a grid point to the nearest point outside of the grid
+int getBorderDistance(int index, int n) {
+  int i = index / (n * n);
+  int j = (index / n) % n;
+  int k = index % n;
+  return std::min({i + 1, n - i, j + 1, n - j, k + 1, n - k});
+}
+
+template <typename Metric>
+std::vector<int64_t> transform(const std::vector<uint8_t>& inside, int n,
+                               int64_t infinity, int numThreads) {
+  std::vector<int64_t> values(inside.size());
+  for (size_t i = 0; i < inside.size(); i++) {
+    values[i] = inside[i] ? infinity : 0;
+  }
+  for (int axis = 2; axis >= 0; axis--) {
+    transformAxis<Metric>(values, n, axis, numThreads);
+  }
+  return values;
+}
+
+}  // namespace
+
+std::vector<float> computeEuclideanMargins(const std::vector<uint8_t>& inside,
+                                           int n, int numThreads) {
+  // large enough to never be the nearest, small enough that squared distances
+  // added to it can't overflow
+  const int64_t INFINITE_DISTANCE = int64_t(1) << 40;
+  std::vector<int64_t> squared =
+      transform<EuclideanMetric>(inside, n, INFINITE_DISTANCE, numThreads);
+
+  std::vector<float> margins(inside.size());
+  for (size_t i = 0; i < inside.size(); i++) {
+    if (!inside[i]) continue;
+    margins[i] = std::min(std::sqrt(static_cast<float>(squared[i])),
+                          static_cast<float>(getBorderDistance(i, n)));
+  }
+  return margins;
+}
+
+std::vector<int> computeChessboardMargins(const std::vector<uint8_t>& inside,
+                                          int n, int numThreads) {
+  const int64_t INFINITE_DISTANCE = int64_t(1) << 40;
+  std::vector<int64_t> distances =
+      transform<ChessboardMetric>(inside, n, INFINITE_DISTANCE, numThreads);
+
+  std::vector<int> margins(inside.size());
+  for (size_t i = 0; i < inside.size(); i++) {
+    if (!inside[i]) continue;
+    margins[i] = static_cast<int>(
+        std::min<int64_t>(distances[i], getBorderDistance(i, n)));
+  }
+  return margins;
+}
+
+std::vector<ToleranceShot> rankTolerances(const std::vector<uint8_t>& inside,
+                                          const std::vector<float>& distances,
+                                          int n, int maxShots,
+                                          int numThreads) {
+  std::vector<float> radii = computeEuclideanMargins(inside, n, numThreads);
+  std::vector<int> boxes = computeChessboardMargins(inside, n, numThreads);
+
+  std::vector<ToleranceShot> shots;
+  for (size_t i = 0; i < inside.size(); i++) {
+    if (!inside[i]) continue;
+    // the nearest miss is boxes[i] steps away, so the box reaches one less
+    shots.push_back(
+        ToleranceShot{static_cast<int>(i), distances[i], radii[i],
+                      boxes[i] - 1});
+  }
+
+  auto moreForgiving = [](const ToleranceShot& a, const ToleranceShot& b) {
+    if (a.radius != b.radius) return a.radius > b.radius;
+    if (a.boxSteps != b.boxSteps) return a.boxSteps > b.boxSteps;
+    return a.distance < b.distance;
+  };
+  if (maxShots > 0 && maxShots < shots.size()) {
+    std::partial_sort(shots.begin(), shots.begin() + maxShots, shots.end(),
+                      moreForgiving);
+    shots.resize(maxShots);
+  } else {
+    std::sort(shots.begin(), shots.end(), moreForgiving);
+  }
+  return shots;
+}
+
+void writeToleranceFile(std::ostream& fout, const SweepConfig& sweepConfig,
+                        const std::vector<ToleranceShot>& shots) {
+  const int n = sweepConfig.numDivisions;
+  const float POWER_DIV =
+      (sweepConfig.maxPower - sweepConfig.minPower) / (n - 1);
+  const float YAW_OFFSET_DIV =
+      (sweepConfig.maxYaw - sweepConfig.minYaw) / (n - 1);
+  const float PITCH_DIV =
+      (sweepConfig.maxPitch - sweepConfig.minPitch) / (n - 1);
+
+  fout << "# rank power yaw pitch distance radius_steps box_steps "
+          "power_margin yaw_margin pitch_margin"
+       << std::endl;
+  for (int rank = 0; rank < shots.size(); rank++) {
+    const ToleranceShot& shot = shots[rank];
+    ShotParams params = sweepConfig.getShotParams(shot.index);
+    fout << rank + 1 << " " << params.power << " " << params.yawOffset << " "
+         << params.pitch << " " << shot.distance << " " << shot.radius << " "
+         << shot.boxSteps << " " << shot.boxSteps * POWER_DIV << " "
+         << shot.boxSteps * YAW_OFFSET_DIV << " " << shot.boxSteps * PITCH_DIV
+         << std::endl;
+  }
+}
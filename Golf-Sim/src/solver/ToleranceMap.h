@@ -0,0 +1,45 @@
+#pragma once
+
+#include "solver/Sweep.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// margin of error of a shot that ends in the goal: how far its parameters can
+// move (in grid steps) before a shot misses
+struct ToleranceShot {
+  // index of the shot in the grid, in SweepConfig index order
+  int index;
+  float distance;
+  // every shot closer than this (in steps, with each parameter's step counted
+  // as 1) to the shot also goes in
+  float radius;
+  // every shot within this many steps of the shot along each parameter goes
+  // in, so the shot can be off by up to boxSteps steps of every parameter at
+  // once
+  int boxSteps;
+};
+
+// distance transforms over an n * n * n grid of shots (in SweepConfig index
+// order) where inside is 1 for shots that go in. each gives, for shots that go
+// in, the distance to the nearest shot that doesn't, with everything outside
+// of the grid counted as a miss (and 0 for misses). both are Meijster's linear
+// time algorithm, one axis at a time, split over numThreads threads
+std::vector<float> computeEuclideanMargins(const std::vector<uint8_t>& inside,
+                                           int n, int numThreads);
+// same with the chessboard distance (the largest difference along any axis)
+std::vector<int> computeChessboardMargins(const std::vector<uint8_t>& inside,
+                                          int n, int numThreads);
+
+// every shot that goes in, with its margins, from the most to the least
+// forgiving (by radius, then boxSteps, then distance from the goal). at most
+// maxShots shots are returned unless it is 0
+std::vector<ToleranceShot> rankTolerances(const std::vector<uint8_t>& inside,
+                                          const std::vector<float>& distances,
+                                          int n, int maxShots, int numThreads);
+
+// text list of ranked shots, one per line, with the box margin also given in
+// the units of each parameter
+void writeToleranceFile(std::ostream& fout, const SweepConfig& sweepConfig,
+                        const std::vector<ToleranceShot>& shots);
@@ -0,0 +1,48 @@
+#include "WorkQueue.h"
+
+#include <algorithm>
+
+void WorkQueue::reset(int numShots, int chunkSize, int numWorkers) {
+  queues.clear();
+  for (int i = 0; i < numWorkers; i++) {
+    queues.push_back(std::make_unique<WorkerQueue>());
+  }
+
+  int numChunks = (numShots + chunkSize - 1) / chunkSize;
+  for (int i = 0; i < numChunks; i++) {
+    WorkChunk chunk{i * chunkSize, std::min(numShots, (i + 1) * chunkSize)};
+    int worker = static_cast<long long>(i) * numWorkers / numChunks;
+    queues[worker]->chunks.push_back(chunk);
+  }
+}
+
+void WorkQueue::clear() {
+  for (auto& queue : queues) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->chunks.clear();
+  }
+}
+
+bool WorkQueue::pop(int worker, WorkChunk& chunk) {
+  {
+    WorkerQueue& own = *queues[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.chunks.empty()) {
+      chunk = own.chunks.front();
+      own.chunks.pop_front();
+      return true;
+    }
+  }
+
+  for (int i = 1; i < queues.size(); i++) {
+    WorkerQueue& other = *queues[(worker + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if (!other.chunks.empty()) {
+      chunk = other.chunks.back();
+      other.chunks.pop_back();
+      return true;
+    }
+  }
+
+  return false;
+}
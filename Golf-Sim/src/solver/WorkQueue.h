@@ -0,0 +1,32 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// a contiguous range [begin, end) of shot indices
+struct WorkChunk {
+  int begin;
+  int end;
+};
+
+// work-stealing queue of shot chunks: every worker starts with its own
+// contiguous run of chunks and takes from the front of it, and once that runs
+// out it steals from the back of another worker's run
+class WorkQueue {
+ public:
+  void reset(int numShots, int chunkSize, int numWorkers);
+  void clear();
+
+  // returns false once there is no work left for any worker
+  bool pop(int worker, WorkChunk& chunk);
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<WorkChunk> chunks;
+  };
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+};
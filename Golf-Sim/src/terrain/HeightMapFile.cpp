@@ -0,0 +1,104 @@
+#include "HeightMapFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+bool MappedHeightMap::open(const std::string& path) {
+  if (!file.openRead(path)) {
+    return false;
+  }
+  if (file.getSize() < sizeof(HeightMapHeader)) {
+    std::cout << "ERROR: " << path << " is not a height map file" << std::endl;
+    close();
+    return false;
+  }
+  std::memcpy(&header, file.getData(), sizeof(header));
+  if (std::memcmp(header.magic, HEIGHTMAP_MAGIC, sizeof(HEIGHTMAP_MAGIC)) !=
+          0 ||
+      header.headerSize < sizeof(HeightMapHeader)) {
+    std::cout << "ERROR: " << path << " is not a height map file" << std::endl;
+    close();
+    return false;
+  }
+  if (header.version != HEIGHTMAP_VERSION) {
+    std::cout << "ERROR: " << path << " has unsupported version "
+              << header.version << std::endl;
+    close();
+    return false;
+  }
+  if (header.format != HeightMapFormat::FLOAT32 &&
+      header.format != HeightMapFormat::INT16) {
+    std::cout << "ERROR: " << path << " has unknown sample format "
+              << static_cast<uint32_t>(header.format) << std::endl;
+    close();
+    return false;
+  }
+  if (header.numCols == 0 || header.numRows == 0 || header.width <= 0 ||
+      header.height <= 0) {
+    std::cout << "ERROR: " << path << " has an empty terrain" << std::endl;
+    close();
+    return false;
+  }
+
+  size_t sampleSize = header.format == HeightMapFormat::INT16 ? 2 : 4;
+  uint64_t numSamples = (static_cast<uint64_t>(header.numCols) + 1) *
+                        (static_cast<uint64_t>(header.numRows) + 1);
+  if (header.headerSize + numSamples * sampleSize > file.getSize()) {
+    std::cout << "ERROR: " << path << " is missing samples" << std::endl;
+    close();
+    return false;
+  }
+  // the samples are read in place, so they have to be aligned
+  if (header.headerSize % sampleSize != 0) {
+    std::cout << "ERROR: " << path << " has misaligned samples" << std::endl;
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool writeHeightMapFile(const std::string& path, HeightMapFormat format,
+                        int numCols, int numRows, float width, float height,
+                        const std::vector<float>& heights) {
+  HeightMapHeader header = {};
+  std::memcpy(header.magic, HEIGHTMAP_MAGIC, sizeof(header.magic));
+  header.version = HEIGHTMAP_VERSION;
+  header.headerSize = sizeof(HeightMapHeader);
+  header.format = format;
+  header.numCols = numCols;
+  header.numRows = numRows;
+  header.width = width;
+  header.height = height;
+  header.heightScale = 1.0f;
+  header.heightOffset = 0.0f;
+
+  size_t sampleSize = format == HeightMapFormat::INT16 ? 2 : 4;
+  MappedFile file;
+  if (!file.create(path, sizeof(header) + heights.size() * sampleSize)) {
+    return false;
+  }
+
+  if (format == HeightMapFormat::INT16) {
+    auto range = std::minmax_element(heights.begin(), heights.end());
+    float minHeight = heights.empty() ? 0.0f : *range.first;
+    float maxHeight = heights.empty() ? 0.0f : *range.second;
+    header.heightOffset = (minHeight + maxHeight) / 2;
+    header.heightScale = std::max((maxHeight - minHeight) / 65534, 1e-9f);
+
+    int16_t* samples =
+        reinterpret_cast<int16_t*>(file.getData() + sizeof(header));
+    for (size_t i = 0; i < heights.size(); i++) {
+      float value =
+          std::round((heights[i] - header.heightOffset) / header.heightScale);
+      samples[i] =
+          static_cast<int16_t>(std::min(std::max(value, -32767.0f), 32767.0f));
+    }
+  } else {
+    std::memcpy(file.getData() + sizeof(header), heights.data(),
+                heights.size() * sizeof(float));
+  }
+  std::memcpy(file.getData(), &header, sizeof(header));
+  return true;
+}
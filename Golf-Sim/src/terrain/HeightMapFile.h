@@ -0,0 +1,73 @@
+#pragma once
+
+#include "util/MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// height map file (.golfh) for surveyed or exported terrain: this header, then
+// (numRows + 1) x (numCols + 1) little-endian samples, row-major from the
+// terrain's -x / -z corner, starting at headerSize. float32 samples are
+// heights, int16 samples give heightScale * value + heightOffset
+const char HEIGHTMAP_MAGIC[4] = {'G', 'O', 'L', 'H'};
+const uint32_t HEIGHTMAP_VERSION = 1;
+
+enum class HeightMapFormat : uint32_t { FLOAT32 = 0, INT16 = 1 };
+
+struct HeightMapHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t headerSize;
+  HeightMapFormat format;
+  // cells, one less than the samples per row / column
+  uint32_t numCols;
+  uint32_t numRows;
+  // size of the terrain in world units
+  float width;
+  float height;
+  float heightScale;
+  float heightOffset;
+  uint32_t padding[2];
+};
+static_assert(sizeof(HeightMapHeader) == 48,
+              "height map header must be 48 bytes");
+
+// a height map file mapped into memory, so nothing is read until the samples
+// are used. the file is only read through once, by Terrain::loadHeightMap
+// converting the samples into its own height map, with no intermediate buffer
+class MappedHeightMap {
+ public:
+  // returns false (after printing an error) if the file isn't a valid height
+  // map file
+  bool open(const std::string& path);
+  void close() { file.close(); }
+
+  const HeightMapHeader& getHeader() { return header; }
+  // height of a sample, wherever it is in the mapping
+  float getHeight(int col, int row) {
+    long long index = row * (static_cast<long long>(header.numCols) + 1) + col;
+    if (header.format == HeightMapFormat::INT16) {
+      return header.heightScale * getInt16Samples()[index] +
+             header.heightOffset;
+    }
+    return getFloatSamples()[index];
+  }
+  const float* getFloatSamples() {
+    return reinterpret_cast<const float*>(file.getData() + header.headerSize);
+  }
+  const int16_t* getInt16Samples() {
+    return reinterpret_cast<const int16_t*>(file.getData() +
+                                            header.headerSize);
+  }
+
+ private:
+  MappedFile file;
+  HeightMapHeader header = {};
+};
+
+// writes (numRows + 1) x (numCols + 1) heights as a height map file. int16
+// files spread the 16 bits over the range of the heights
+bool writeHeightMapFile(const std::string& path, HeightMapFormat format,
+                        int numCols, int numRows, float width, float height,
+                        const std::vector<float>& heights);
@@ -1,5 +1,7 @@
 #include "PerlinNoise.h"
 
+#include "util/CpuFeatures.h"
+
 bool noise::initialized = false;
 int noise::p[512];
 int noise::permutation[] = {
@@ -65,3 +67,205 @@ double noise::noise(double x, double y, double z) {
            lerp(u, grad(p[AB + 1], x, y - 1, z - 1),
                 grad(p[BB + 1], x - 1, y - 1, z - 1))));
 }
+
+#ifdef CPU_X86_64
+namespace {
+
+// the same operations as their scalar versions, in the same order, so each
+// lane rounds exactly like noise does
+TARGET_AVX2 __m256d fade4(__m256d t) {
+  __m256d inner = _mm256_add_pd(
+      _mm256_mul_pd(t, _mm256_sub_pd(_mm256_mul_pd(t, _mm256_set1_pd(6)),
+                                     _mm256_set1_pd(15))),
+      _mm256_set1_pd(10));
+  return _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(t, t), t), inner);
+}
+
+TARGET_AVX2 __m256d lerp4(__m256d t, __m256d a, __m256d b) {
+  return _mm256_add_pd(a, _mm256_mul_pd(t, _mm256_sub_pd(b, a)));
+}
+
+// widens a mask of 4 int32 lanes to 4 double lanes
+TARGET_AVX2 __m256d widenMask(__m128i mask) {
+  return _mm256_castsi256_pd(_mm256_cvtepi32_epi64(mask));
+}
+
+TARGET_AVX2 __m256d grad4(__m128i hash, __m256d x, __m256d y, __m256d z) {
+  __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+  __m256d u = _mm256_blendv_pd(
+      y, x, widenMask(_mm_cmplt_epi32(h, _mm_set1_epi32(8))));
+  __m256d xOrZ = _mm256_blendv_pd(
+      z, x,
+      widenMask(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)),
+                             _mm_cmpeq_epi32(h, _mm_set1_epi32(14)))));
+  __m256d v = _mm256_blendv_pd(
+      xOrZ, y, widenMask(_mm_cmplt_epi32(h, _mm_set1_epi32(4))));
+
+  // negating is flipping the sign bit, which is exact
+  __m256d signBit = _mm256_set1_pd(-0.0);
+  __m128i one = _mm_set1_epi32(1);
+  __m128i two = _mm_set1_epi32(2);
+  __m256d negateU =
+      widenMask(_mm_cmpeq_epi32(_mm_and_si128(h, one), one));
+  __m256d negateV =
+      widenMask(_mm_cmpeq_epi32(_mm_and_si128(h, two), two));
+  u = _mm256_xor_pd(u, _mm256_and_pd(negateU, signBit));
+  v = _mm256_xor_pd(v, _mm256_and_pd(negateV, signBit));
+  return _mm256_add_pd(u, v);
+}
+
+TARGET_AVX2 __m128i lookup4(__m128i index) {
+  return _mm_i32gather_epi32(noise::p, index, 4);
+}
+
+// with y and z fixed, each corner's gradient within one x lattice cell is
+// ((x & mask) ^ sign) + constant, which adds exactly the same two values grad
+// does (a corner that doesn't use x at all gets -0 + constant)
+struct CellCorners {
+  long long mask[8];
+  double sign[8];
+  double constant[8];
+};
+
+void getCellCorners(int X, int Y, int Z, double y, double z,
+                    CellCorners& corners) {
+  using noise::p;
+  int A = p[X] + Y, AA = p[A] + Z, AB = p[A + 1] + Z, B = p[X + 1] + Y,
+      BA = p[B] + Z, BB = p[B + 1] + Z;
+  int hashes[8] = {p[AA],     p[BA],     p[AB],     p[BB],
+                   p[AA + 1], p[BA + 1], p[AB + 1], p[BB + 1]};
+  for (int k = 0; k < 8; k++) {
+    double yc = (k & 2) ? y - 1 : y;
+    double zc = (k & 4) ? z - 1 : z;
+    int h = hashes[k] & 15;
+    if (h < 8) {
+      double v = h < 4 ? yc : zc;
+      corners.mask[k] = -1;
+      corners.sign[k] = (h & 1) == 0 ? 0.0 : -0.0;
+      corners.constant[k] = (h & 2) == 0 ? v : -v;
+    } else if (h == 12 || h == 14) {
+      corners.mask[k] = -1;
+      corners.sign[k] = (h & 2) == 0 ? 0.0 : -0.0;
+      corners.constant[k] = (h & 1) == 0 ? yc : -yc;
+    } else {
+      corners.mask[k] = 0;
+      corners.sign[k] = -0.0;
+      corners.constant[k] =
+          ((h & 1) == 0 ? yc : -yc) + ((h & 2) == 0 ? zc : -zc);
+    }
+  }
+}
+
+TARGET_AVX2 __m256d cornerGrad4(const CellCorners& corners, int k,
+                                __m256d x) {
+  __m256d masked = _mm256_and_pd(
+      x, _mm256_castsi256_pd(_mm256_set1_epi64x(corners.mask[k])));
+  return _mm256_add_pd(
+      _mm256_xor_pd(masked, _mm256_set1_pd(corners.sign[k])),
+      _mm256_set1_pd(corners.constant[k]));
+}
+
+// noise at 4 points along x at a time. y and z are the same for the whole
+// row, so only the x lattice cells differ between lanes, and most of the time
+// all 4 lanes are in the same cell and can share its corners
+TARGET_AVX2 int noiseRowAvx2(double x0, double dx, double y, double z,
+                             int count, double* out) {
+  int Y = ((int)floor(y)) & 255;
+  int Z = ((int)floor(z)) & 255;
+  y -= floor(y);
+  z -= floor(z);
+
+  __m256d yv = _mm256_set1_pd(y);
+  __m256d zv = _mm256_set1_pd(z);
+  __m256d v = _mm256_set1_pd(noise::fade(y));
+  __m256d w = _mm256_set1_pd(noise::fade(z));
+  __m256d one = _mm256_set1_pd(1);
+  __m256d yMinus1 = _mm256_sub_pd(yv, one);
+  __m256d zMinus1 = _mm256_sub_pd(zv, one);
+  __m128i Yv = _mm_set1_epi32(Y);
+  __m128i Zv = _mm_set1_epi32(Z);
+  __m128i oneI = _mm_set1_epi32(1);
+
+  CellCorners corners;
+  int cornersX = -1;
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d index = _mm256_add_pd(_mm256_set1_pd(i),
+                                  _mm256_set_pd(3, 2, 1, 0));
+    __m256d x = _mm256_add_pd(_mm256_set1_pd(x0),
+                              _mm256_mul_pd(index, _mm256_set1_pd(dx)));
+    __m256d floorX = _mm256_floor_pd(x);
+    __m128i X = _mm_and_si128(_mm256_cvttpd_epi32(floorX),
+                              _mm_set1_epi32(255));
+    x = _mm256_sub_pd(x, floorX);
+    __m256d u = fade4(x);
+    __m256d xMinus1 = _mm256_sub_pd(x, one);
+
+    __m128i firstX = _mm_shuffle_epi32(X, 0);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(X, firstX)) == 0xFFFF) {
+      int cellX = _mm_cvtsi128_si32(X);
+      if (cellX != cornersX) {
+        getCellCorners(cellX, Y, Z, y, z, corners);
+        cornersX = cellX;
+      }
+      __m256d result = lerp4(
+          w,
+          lerp4(v,
+                lerp4(u, cornerGrad4(corners, 0, x),
+                      cornerGrad4(corners, 1, xMinus1)),
+                lerp4(u, cornerGrad4(corners, 2, x),
+                      cornerGrad4(corners, 3, xMinus1))),
+          lerp4(v,
+                lerp4(u, cornerGrad4(corners, 4, x),
+                      cornerGrad4(corners, 5, xMinus1)),
+                lerp4(u, cornerGrad4(corners, 6, x),
+                      cornerGrad4(corners, 7, xMinus1))));
+      _mm256_storeu_pd(out + i, result);
+      continue;
+    }
+
+    __m128i A = _mm_add_epi32(lookup4(X), Yv);
+    __m128i AA = _mm_add_epi32(lookup4(A), Zv);
+    __m128i AB = _mm_add_epi32(lookup4(_mm_add_epi32(A, oneI)), Zv);
+    __m128i B = _mm_add_epi32(lookup4(_mm_add_epi32(X, oneI)), Yv);
+    __m128i BA = _mm_add_epi32(lookup4(B), Zv);
+    __m128i BB = _mm_add_epi32(lookup4(_mm_add_epi32(B, oneI)), Zv);
+
+    __m256d result = lerp4(
+        w,
+        lerp4(v,
+              lerp4(u, grad4(lookup4(AA), x, yv, zv),
+                    grad4(lookup4(BA), xMinus1, yv, zv)),
+              lerp4(u, grad4(lookup4(AB), x, yMinus1, zv),
+                    grad4(lookup4(BB), xMinus1, yMinus1, zv))),
+        lerp4(v,
+              lerp4(u, grad4(lookup4(_mm_add_epi32(AA, oneI)), x, yv, zMinus1),
+                    grad4(lookup4(_mm_add_epi32(BA, oneI)), xMinus1, yv,
+                          zMinus1)),
+              lerp4(u,
+                    grad4(lookup4(_mm_add_epi32(AB, oneI)), x, yMinus1,
+                          zMinus1),
+                    grad4(lookup4(_mm_add_epi32(BB, oneI)), xMinus1, yMinus1,
+                          zMinus1))));
+    _mm256_storeu_pd(out + i, result);
+  }
+  return i;
+}
+
+}  // namespace
+#endif
+
+void noise::noiseRow(double x0, double dx, double y, double z, int count,
+                     double* out) {
+  int i = 0;
+#ifdef CPU_X86_64
+  if (hasAvx2()) {
+    i = noiseRowAvx2(x0, dx, y, z, count, out);
+  }
+#endif
+  // whatever doesn't fill a whole vector
+  for (; i < count; i++) {
+    out[i] = noise(x0 + i * dx, y, z);
+  }
+}
@@ -1,19 +1,28 @@
 #include "Terrain.h"
 
 #include "goal/Goal.h"
+#include "terrain/HeightMapFile.h"
 #include "terrain/TerrainModel.h"
+#ifndef GOLF_HEADLESS
 #include "terrain/TerrainRenderer.h"
+#endif
 
 #include "util/CollisionCategory.h"
+#ifndef GOLF_HEADLESS
+#include "IconsFontAwesome.h"
 #include "ImGuiConstants.h"
-
-#include "PerlinNoise.h"
+#include "ImGuiFileDialog.h"
+#endif
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <thread>
 
 Terrain::Terrain(glm::vec3 position, int numCols, int numRows, float mapWidth,
                  float mapHeight, float noiseFreq, float noiseAmp)
@@ -23,37 +32,29 @@ Terrain::Terrain(glm::vec3 position, int numCols, int numRows, float mapWidth,
       mapHeight(mapHeight),
       position(position),
       color(0.1f, 0.35f, 0.1f),
+      physicsMinHeight(0.0),
       minHeight(0.0),
       maxHeight(0.0),
       noiseFreq(noiseFreq),
-      noiseAmp(noiseAmp),
-      rigidBody(nullptr),
-      collider(nullptr) {}
+      noiseAmp(noiseAmp) {}
 
-void Terrain::generateModel(Goal& goal) {
+bool Terrain::generateModel(Goal& goal) {
   if (heightMap.size() > 0) {
     freeModel();
   }
 
-  noise::initNoise();
-  srand(noiseSeed);
-  float offsetX = rand() / 2;
-  float offsetY = rand() / 2;
-
-  heightMap = std::vector<float>((numRows + 1) * (numCols + 1));
-
-  minHeight = -noiseAmp;
-  maxHeight = noiseAmp;
-
-  for (int j = 0; j <= numCols; j++) {
-    for (int i = 0; i <= numRows; i++) {
-      float x = j * getHSpacing() - this->mapWidth / 2;
-      float z = i * getVSpacing() - this->mapHeight / 2;
-
-      float height = noise::noise(x / noiseFreq + offsetX, -5, z / noiseFreq + offsetY) * noiseAmp;
+  bool loaded = !heightMapPath.empty() && loadHeightMap(heightMapPath);
+  if (!heightMapPath.empty() && !loaded) {
+    std::cout << "ERROR: using generated terrain instead of " << heightMapPath
+              << std::endl;
+  }
+  if (!loaded) {
+    generator.generate(
+        NoiseGrid{numCols, numRows, mapWidth, mapHeight, noiseFreq, noiseSeed},
+        noiseAmp, heightMap);
 
-      heightMap[i * (static_cast<long long>(numCols) + 1) + j] = height;
-    }
+    minHeight = -noiseAmp * generator.getAmplitudeBound();
+    maxHeight = -minHeight;
   }
 
   // std::cout << std::fixed;
@@ -68,21 +69,77 @@ void Terrain::generateModel(Goal& goal) {
   //   std::cout << std::endl;
   // }
 
+  planes.build(heightMap, numCols, numRows, getHSpacing(), getVSpacing());
+  physicsHeightMap = heightMap;
+  physicsMinHeight = minHeight - GOAL_SINK_DEPTH;
+  footprintColStart = footprintColEnd = 0;
+  footprintRowStart = footprintRowEnd = 0;
+  buildChunks();
+
   terrainModel.generateModel(&heightMap, numCols, numRows, mapWidth,
                              mapHeight, goal.getRelativePosition(), goal.getRadius());
+  return heightMapPath.empty() || loaded;
+}
+
+bool Terrain::loadHeightMap(const std::string& path) {
+  MappedHeightMap file;
+  if (!file.open(path)) {
+    return false;
+  }
+  const HeightMapHeader& header = file.getHeader();
+  if (header.numCols > MAX_FILE_RESOLUTION ||
+      header.numRows > MAX_FILE_RESOLUTION) {
+    std::cout << "ERROR: " << path << " has more than " << MAX_FILE_RESOLUTION
+              << " cells per side" << std::endl;
+    return false;
+  }
+
+  numCols = header.numCols;
+  numRows = header.numRows;
+  mapWidth = header.width;
+  mapHeight = header.height;
+
+  // straight from the mapping into the height map, which only touches each
+  // page of the file once and leaves nothing behind when it is unmapped
+  size_t numSamples = (numRows + 1) * (static_cast<size_t>(numCols) + 1);
+  heightMap.resize(numSamples);
+  if (header.format == HeightMapFormat::INT16) {
+    const int16_t* samples = file.getInt16Samples();
+    for (size_t i = 0; i < numSamples; i++) {
+      heightMap[i] = header.heightScale * samples[i] + header.heightOffset;
+    }
+  } else {
+    const float* samples = file.getFloatSamples();
+    std::copy(samples, samples + numSamples, heightMap.begin());
+  }
+
+  auto range = std::minmax_element(heightMap.begin(), heightMap.end());
+  minHeight = *range.first;
+  maxHeight = *range.second;
+  return true;
+}
+
+bool Terrain::exportHeightMap(const std::string& path,
+                              HeightMapFormat format) {
+  return writeHeightMapFile(path, format, numCols, numRows, mapWidth,
+                            mapHeight, heightMap);
 }
 
 void Terrain::freeModel() {
   heightMap.clear();
+  physicsHeightMap.clear();
+  chunks.clear();
+  planes.clear();
   terrainModel.freeModel();
 }
 
 void Terrain::update(GLCore::Timestep ts, float interpolationFactor) {
-  if (this->rigidBody == nullptr || interpolationFactor == -1) {
+  if (physics.rigidBody == nullptr || interpolationFactor == -1) {
     return;
   }
 }
 
+#ifndef GOLF_HEADLESS
 void Terrain::render(TerrainRenderer& renderer, glm::vec2 startPosition, float highlightRadius, glm::vec3 highlightColor) {
   glm::vec2 startPos = convertUV(startPosition);
   renderer.add(TerrainRenderJob{terrainModel, position, color, startPos, highlightRadius, highlightColor});
@@ -98,7 +155,7 @@ void Terrain::imGuiRender(Goal& goal,
         reactphysics3d::Quaternion::identity();
     reactphysics3d::Transform newTransform(position, orientation);
 
-    rigidBody->setTransform(newTransform);
+    physics.rigidBody->setTransform(newTransform);
   }
   ImGui::ColorEdit3("Color", glm::value_ptr(color));
 
@@ -109,9 +166,9 @@ void Terrain::imGuiRender(Goal& goal,
   ImGui::SameLine();
   ImGui::DragFloat("Height", &mapHeight, 1.0, 1, 100);
 
-  ImGui::DragInt("# Cols", &numCols, 1.0, 1, 100);
+  ImGui::DragInt("# Cols", &numCols, 1.0, 1, MAX_RESOLUTION);
   ImGui::SameLine();
-  ImGui::DragInt("# Rows", &numRows, 1.0, 1, 100);
+  ImGui::DragInt("# Rows", &numRows, 1.0, 1, MAX_RESOLUTION);
 
   ImGui::DragFloat("Noise Freq", &noiseFreq, 0.5f, 0.01f, 20.0f);
   ImGui::SameLine();
@@ -119,10 +176,85 @@ void Terrain::imGuiRender(Goal& goal,
 
   ImGui::InputInt("Noise Random Seed", &noiseSeed, 1.0f);
 
+  const char* modeNames[] = {getNoiseModeName(NoiseMode::FBM),
+                             getNoiseModeName(NoiseMode::RIDGED),
+                             getNoiseModeName(NoiseMode::DOMAIN_WARP)};
+  int mode = static_cast<int>(generator.mode);
+  if (ImGui::Combo("Noise Mode", &mode, modeNames, IM_ARRAYSIZE(modeNames))) {
+    generator.mode = static_cast<NoiseMode>(mode);
+  }
+  ImGui::DragInt("# Octaves", &generator.numOctaves, 0.1f, 1,
+                 TerrainGenerator::MAX_OCTAVES);
+  ImGui::SameLine();
+  ImGui::DragFloat("Lacunarity", &generator.lacunarity, 0.05f, 1.0f, 4.0f);
+  if (generator.mode == NoiseMode::DOMAIN_WARP) {
+    ImGui::DragFloat("Warp Strength", &generator.warpStrength, 0.05f, 0.0f,
+                     4.0f);
+  }
+
+  // the octaves are cached, so new amplitudes only have to be blended again
+  // and can be shown right away
+  bool ampsChanged = false;
+  for (int k = 0; k < generator.numOctaves; k++) {
+    std::string label = "Octave " + std::to_string(k + 1);
+    ampsChanged |= ImGui::DragFloat(label.c_str(), &generator.octaveAmps[k],
+                                    0.01f, -2.0f, 2.0f);
+    if (k % 2 == 0 && k != generator.numOctaves - 1) ImGui::SameLine();
+  }
+
   ImGui::PopItemWidth();
 
+  ImGui::NewLine();
+
+  // surveyed terrain replaces the noise, and sets the size and resolution
+  bool heightMapChanged = false;
+  if (ImGui::Button(ICON_FA_FOLDER_OPEN " Load Height Map")) {
+    const char* filters = "Height Map File (*.golfh){.golfh}";
+    ImGuiFileDialog::Instance()->OpenDialog(
+        "LoadHeightMap", ICON_FA_FOLDER_OPEN " Select Height Map", filters,
+        ".", "", 1, IGFDUserDatas("OpenFile"));
+  }
+  if (!heightMapPath.empty()) {
+    ImGui::SameLine();
+    if (ImGui::Button("Use Noise")) {
+      heightMapPath.clear();
+      heightMapChanged = true;
+    }
+    ImGui::Text("%s", heightMapPath.c_str());
+  }
+  if (ImGui::Button(ICON_FA_FLOPPY_DISK " Export Height Map")) {
+    const char* filters = "Height Map File (*.golfh){.golfh}";
+    ImGuiFileDialog::Instance()->OpenDialog(
+        "ExportHeightMap", ICON_FA_FLOPPY_DISK " Select Height Map File",
+        filters, ".", "terrain", 1, IGFDUserDatas("SaveFile"),
+        ImGuiFileDialogFlags_ConfirmOverwrite);
+  }
+  ImGui::SameLine();
+  ImGui::Checkbox("16 Bit", &exportInt16);
+
+  ImVec2 maxSize = ImGui::GetIO().DisplaySize;
+  ImVec2 minSize = ImVec2(maxSize.x / 2.0, maxSize.y / 2.0);
+  if (ImGuiFileDialog::Instance()->Display(
+          "LoadHeightMap", ImGuiWindowFlags_NoDocking, minSize, maxSize)) {
+    if (ImGuiFileDialog::Instance()->IsOk()) {
+      heightMapPath = ImGuiFileDialog::Instance()->GetFilePathName();
+      heightMapChanged = true;
+    }
+    ImGuiFileDialog::Instance()->Close();
+  }
+  if (ImGuiFileDialog::Instance()->Display(
+          "ExportHeightMap", ImGuiWindowFlags_NoDocking, minSize, maxSize)) {
+    if (ImGuiFileDialog::Instance()->IsOk()) {
+      exportHeightMap(
+          ImGuiFileDialog::Instance()->GetFilePathName() + ".golfh",
+          exportInt16 ? HeightMapFormat::INT16 : HeightMapFormat::FLOAT32);
+    }
+    ImGuiFileDialog::Instance()->Close();
+  }
+
   setupGreenButton();
-  if (ImGui::Button("Regenerate Terrain")) {
+  if (ImGui::Button("Regenerate Terrain") || ampsChanged ||
+      heightMapChanged) {
     generateModel(goal);
     removePhysics(physicsWorld, physicsCommon);
     addPhysics(physicsWorld, physicsCommon);
@@ -133,80 +265,211 @@ void Terrain::imGuiRender(Goal& goal,
   }
   clearButtonStyle();
 }
+#endif
 
 void Terrain::addPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
                          reactphysics3d::PhysicsCommon& physicsCommon) {
-  reactphysics3d::Vector3 position(position.x, position.y, position.z);
+  physics = createPhysics(physicsWorld, physicsCommon);
+}
+
+void Terrain::removePhysics(reactphysics3d::PhysicsWorld* physicsWorld,
+                            reactphysics3d::PhysicsCommon& physicsCommon) {
+  destroyPhysics(physics, physicsWorld, physicsCommon);
+}
+
+TerrainPhysics Terrain::createPhysics(
+    reactphysics3d::PhysicsWorld* physicsWorld,
+    reactphysics3d::PhysicsCommon& physicsCommon, bool lazyChunks) {
+  TerrainPhysics physics;
+
+  reactphysics3d::Vector3 physicsPosition(position.x, position.y, position.z);
   reactphysics3d::Quaternion orientation =
       reactphysics3d::Quaternion::identity();
-  reactphysics3d::Transform transform(position, orientation);
+  reactphysics3d::Transform transform(physicsPosition, orientation);
 
-  this->rigidBody = physicsWorld->createRigidBody(transform);
-  this->rigidBody->setType(reactphysics3d::BodyType::STATIC);
+  physics.rigidBody = physicsWorld->createRigidBody(transform);
+  physics.rigidBody->setType(reactphysics3d::BodyType::STATIC);
 
-  reactphysics3d::Vector3 scaling(mapWidth / numCols, 1.0, mapHeight / numRows);
-  this->shape = physicsCommon.createHeightFieldShape(
-      numCols + 1, numRows + 1, minHeight, maxHeight, heightMap.data(),
-      reactphysics3d::HeightFieldShape::HeightDataType::HEIGHT_FLOAT_TYPE, 1,
-      1.0f, scaling);
-  reactphysics3d::Transform shapeTransform =
-      reactphysics3d::Transform::identity();
+  physics.colliders.assign(chunks.size(), nullptr);
+  physics.shapes.assign(chunks.size(), nullptr);
+  if (!lazyChunks) {
+    for (int i = 0; i < chunks.size(); i++) {
+      loadChunk(physics, physicsCommon, i);
+    }
+  }
 
-  this->collider = this->rigidBody->addCollider(shape, shapeTransform);
-  this->collider->setCollisionCategoryBits(CollisionCategory::TERRAIN);
-  this->collider->setCollideWithMaskBits(CollisionCategory::BALL);
-  this->collider->getMaterial().setBounciness(0.2);
-  this->collider->getMaterial().setFrictionCoefficient(0.6);
+  return physics;
 }
 
-void Terrain::removePhysics(reactphysics3d::PhysicsWorld* physicsWorld,
-                            reactphysics3d::PhysicsCommon& physicsCommon) {
-  physicsWorld->destroyRigidBody(rigidBody);
-  physicsCommon.destroyHeightFieldShape(shape);
+void Terrain::loadChunks(TerrainPhysics& physics,
+                         reactphysics3d::PhysicsCommon& physicsCommon,
+                         glm::vec2 min, glm::vec2 max) {
+  float left = position.x - mapWidth / 2;
+  float top = position.z - mapHeight / 2;
+  if (max.x < left || max.y < top || min.x > left + mapWidth ||
+      min.y > top + mapHeight) {
+    return;
+  }
 
-  rigidBody = nullptr;
-  shape = nullptr;
+  float chunkWidth = CHUNK_CELLS * getHSpacing();
+  float chunkHeight = CHUNK_CELLS * getVSpacing();
+  int colStart = std::max(0, static_cast<int>((min.x - left) / chunkWidth));
+  int colEnd = std::min(numChunkCols - 1,
+                        static_cast<int>((max.x - left) / chunkWidth));
+  int rowStart = std::max(0, static_cast<int>((min.y - top) / chunkHeight));
+  int rowEnd = std::min(numChunkRows - 1,
+                        static_cast<int>((max.y - top) / chunkHeight));
+  for (int row = rowStart; row <= rowEnd; row++) {
+    for (int col = colStart; col <= colEnd; col++) {
+      int index = row * numChunkCols + col;
+      if (physics.colliders[index] == nullptr) {
+        loadChunk(physics, physicsCommon, index);
+      }
+    }
+  }
 }
 
-// finds the straight down projection of p onto the plane formed by a, b, c
-float projectToPlane(glm::vec2 p, glm::vec3 a, glm::vec3 b, glm::vec3 c) {
-  glm::vec3 A = b - a;
-  glm::vec3 B = c - a;
-  glm::vec3 C = glm::cross(A, B);
-  return (C.x * (a.x - p.x) + C.z * (a.z - p.y) + C.y * a.y) / C.y;
+void Terrain::loadChunk(TerrainPhysics& physics,
+                        reactphysics3d::PhysicsCommon& physicsCommon,
+                        int index) {
+  TerrainChunk& chunk = chunks[index];
+
+  reactphysics3d::Vector3 scaling(mapWidth / numCols, 1.0, mapHeight / numRows);
+  reactphysics3d::HeightFieldShape* shape =
+      physicsCommon.createHeightFieldShape(
+          chunk.numCols + 1, chunk.numRows + 1, physicsMinHeight, maxHeight,
+          chunk.heights.data(),
+          reactphysics3d::HeightFieldShape::HeightDataType::HEIGHT_FLOAT_TYPE,
+          1, 1.0f, scaling);
+  // the height field is centered on its middle cell and between its min and
+  // max height, which are no longer symmetric once the goal's footprint is
+  // sunk
+  float centerX =
+      (chunk.colStart + (chunk.numCols - numCols) / 2.0f) * getHSpacing();
+  float centerZ =
+      (chunk.rowStart + (chunk.numRows - numRows) / 2.0f) * getVSpacing();
+  reactphysics3d::Transform shapeTransform(
+      reactphysics3d::Vector3(centerX, (physicsMinHeight + maxHeight) / 2,
+                              centerZ),
+      reactphysics3d::Quaternion::identity());
+
+  reactphysics3d::Collider* collider =
+      physics.rigidBody->addCollider(shape, shapeTransform);
+  collider->setCollisionCategoryBits(CollisionCategory::TERRAIN);
+  collider->setCollideWithMaskBits(CollisionCategory::BALL);
+  collider->getMaterial().setBounciness(0.2);
+  collider->getMaterial().setFrictionCoefficient(0.6);
+
+  physics.shapes[index] = shape;
+  physics.colliders[index] = collider;
 }
 
-void printVec3(glm::vec3 vec) {
-  std::cout << vec.x << " : " << vec.y << " : " << vec.z << std::endl;
+void Terrain::destroyPhysics(TerrainPhysics& physics,
+                             reactphysics3d::PhysicsWorld* physicsWorld,
+                             reactphysics3d::PhysicsCommon& physicsCommon) {
+  if (physics.rigidBody != nullptr) {
+    physicsWorld->destroyRigidBody(physics.rigidBody);
+  }
+  for (reactphysics3d::HeightFieldShape* shape : physics.shapes) {
+    if (shape != nullptr) {
+      physicsCommon.destroyHeightFieldShape(shape);
+    }
+  }
+
+  physics = TerrainPhysics();
 }
 
-float Terrain::getHeightFromRelative(glm::vec2 rel) {
-  float x = rel.x;
-  float y = rel.y;
+void Terrain::buildChunks() {
+  numChunkCols = (numCols + CHUNK_CELLS - 1) / CHUNK_CELLS;
+  numChunkRows = (numRows + CHUNK_CELLS - 1) / CHUNK_CELLS;
+  chunks = std::vector<TerrainChunk>(numChunkCols * numChunkRows);
+
+  auto buildRange = [this](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      TerrainChunk& chunk = chunks[i];
+      chunk.colStart = (i % numChunkCols) * CHUNK_CELLS;
+      chunk.rowStart = (i / numChunkCols) * CHUNK_CELLS;
+      chunk.numCols = std::min(CHUNK_CELLS, numCols - chunk.colStart);
+      chunk.numRows = std::min(CHUNK_CELLS, numRows - chunk.rowStart);
+      chunk.heights.resize((chunk.numRows + 1) *
+                           static_cast<long long>(chunk.numCols + 1));
+
+      for (int row = 0; row <= chunk.numRows; row++) {
+        const float* source =
+            &physicsHeightMap[(chunk.rowStart + row) *
+                                  (static_cast<long long>(numCols) + 1) +
+                              chunk.colStart];
+        std::copy(source, source + chunk.numCols + 1,
+                  &chunk.heights[row * (chunk.numCols + 1)]);
+      }
+    }
+  };
 
-  float hSpacing = getHSpacing();
-  float vSpacing = getVSpacing();
+  // only worth threads when there are enough chunks to go around
+  int numThreads = 1;
+  if (chunks.size() >= 4) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::min(numThreads, static_cast<int>(chunks.size()));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < numThreads; i++) {
+    threads.emplace_back(buildRange, chunks.size() * i / numThreads,
+                         chunks.size() * (i + 1) / numThreads);
+  }
+  buildRange(0, chunks.size() / numThreads);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
 
-  int col = x / hSpacing;
-  int row = y / vSpacing;
+void Terrain::setPhysicsHeight(int col, int row, float height) {
+  physicsHeightMap[row * (static_cast<long long>(numCols) + 1) + col] = height;
+
+  // vertices on the edge between chunks are in both of them
+  int chunkColEnd = std::min(col / CHUNK_CELLS, numChunkCols - 1);
+  int chunkColStart =
+      col % CHUNK_CELLS == 0 && col > 0 ? col / CHUNK_CELLS - 1 : chunkColEnd;
+  int chunkRowEnd = std::min(row / CHUNK_CELLS, numChunkRows - 1);
+  int chunkRowStart =
+      row % CHUNK_CELLS == 0 && row > 0 ? row / CHUNK_CELLS - 1 : chunkRowEnd;
+  for (int chunkRow = chunkRowStart; chunkRow <= chunkRowEnd; chunkRow++) {
+    for (int chunkCol = chunkColStart; chunkCol <= chunkColEnd; chunkCol++) {
+      TerrainChunk& chunk = chunks[chunkRow * numChunkCols + chunkCol];
+      chunk.heights[(row - chunk.rowStart) * (chunk.numCols + 1) + col -
+                    chunk.colStart] = height;
+    }
+  }
+}
 
-  float ax = x - hSpacing * col;
-  float ay = y - vSpacing * row;
+void Terrain::setGoalFootprint(int colStart, int colEnd, int rowStart,
+                               int rowEnd) {
+  auto setVertices = [this](int colStart, int colEnd, int rowStart,
+                            int rowEnd, bool sunk) {
+    for (int row = std::max(0, rowStart); row <= std::min(numRows, rowEnd);
+         row++) {
+      for (int col = std::max(0, colStart); col <= std::min(numCols, colEnd);
+           col++) {
+        setPhysicsHeight(col, row,
+                         sunk ? physicsMinHeight : getHeight(col, row));
+      }
+    }
+  };
 
-  bool isTopRight = ay * hSpacing > -vSpacing * ax + vSpacing * hSpacing;
-  // std::cout << x << " : " << y << " : " << col << " : " << row << " : " <<
-  // isTopRight << std::endl;
+  if (footprintColEnd > footprintColStart &&
+      footprintRowEnd > footprintRowStart) {
+    setVertices(footprintColStart, footprintColEnd, footprintRowStart,
+                footprintRowEnd, false);
+  }
 
-  float tl = col * hSpacing;
-  float tr = (col + 1) * hSpacing;
-  float tb = row * vSpacing;
-  float tt = (row + 1) * vSpacing;
-  glm::vec3 topLeft = glm::vec3(tl, getHeight(col, row + 1), tt);
-  glm::vec3 topRight = glm::vec3(tr, getHeight(col + 1, row + 1), tt);
-  glm::vec3 botLeft = glm::vec3(tl, getHeight(col, row), tb);
-  glm::vec3 botRight = glm::vec3(tr, getHeight(col + 1, row), tb);
-  float height = isTopRight ? projectToPlane(rel, topLeft, topRight, botRight)
-                            : projectToPlane(rel, topLeft, botRight, botLeft);
+  footprintColStart = colStart;
+  footprintColEnd = colEnd;
+  footprintRowStart = rowStart;
+  footprintRowEnd = rowEnd;
+  if (colEnd > colStart && rowEnd > rowStart) {
+    setVertices(colStart, colEnd, rowStart, rowEnd, true);
+  }
+}
 
-  return height;
+void printVec3(glm::vec3 vec) {
+  std::cout << vec.x << " : " << vec.y << " : " << vec.z << std::endl;
 }
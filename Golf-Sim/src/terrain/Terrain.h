@@ -1,22 +1,59 @@
 #pragma once
 
+#include "terrain/HeightMapFile.h"
+#include "terrain/TerrainGenerator.h"
 #include "terrain/TerrainModel.h"
+#include "terrain/TerrainPlanes.h"
 
-#include <GlCore.h>
+#include <GLCore/Core/Timestep.h>
 #include <glm/glm.hpp>
 #include <reactphysics3d/reactphysics3d.h>
 
+#include <string>
 #include <vector>
 
 
 class Goal;
 class TerrainRenderer;
 
+// a rectangle of cells of the physics height map with its own copy of their
+// heights, which one height field shape per physics world reads from
+struct TerrainChunk {
+  int colStart;
+  int rowStart;
+  int numCols;
+  int numRows;
+  // (numRows + 1) x (numCols + 1) vertices, row-major
+  std::vector<float> heights;
+};
+
+// physics objects for one copy of the terrain in a physics world. every chunk
+// of the terrain gets its own collider on the same static body, and chunks
+// that haven't been loaded yet have none
+struct TerrainPhysics {
+  reactphysics3d::RigidBody* rigidBody = nullptr;
+  std::vector<reactphysics3d::Collider*> colliders;
+  std::vector<reactphysics3d::HeightFieldShape*> shapes;
+};
+
 class Terrain {
  public:
+  // how far below the lowest point of the terrain the goal's footprint is sunk
+  // in the physics height map, which has to be deeper than the goal itself
+  const float GOAL_SINK_DEPTH = 5.0f;
+  // cells per side of a physics chunk, so maps up to this size are one chunk
+  static constexpr int CHUNK_CELLS = 128;
+  static constexpr int MAX_RESOLUTION = 4096;
+  // largest height map file that can be loaded, which keeps every index into
+  // the height map within an int
+  static constexpr int MAX_FILE_RESOLUTION = 16384;
+
   Terrain(glm::vec3 position, int numHorizontal, int numVertical,
           float mapWidth, float mapHeight, float noiseFreq, float noiseAmp);
-  void generateModel(Goal& goal);
+  // builds the terrain from the height map file if one is set, or from noise
+  // otherwise. returns false (after printing an error) if the file couldn't be
+  // loaded, in which case the terrain is generated from noise instead
+  bool generateModel(Goal& goal);
   void freeModel();
 
   void update(GLCore::Timestep ts, float interpolationFactor = -1);
@@ -29,9 +66,36 @@ class Terrain {
   void removePhysics(reactphysics3d::PhysicsWorld* physicsWorld,
                      reactphysics3d::PhysicsCommon& physicsCommon);
 
+  // creates a copy of the terrain colliders that the caller owns, so that
+  // several physics worlds (e.g. one per solver thread) can share the same
+  // height map without sharing any physics objects. with lazyChunks only the
+  // body is created, and chunks are added by loadChunks as balls get near them
+  TerrainPhysics createPhysics(reactphysics3d::PhysicsWorld* physicsWorld,
+                               reactphysics3d::PhysicsCommon& physicsCommon,
+                               bool lazyChunks = false);
+  // adds colliders for the chunks under the absolute x / z box [min, max]
+  // that don't have one yet
+  void loadChunks(TerrainPhysics& physics,
+                  reactphysics3d::PhysicsCommon& physicsCommon, glm::vec2 min,
+                  glm::vec2 max);
+  void destroyPhysics(TerrainPhysics& physics,
+                      reactphysics3d::PhysicsWorld* physicsWorld,
+                      reactphysics3d::PhysicsCommon& physicsCommon);
+
   float getHeight(int col, int row) {
     return heightMap[row * (numCols + 1) + col];
   };
+  // same as getHeight but from the height map used for physics, which is
+  // lower wherever the goal's footprint is sunk
+  float getPhysicsHeight(int col, int row) {
+    return physicsHeightMap[row * (numCols + 1) + col];
+  }
+  // absolute position of a vertex of the height map
+  glm::vec3 getVertexPosition(int col, int row) {
+    return glm::vec3(position.x - mapWidth / 2 + col * getHSpacing(),
+                     position.y + getHeight(col, row),
+                     position.z - mapHeight / 2 + row * getVSpacing());
+  }
 
   glm::vec3 getPosition() { return position; }
   float getWidth() { return mapWidth; }
@@ -44,13 +108,38 @@ class Terrain {
   float getVSpacing() { return this->mapHeight / numRows; }
 
   float getMinHeight() { return minHeight; }
+  float getMaxHeight() { return maxHeight; }
+
+  int getNoiseSeed() { return noiseSeed; }
+  void setNoiseSeed(int seed) { noiseSeed = seed; }
+  // height map file to load instead of generating the terrain from noise, or
+  // empty for none. a loaded file sets the resolution and size of the terrain
+  const std::string& getHeightMapPath() { return heightMapPath; }
+  void setHeightMapPath(const std::string& path) { heightMapPath = path; }
+  // writes the current height map (without the goal's footprint) as a height
+  // map file
+  bool exportHeightMap(const std::string& path, HeightMapFormat format);
+  // octave settings, which take effect on the next generateModel
+  TerrainGenerator& getGenerator() { return generator; }
 
   glm::vec2 convertUV(glm::vec2 uv) {
     return glm::vec2 {(uv.x - 0.5) * mapWidth + position.x,
                      (uv.y - 0.5) * mapHeight + position.z};
   }
 
-  float getHeightFromRelative(glm::vec2 uv);
+  float getHeightFromRelative(glm::vec2 rel) { return planes.getHeight(rel); }
+  // getHeightFromRelative of count points at once, which is faster for more
+  // than a few points
+  void getHeightsFromRelative(const glm::vec2* rel, float* heights,
+                              int count) {
+    planes.getHeights(rel, heights, count);
+  }
+
+  // sinks the vertices of the given range of cells [colStart, colEnd) x
+  // [rowStart, rowEnd) below the goal in the height map used for physics
+  // (restoring the previous footprint), so that the goal's collider can stand
+  // in for the terrain there. existing colliders see the change immediately
+  void setGoalFootprint(int colStart, int colEnd, int rowStart, int rowEnd);
 
  private:
   int numRows;
@@ -65,13 +154,36 @@ class Terrain {
   glm::vec3 color;
 
   int noiseSeed = 0;
+  TerrainGenerator generator;
+  std::string heightMapPath;
+  bool exportInt16 = false;
   std::vector<float> heightMap;
+  TerrainPlanes planes;
+  // copy of the height map with the goal's footprint sunk, which the physics
+  // chunks are cut from
+  std::vector<float> physicsHeightMap;
+  int numChunkCols = 0;
+  int numChunkRows = 0;
+  std::vector<TerrainChunk> chunks;
+  float physicsMinHeight;
+  int footprintColStart = 0;
+  int footprintColEnd = 0;
+  int footprintRowStart = 0;
+  int footprintRowEnd = 0;
   TerrainModel terrainModel;
   float minHeight;
   float maxHeight;
 
-  reactphysics3d::RigidBody* rigidBody;
-  reactphysics3d::Collider* collider;
-  reactphysics3d::HeightFieldShape* shape;
+  TerrainPhysics physics;
   reactphysics3d::Transform prevTransform;
+
+  // reads a height map file into heightMap, setting the terrain's resolution,
+  // size and height range from it
+  bool loadHeightMap(const std::string& path);
+  // splits physicsHeightMap into chunks, several at a time on large maps
+  void buildChunks();
+  void loadChunk(TerrainPhysics& physics,
+                 reactphysics3d::PhysicsCommon& physicsCommon, int index);
+  // sets a vertex of physicsHeightMap and of every chunk that shares it
+  void setPhysicsHeight(int col, int row, float height);
 };
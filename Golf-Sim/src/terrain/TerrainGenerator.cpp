@@ -0,0 +1,219 @@
+#include "TerrainGenerator.h"
+
+#include "PerlinNoise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+// points blended at a time, few enough that the block stays in the cache
+// while every layer is added to it
+const int BLEND_BLOCK = 4096;
+
+// calls rowFunction(begin, end) for ranges of rows [0, numRows) split across
+// threads, if there are enough points to be worth it
+template <typename RowFunction>
+void forEachRowRange(int numRows, long long numPoints,
+                     RowFunction rowFunction) {
+  int numThreads = 1;
+  if (numPoints >= TerrainGenerator::MIN_POINTS_PER_THREAD) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::min(numThreads, numRows);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < numThreads; i++) {
+    threads.emplace_back(rowFunction, numRows * i / numThreads,
+                         numRows * (i + 1) / numThreads);
+  }
+  rowFunction(0, numRows / numThreads);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+const char* getNoiseModeName(NoiseMode mode) {
+  switch (mode) {
+    case NoiseMode::FBM:
+      return "fbm";
+    case NoiseMode::RIDGED:
+      return "ridged";
+    case NoiseMode::DOMAIN_WARP:
+      return "warp";
+  }
+  return "";
+}
+
+bool parseNoiseMode(const std::string& name, NoiseMode& mode) {
+  for (NoiseMode candidate :
+       {NoiseMode::FBM, NoiseMode::RIDGED, NoiseMode::DOMAIN_WARP}) {
+    if (name == getNoiseModeName(candidate)) {
+      mode = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool NoiseGrid::operator==(const NoiseGrid& other) const {
+  return numCols == other.numCols && numRows == other.numRows &&
+         mapWidth == other.mapWidth && mapHeight == other.mapHeight &&
+         noiseFreq == other.noiseFreq && seed == other.seed;
+}
+
+void TerrainGenerator::generate(const NoiseGrid& grid, float noiseAmp,
+                                std::vector<float>& heights) {
+  numOctaves = std::max(1, std::min(numOctaves, MAX_OCTAVES));
+
+  // the warp strength only matters to warped layers
+  bool sameWarp =
+      mode != NoiseMode::DOMAIN_WARP || warpStrength == layerWarpStrength;
+  if (!(grid == layerGrid) || mode != layerMode ||
+      lacunarity != layerLacunarity || !sameWarp) {
+    numLayers = 0;
+  }
+  layerGrid = grid;
+  layerMode = mode;
+  layerLacunarity = lacunarity;
+  layerWarpStrength = warpStrength;
+
+  if (numLayers < numOctaves) {
+    evaluateLayers(numLayers, numOctaves);
+    numLayers = numOctaves;
+  }
+  blend(noiseAmp, heights);
+}
+
+float TerrainGenerator::getAmplitudeBound() {
+  float bound = 0.0f;
+  for (int k = 0; k < std::min(numOctaves, MAX_OCTAVES); k++) {
+    bound += std::abs(octaveAmps[k]);
+  }
+  return bound;
+}
+
+void TerrainGenerator::evaluateLayers(int firstOctave, int lastOctave) {
+  const NoiseGrid& grid = layerGrid;
+  int rowLength = grid.numCols + 1;
+  long long numPoints =
+      static_cast<long long>(grid.numRows + 1) * rowLength;
+
+  // every octave gets its own offset into the noise, drawn in the same order
+  // no matter how many octaves are used. the first octave's offset is the one
+  // single octave terrain has always used. positions in the noise are kept
+  // in doubles, since rand() can be large enough that float offsets leave no
+  // precision for the position within the map
+  noise::initNoise();
+  srand(grid.seed);
+  double offsetX[MAX_OCTAVES];
+  double offsetY[MAX_OCTAVES];
+  for (int k = 0; k < MAX_OCTAVES; k++) {
+    offsetX[k] = rand() / 2;
+    offsetY[k] = rand() / 2;
+  }
+  double warpOffsets[4];
+  for (double& offset : warpOffsets) {
+    offset = rand() / 2;
+  }
+
+  double frequencies[MAX_OCTAVES];
+  for (int k = firstOctave; k < lastOctave; k++) {
+    frequencies[k] = std::pow(static_cast<double>(lacunarity), k);
+    layers[k].resize(numPoints);
+  }
+
+  double hSpacing = grid.mapWidth / grid.numCols;
+  double vSpacing = grid.mapHeight / grid.numRows;
+  double baseX0 = (-grid.mapWidth / 2.0) / grid.noiseFreq;
+  double baseDx = hSpacing / grid.noiseFreq;
+
+  auto evaluateRows = [&](int begin, int end) {
+    std::vector<double> row(rowLength);
+    std::vector<double> warpX(rowLength);
+    std::vector<double> warpZ(rowLength);
+    for (int i = begin; i < end; i++) {
+      double baseZ = (i * vSpacing - grid.mapHeight / 2.0) / grid.noiseFreq;
+      if (mode == NoiseMode::DOMAIN_WARP) {
+        noise::noiseRow(baseX0 + warpOffsets[0], baseDx, -5,
+                        baseZ + warpOffsets[1], rowLength, warpX.data());
+        noise::noiseRow(baseX0 + warpOffsets[2], baseDx, -5,
+                        baseZ + warpOffsets[3], rowLength, warpZ.data());
+      }
+
+      for (int k = firstOctave; k < lastOctave; k++) {
+        double frequency = frequencies[k];
+        if (mode == NoiseMode::DOMAIN_WARP) {
+          // warped positions aren't evenly spaced, so this can't be a row
+          for (int j = 0; j < rowLength; j++) {
+            double x = baseX0 + j * baseDx + warpStrength * warpX[j];
+            double z = baseZ + warpStrength * warpZ[j];
+            row[j] = noise::noise(x * frequency + offsetX[k], -5,
+                                  z * frequency + offsetY[k]);
+          }
+        } else {
+          double x0 = ((-grid.mapWidth / 2.0) * frequency) / grid.noiseFreq +
+                      offsetX[k];
+          double dx = (hSpacing * frequency) / grid.noiseFreq;
+          double z = ((i * vSpacing - grid.mapHeight / 2.0) * frequency) /
+                         grid.noiseFreq +
+                     offsetY[k];
+          noise::noiseRow(x0, dx, -5, z, rowLength, row.data());
+        }
+
+        float* layer = &layers[k][i * static_cast<long long>(rowLength)];
+        if (mode == NoiseMode::RIDGED) {
+          for (int j = 0; j < rowLength; j++) {
+            double ridge = 1 - std::abs(row[j]);
+            layer[j] = static_cast<float>(2 * ridge * ridge - 1);
+          }
+        } else {
+          for (int j = 0; j < rowLength; j++) {
+            layer[j] = static_cast<float>(row[j]);
+          }
+        }
+      }
+    }
+  };
+  forEachRowRange(grid.numRows + 1, numPoints * (lastOctave - firstOctave),
+                  evaluateRows);
+}
+
+void TerrainGenerator::blend(float noiseAmp, std::vector<float>& heights) {
+  int rowLength = layerGrid.numCols + 1;
+  long long numPoints =
+      static_cast<long long>(layerGrid.numRows + 1) * rowLength;
+  heights.resize(numPoints);
+
+  float weights[MAX_OCTAVES];
+  for (int k = 0; k < numOctaves; k++) {
+    weights[k] = noiseAmp * octaveAmps[k];
+  }
+
+  // one pass over the height map a block at a time, with plain loops over
+  // contiguous floats that the compiler vectorizes
+  auto blendRows = [&](int begin, int end) {
+    long long first = begin * static_cast<long long>(rowLength);
+    long long last = end * static_cast<long long>(rowLength);
+    for (long long start = first; start < last; start += BLEND_BLOCK) {
+      int count = static_cast<int>(std::min<long long>(BLEND_BLOCK,
+                                                       last - start));
+      float* out = &heights[start];
+      const float* layer = &layers[0][start];
+      for (int i = 0; i < count; i++) {
+        out[i] = weights[0] * layer[i];
+      }
+      for (int k = 1; k < numOctaves; k++) {
+        float weight = weights[k];
+        layer = &layers[k][start];
+        for (int i = 0; i < count; i++) {
+          out[i] += weight * layer[i];
+        }
+      }
+    }
+  };
+  forEachRowRange(layerGrid.numRows + 1, numPoints, blendRows);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// how the octaves of noise that make up the terrain are shaped
+enum class NoiseMode {
+  // plain perlin noise per octave (fractal brownian motion)
+  FBM,
+  // each octave folded into sharp crests, 2 * (1 - |noise|)^2 - 1
+  RIDGED,
+  // fbm sampled at positions pushed around by two more noise fields
+  DOMAIN_WARP
+};
+
+const char* getNoiseModeName(NoiseMode mode);
+// returns false if the name isn't one of getNoiseModeName's
+bool parseNoiseMode(const std::string& name, NoiseMode& mode);
+
+// the height map's layout and the noise settings every octave depends on
+struct NoiseGrid {
+  int numCols;
+  int numRows;
+  float mapWidth;
+  float mapHeight;
+  float noiseFreq;
+  int seed;
+
+  bool operator==(const NoiseGrid& other) const;
+};
+
+// builds height maps out of octaves of noise. every octave is kept in its own
+// layer, so changing octave amplitudes (or the overall amplitude) only blends
+// the cached layers again instead of evaluating any noise, and adding an
+// octave only evaluates that octave
+class TerrainGenerator {
+ public:
+  static constexpr int MAX_OCTAVES = 8;
+  // height maps with fewer points than this are generated on a single thread
+  static constexpr int MIN_POINTS_PER_THREAD = 1 << 16;
+
+  NoiseMode mode = NoiseMode::FBM;
+  int numOctaves = 1;
+  // frequency multiplier from each octave to the next
+  float lacunarity = 2.0f;
+  // weight of each octave, as a fraction of the terrain's noise amplitude
+  float octaveAmps[MAX_OCTAVES] = {1.0f,    0.5f,     0.25f,     0.125f,
+                                   0.0625f, 0.03125f, 0.015625f, 0.0078125f};
+  // how far domain warping moves sample positions, in units of the first
+  // octave's noise period
+  float warpStrength = 1.0f;
+
+  // fills heights ((numRows + 1) x (numCols + 1), row-major) with noiseAmp
+  // times the weighted sum of the octave layers, evaluating only the layers
+  // that aren't cached for this grid and these settings
+  void generate(const NoiseGrid& grid, float noiseAmp,
+                std::vector<float>& heights);
+
+  // largest height the blended layers can reach, as a multiple of noiseAmp
+  float getAmplitudeBound();
+
+ private:
+  // the settings the cached layers were evaluated with
+  NoiseGrid layerGrid = {};
+  NoiseMode layerMode = NoiseMode::FBM;
+  float layerLacunarity = 0.0f;
+  float layerWarpStrength = 0.0f;
+  int numLayers = 0;
+  std::vector<float> layers[MAX_OCTAVES];
+
+  void evaluateLayers(int firstOctave, int lastOctave);
+  void blend(float noiseAmp, std::vector<float>& heights);
+};
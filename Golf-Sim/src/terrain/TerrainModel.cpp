@@ -3,7 +3,9 @@
 #include "util/opengl/VertexArray.h"
 #include "util/opengl/VertexBuffer.h"
 
+#ifndef GOLF_HEADLESS
 #include <glad/glad.h>
+#endif
 #include <glm/glm.hpp>
 
 #include <memory>
@@ -63,6 +65,7 @@ void TerrainModel::generateModel(std::vector<float>* heightMap, int numCols,
     }
   }
 
+#ifndef GOLF_HEADLESS
   vertexArray = std::make_unique<opengl::VertexArray>();
   vertexArray->bind();
 
@@ -73,6 +76,7 @@ void TerrainModel::generateModel(std::vector<float>* heightMap, int numCols,
   vertexBuffer->setVertexAttribute(1, 3, GL_FLOAT, 3 * sizeof(float));
 
   vertexArray->unbind();
+#endif
 
   numVertices = 2 * 3 * numRows * numCols;
 }
@@ -82,8 +86,10 @@ void TerrainModel::freeModel() {
 
   vertices.clear();
 
+#ifndef GOLF_HEADLESS
   vertexArray->free();
   vertexBuffer->free();
+#endif
 }
 
 std::pair<float, float> TerrainModel::getXZ(int index) {
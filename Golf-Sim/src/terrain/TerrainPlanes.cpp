@@ -0,0 +1,127 @@
+#include "TerrainPlanes.h"
+
+#include "util/CpuFeatures.h"
+
+#include <cstdint>
+
+void TerrainPlanes::build(const std::vector<float>& heightMap, int numCols,
+                          int numRows, float hSpacing, float vSpacing) {
+  this->numCols = numCols;
+  this->numRows = numRows;
+  this->hSpacing = hSpacing;
+  this->vSpacing = vSpacing;
+
+  size_t numTriangles = static_cast<size_t>(numCols) * numRows * 2;
+  bases.resize(numTriangles);
+  slopesX.resize(numTriangles);
+  slopesY.resize(numTriangles);
+
+  long long rowLength = static_cast<long long>(numCols) + 1;
+  for (int row = 0; row < numRows; row++) {
+    for (int col = 0; col < numCols; col++) {
+      float botLeft = heightMap[row * rowLength + col];
+      float botRight = heightMap[row * rowLength + col + 1];
+      float topLeft = heightMap[(row + 1) * rowLength + col];
+      float topRight = heightMap[(row + 1) * rowLength + col + 1];
+
+      long long index = (row * static_cast<long long>(numCols) + col) * 2;
+      // top left, bottom right and bottom left corners
+      bases[index] = botLeft;
+      slopesX[index] = (botRight - botLeft) / hSpacing;
+      slopesY[index] = (topLeft - botLeft) / vSpacing;
+      // top left, top right and bottom right corners
+      bases[index + 1] = botRight - (topRight - topLeft);
+      slopesX[index + 1] = (topRight - topLeft) / hSpacing;
+      slopesY[index + 1] = (topRight - botRight) / vSpacing;
+    }
+  }
+}
+
+void TerrainPlanes::clear() {
+  bases.clear();
+  slopesX.clear();
+  slopesY.clear();
+}
+
+#ifdef CPU_X86_64
+namespace {
+
+// getHeight for 8 points at a time, with the same operations in the same order
+// so every lane rounds exactly like getHeight does. returns how many points
+// were done
+TARGET_AVX2 int getHeightsAvx2(const glm::vec2* points, float* heights,
+                               int count, int numCols, int numRows,
+                               float hSpacing, float vSpacing,
+                               const float* bases, const float* slopesX,
+                               const float* slopesY) {
+  __m256 h = _mm256_set1_ps(hSpacing);
+  __m256 v = _mm256_set1_ps(vSpacing);
+  __m256 negV = _mm256_set1_ps(-vSpacing);
+  __m256 diagonal = _mm256_set1_ps(vSpacing * hSpacing);
+  __m256i zero = _mm256_setzero_si256();
+  __m256i lastCol = _mm256_set1_epi32(numCols - 1);
+  __m256i lastRow = _mm256_set1_epi32(numRows - 1);
+  __m256i cols = _mm256_set1_epi32(numCols);
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // x0 y0 x1 y1 ... into x0 ... x7 and y0 ... y7
+    const float* p = reinterpret_cast<const float*>(points + i);
+    __m256 first = _mm256_loadu_ps(p);
+    __m256 second = _mm256_loadu_ps(p + 8);
+    __m256 xs = _mm256_castpd_ps(_mm256_permute4x64_pd(
+        _mm256_castps_pd(
+            _mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+    __m256 ys = _mm256_castpd_ps(_mm256_permute4x64_pd(
+        _mm256_castps_pd(
+            _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+
+    __m256i col = _mm256_min_epi32(
+        _mm256_max_epi32(_mm256_cvttps_epi32(_mm256_div_ps(xs, h)), zero),
+        lastCol);
+    __m256i row = _mm256_min_epi32(
+        _mm256_max_epi32(_mm256_cvttps_epi32(_mm256_div_ps(ys, v)), zero),
+        lastRow);
+    __m256 ax = _mm256_sub_ps(xs, _mm256_mul_ps(h, _mm256_cvtepi32_ps(col)));
+    __m256 ay = _mm256_sub_ps(ys, _mm256_mul_ps(v, _mm256_cvtepi32_ps(row)));
+
+    __m256 upper =
+        _mm256_cmp_ps(_mm256_mul_ps(ay, h),
+                      _mm256_add_ps(_mm256_mul_ps(negV, ax), diagonal),
+                      _CMP_GT_OQ);
+    // the mask is -1 for the upper triangles, so subtracting it adds 1
+    __m256i index = _mm256_sub_epi32(
+        _mm256_slli_epi32(
+            _mm256_add_epi32(_mm256_mullo_epi32(row, cols), col), 1),
+        _mm256_castps_si256(upper));
+
+    __m256 base = _mm256_i32gather_ps(bases, index, 4);
+    __m256 slopeX = _mm256_i32gather_ps(slopesX, index, 4);
+    __m256 slopeY = _mm256_i32gather_ps(slopesY, index, 4);
+    _mm256_storeu_ps(
+        heights + i,
+        _mm256_add_ps(_mm256_add_ps(base, _mm256_mul_ps(slopeX, ax)),
+                      _mm256_mul_ps(slopeY, ay)));
+  }
+  return i;
+}
+
+}  // namespace
+#endif
+
+void TerrainPlanes::getHeights(const glm::vec2* points, float* heights,
+                               int count) {
+  int i = 0;
+#ifdef CPU_X86_64
+  // the vector indices are 32 bit
+  if (hasAvx2() && bases.size() <= INT32_MAX) {
+    i = getHeightsAvx2(points, heights, count, numCols, numRows, hSpacing,
+                       vSpacing, bases.data(), slopesX.data(), slopesY.data());
+  }
+#endif
+  for (; i < count; i++) {
+    heights[i] = getHeight(points[i]);
+  }
+}
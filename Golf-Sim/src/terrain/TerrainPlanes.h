@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// the plane of every triangle of the height map, so that a height on the
+// terrain is a lookup and two multiply-adds instead of building the triangle's
+// plane from its corners. positions are relative to the terrain's -x / -z
+// corner, and points past the edges extend the planes of the edge cells
+class TerrainPlanes {
+ public:
+  void build(const std::vector<float>& heightMap, int numCols, int numRows,
+             float hSpacing, float vSpacing);
+  void clear();
+
+  float getHeight(glm::vec2 rel) {
+    int col = std::min(std::max(static_cast<int>(rel.x / hSpacing), 0),
+                       numCols - 1);
+    int row = std::min(std::max(static_cast<int>(rel.y / vSpacing), 0),
+                       numRows - 1);
+    float ax = rel.x - hSpacing * col;
+    float ay = rel.y - vSpacing * row;
+
+    // the same diagonal the height field and the mesh split cells along
+    bool upper = ay * hSpacing > -vSpacing * ax + vSpacing * hSpacing;
+    long long index = (row * static_cast<long long>(numCols) + col) * 2 + upper;
+    return bases[index] + slopesX[index] * ax + slopesY[index] * ay;
+  }
+  // getHeight of count points at once, several at a time with AVX2 where the
+  // cpu has it (with exactly the same results)
+  void getHeights(const glm::vec2* points, float* heights, int count);
+
+ private:
+  int numCols = 0;
+  int numRows = 0;
+  float hSpacing = 1.0f;
+  float vSpacing = 1.0f;
+
+  // height = base + slopeX * x + slopeY * y, with x and y measured from the
+  // cell's -x / -z corner. the two triangles of each cell are next to each
+  // other, the one below the diagonal first
+  std::vector<float> bases;
+  std::vector<float> slopesX;
+  std::vector<float> slopesY;
+};
@@ -0,0 +1,32 @@
+#include "CpuFeatures.h"
+
+#if defined(CPU_X86_64) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+bool detectAvx2() {
+#ifndef CPU_X86_64
+  return false;
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+  __cpuid(info, 1);
+  // the os has to save the ymm registers too
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  if (!osxsave || (_xgetbv(0) & 6) != 6) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+}  // namespace
+
+bool hasAvx2() {
+  static const bool avx2 = detectAvx2();
+  return avx2;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// code paths for x86-64 cpus with AVX2, which are compiled for AVX2 on their
+// own (marked TARGET_AVX2) and only taken when hasAvx2() says the cpu has it,
+// so the rest of the program still runs anywhere
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPU_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// whether the cpu and the os support AVX2, checked once
+bool hasAvx2();
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// closest point to p on the triangle abc (from Real-Time Collision Detection,
+// Ericson, 5.1.5)
+inline glm::vec3 closestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b,
+                                        glm::vec3 c) {
+  glm::vec3 ab = b - a;
+  glm::vec3 ac = c - a;
+  glm::vec3 ap = p - a;
+  float d1 = glm::dot(ab, ap);
+  float d2 = glm::dot(ac, ap);
+  if (d1 <= 0 && d2 <= 0) return a;
+
+  glm::vec3 bp = p - b;
+  float d3 = glm::dot(ab, bp);
+  float d4 = glm::dot(ac, bp);
+  if (d3 >= 0 && d4 <= d3) return b;
+
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+
+  glm::vec3 cp = p - c;
+  float d5 = glm::dot(ab, cp);
+  float d6 = glm::dot(ac, cp);
+  if (d6 >= 0 && d5 <= d6) return c;
+
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+
+  float denom = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::openRead(const std::string& path) {
+  return map(path, 0, false);
+}
+
+bool MappedFile::create(const std::string& path, size_t size) {
+  return map(path, size, true);
+}
+
+#ifdef _WIN32
+bool MappedFile::map(const std::string& path, size_t size, bool write) {
+  close();
+
+  // files mapped for reading may still be appended to, by this process (the
+  // result cache) or another one, like they can be on other platforms
+  HANDLE file = CreateFileA(
+      path.c_str(), write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+      write ? FILE_SHARE_READ : FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+      write ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    std::cout << "ERROR: could not open " << path << std::endl;
+    return false;
+  }
+  fileHandle = file;
+
+  if (!write) {
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size = fileSize.QuadPart;
+  }
+  if (size == 0) {
+    std::cout << "ERROR: " << path << " is empty" << std::endl;
+    close();
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(
+      file, NULL, write ? PAGE_READWRITE : PAGE_READONLY,
+      static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+      static_cast<DWORD>(size & 0xFFFFFFFF), NULL);
+  if (mapping == NULL) {
+    std::cout << "ERROR: could not map " << path << std::endl;
+    close();
+    return false;
+  }
+  mappingHandle = mapping;
+
+  data = static_cast<uint8_t*>(MapViewOfFile(
+      mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+  if (data == nullptr) {
+    std::cout << "ERROR: could not map " << path << std::endl;
+    close();
+    return false;
+  }
+  this->size = size;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data != nullptr) {
+    UnmapViewOfFile(data);
+    data = nullptr;
+  }
+  if (mappingHandle != nullptr) {
+    CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+  }
+  if (fileHandle != nullptr) {
+    CloseHandle(fileHandle);
+    fileHandle = nullptr;
+  }
+  size = 0;
+}
+#else
+bool MappedFile::map(const std::string& path, size_t size, bool write) {
+  close();
+
+  fd = ::open(path.c_str(), write ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY,
+              0644);
+  if (fd == -1) {
+    std::cout << "ERROR: could not open " << path << std::endl;
+    return false;
+  }
+
+  if (write) {
+    if (ftruncate(fd, size) != 0) {
+      std::cout << "ERROR: could not resize " << path << std::endl;
+      close();
+      return false;
+    }
+  } else {
+    struct stat info;
+    fstat(fd, &info);
+    size = info.st_size;
+  }
+  if (size == 0) {
+    std::cout << "ERROR: " << path << " is empty" << std::endl;
+    close();
+    return false;
+  }
+
+  void* mapped = mmap(nullptr, size, write ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    std::cout << "ERROR: could not map " << path << std::endl;
+    close();
+    return false;
+  }
+  data = static_cast<uint8_t*>(mapped);
+  this->size = size;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data != nullptr) {
+    munmap(data, size);
+    data = nullptr;
+  }
+  if (fd != -1) {
+    ::close(fd);
+    fd = -1;
+  }
+  size = 0;
+}
+#endif
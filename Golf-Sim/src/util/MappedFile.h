@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// a file mapped into memory, either read only or created with a fixed size
+// for writing. the mapping is released when the object is destroyed. files
+// opened for reading can still be appended to while they are mapped, but the
+// mapping keeps the size they had when they were opened
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // both return false (after printing an error) if the file couldn't be
+  // opened or mapped
+  bool openRead(const std::string& path);
+  bool create(const std::string& path, size_t size);
+  void close();
+
+  bool isOpen() { return data != nullptr; }
+  uint8_t* getData() { return data; }
+  size_t getSize() { return size; }
+
+ private:
+  uint8_t* data = nullptr;
+  size_t size = 0;
+
+#ifdef _WIN32
+  void* fileHandle = nullptr;
+  void* mappingHandle = nullptr;
+#else
+  int fd = -1;
+#endif
+
+  bool map(const std::string& path, size_t size, bool write);
+};
@@ -0,0 +1,154 @@
+-- only the parts of the simulator that don't touch OpenGL or ImGui, shared by
+-- golf-solve and its tests
+SolverFiles =
+{
+	"../Golf-Sim/src/solver/**.h",
+	"../Golf-Sim/src/solver/**.cpp",
+	"../Golf-Sim/src/ball/Ball.h",
+	"../Golf-Sim/src/ball/Ball.cpp",
+	"../Golf-Sim/src/ball/BallBodyPool.h",
+	"../Golf-Sim/src/ball/BallBodyPool.cpp",
+	"../Golf-Sim/src/ball/FlightStage.h",
+	"../Golf-Sim/src/ball/FlightStage.cpp",
+	"../Golf-Sim/src/ball/ShotTable.h",
+	"../Golf-Sim/src/ball/ShotTable.cpp",
+	"../Golf-Sim/src/ball/BallShapeRegistry.h",
+	"../Golf-Sim/src/ball/BallShapeRegistry.cpp",
+	"../Golf-Sim/src/goal/Goal.h",
+	"../Golf-Sim/src/goal/Goal.cpp",
+	"../Golf-Sim/src/goal/GoalModel.h",
+	"../Golf-Sim/src/goal/GoalModel.cpp",
+	"../Golf-Sim/src/terrain/HeightMapFile.h",
+	"../Golf-Sim/src/terrain/HeightMapFile.cpp",
+	"../Golf-Sim/src/terrain/PerlinNoise.h",
+	"../Golf-Sim/src/terrain/PerlinNoise.cpp",
+	"../Golf-Sim/src/terrain/Terrain.h",
+	"../Golf-Sim/src/terrain/Terrain.cpp",
+	"../Golf-Sim/src/terrain/TerrainGenerator.h",
+	"../Golf-Sim/src/terrain/TerrainGenerator.cpp",
+	"../Golf-Sim/src/terrain/TerrainModel.h",
+	"../Golf-Sim/src/terrain/TerrainModel.cpp",
+	"../Golf-Sim/src/terrain/TerrainPlanes.h",
+	"../Golf-Sim/src/terrain/TerrainPlanes.cpp",
+	"../Golf-Sim/src/util/CollisionCategory.h",
+	"../Golf-Sim/src/util/CpuFeatures.h",
+	"../Golf-Sim/src/util/CpuFeatures.cpp",
+	"../Golf-Sim/src/util/Geometry.h",
+	"../Golf-Sim/src/util/MappedFile.h",
+	"../Golf-Sim/src/util/MappedFile.cpp"
+}
+
+project "Golf-Solve"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	targetname "golf-solve"
+
+	targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"src/**.h",
+		"src/**.cpp",
+		SolverFiles
+	}
+
+	defines
+	{
+		"_CRT_SECURE_NO_WARNINGS",
+		"GOLF_HEADLESS"
+	}
+
+	includedirs
+	{
+		"../OpenGL-Core/src",
+		"../OpenGL-Core/%{IncludeDir.glm}",
+		"./src",
+		"../Golf-Sim/src",
+		"../Golf-Sim/vendor/reactphysics3d/include"
+	}
+
+	links
+	{
+		"reactphysics3d.lib"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+		libdirs 
+		{
+			"../Golf-Sim/vendor/reactphysics3d/debug"
+		}
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+		libdirs 
+		{
+			"../Golf-Sim/vendor/reactphysics3d/release"
+		}
+
+project "Golf-Solve-Tests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	targetname "golf-solve-tests"
+
+	targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tests/**.h",
+		"tests/**.cpp",
+		SolverFiles
+	}
+
+	defines
+	{
+		"_CRT_SECURE_NO_WARNINGS",
+		"GOLF_HEADLESS"
+	}
+
+	includedirs
+	{
+		"../OpenGL-Core/src",
+		"../OpenGL-Core/%{IncludeDir.glm}",
+		"../Golf-Sim/src",
+		"../Golf-Sim/vendor/reactphysics3d/include"
+	}
+
+	links
+	{
+		"reactphysics3d.lib"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+		libdirs 
+		{
+			"../Golf-Sim/vendor/reactphysics3d/debug"
+		}
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+		libdirs 
+		{
+			"../Golf-Sim/vendor/reactphysics3d/release"
+		}
@@ -0,0 +1,1539 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "goal/Goal.h"
+#include "solver/AdaptiveSweep.h"
+#include "solver/Checkpoint.h"
+#include "solver/InverseSolver.h"
+#include "solver/ResultCache.h"
+#include "solver/ResultFile.h"
+#include "solver/ResultStream.h"
+#include "solver/Scenario.h"
+#include "solver/ShardedSolver.h"
+#include "solver/Sweep.h"
+#include "solver/ToleranceMap.h"
+#include "terrain/HeightMapFile.h"
+#include "terrain/Terrain.h"
+#include "terrain/TerrainGenerator.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// everything needed to reproduce a sweep, defaulting to the same values the
+// simulator starts with
+struct SolveConfig {
+  SweepConfig sweep;
+  std::string outputFilePath = "result.golf";
+  // binary (version 2) or text results file
+  bool binaryOutput = true;
+
+  glm::vec2 startPosition = glm::vec2(0.2, 0.2);
+  float ballRadius = 0.25;
+
+  glm::vec2 goalPosition = glm::vec2(0.5, 0.5);
+  float goalRadius = 0.5;
+
+  float terrainWidth = 50.0f;
+  float terrainHeight = 50.0f;
+  int terrainCols = 100;
+  int terrainRows = 100;
+  float noiseFreq = 10.0f;
+  float noiseAmp = 5.0f;
+  int noiseSeed = 0;
+  NoiseMode noiseMode = NoiseMode::FBM;
+  // weight of each octave of noise, as a fraction of noiseAmp
+  std::vector<float> octaveAmps = {1.0f};
+  float lacunarity = 2.0f;
+  float warpStrength = 1.0f;
+  // height map file to use instead of noise, which also sets the terrain's
+  // size and resolution, or empty for none
+  std::string heightMapPath = "";
+  // writes the terrain to this height map file instead of solving anything,
+  // or empty for none
+  std::string exportHeightMapPath = "";
+  HeightMapFormat exportFormat = HeightMapFormat::FLOAT32;
+
+  int liveBalls = 250;
+  bool autoTune = true;
+  bool useFlightStage = true;
+  // stops shots once they can no longer go in, storing a lower bound on their
+  // distance (flagged by their PRUNED state) instead of the exact one
+  bool prune = false;
+  int chunkSize = 1000;
+  float maxShotTime = 120.0f;
+  int numThreads = std::max(1u, std::thread::hardware_concurrency());
+  SolverBackend backend = SolverBackend::RP3D;
+  // runs both backends and compares their results
+  bool validate = false;
+  // times the coarse grid of numDivisions points per axis is split around the
+  // edge of the goal, or 0 for a uniform sweep
+  int adaptiveLevels = 0;
+  // cells whose corner distances differ by more than this are split even if
+  // they don't straddle the edge of the goal (0 to disable)
+  float refineGradient = 10.0f;
+  // searches the sweep's ranges for shots that go in instead of sweeping them
+  bool inverse = false;
+  InverseConfig inverseConfig;
+  // results file to find the margin of error of each shot in, instead of
+  // solving anything
+  std::string tolerancePath = "";
+  int toleranceTop = 0;
+  // cache of solved shots shared between runs, or empty for none
+  std::string cachePath = "";
+  // file that finished shots are appended to every checkpointInterval shots,
+  // or empty for none
+  std::string checkpointPath = "";
+  int checkpointInterval = 10000;
+  // continues the run in checkpointPath instead of starting it over
+  bool resume = false;
+  // streamed results file that each shot is written to as soon as it
+  // finishes, instead of writing outputFilePath at the end, or empty for none
+  std::string streamPath = "";
+  // splits the sweep into shards solved by numWorkers worker processes at a
+  // time, or 0 to solve it in this process. workers are started with
+  // workerCommand, which defaults to this program
+  int numWorkers = 0;
+  std::string workerCommand = "";
+  // shots per shard, or 0 for four shards per worker
+  int shardSize = 0;
+  // set for worker processes, which only stream the shots [shardBegin,
+  // shardEnd) of the sweep
+  int shardBegin = 0;
+  int shardEnd = 0;
+  // start positions, goal positions and goal radii to run the sweep for every
+  // combination of, on the same terrain. lists left empty use the single start
+  // and goal above, and if all of them are empty only that one is run
+  ScenarioBatch scenarios;
+};
+
+void printUsage() {
+  std::cout
+      << "Usage: golf-solve [options]\n"
+         "  --config <file>                 read options from a file of\n"
+         "                                  'option = values' lines\n"
+         "  --output <file>                 results file (default result.golf)\n"
+         "  --format <binary|text>          results file format (default binary)\n"
+         "  --divisions <n>                 shots per parameter dimension\n"
+         "  --sampling <mode>               grid (default), or sobol, halton or\n"
+         "                                  lhs (latin hypercube) to simulate\n"
+         "                                  --samples shots instead\n"
+         "  --samples <n>                   shots for non-grid sampling\n"
+         "  --sample-seed <n>               randomizes the non-grid samples\n"
+         "                                  (default 0: unrandomized)\n"
+         "  --adaptive <levels>             refine the --divisions grid this\n"
+         "                                  many times around the edge of the\n"
+         "                                  goal, writing a sparse tree results\n"
+         "                                  file (default 0: uniform grid)\n"
+         "  --refine-gradient <d>           also refine cells whose distances\n"
+         "                                  differ by more than d (default 10,\n"
+         "                                  0 to disable)\n"
+         "  --inverse <method>              instead of sweeping, search the ranges\n"
+         "                                  for shots that go in with cmaes or\n"
+         "                                  neldermead and print them\n"
+         "  --inverse-shots <n>             different shots to find (default 5)\n"
+         "  --inverse-budget <n>            most shots to simulate (default 5000)\n"
+         "  --searches <n>                  searches run side by side (default 8)\n"
+         "  --population <n>                shots per CMA-ES generation\n"
+         "                                  (default 12)\n"
+         "  --tolerance <file>              instead of solving, rank the shots of\n"
+         "                                  a grid or adaptive results file by\n"
+         "                                  how far off they can be and still go\n"
+         "                                  in, writing <file>.tolerance.txt\n"
+         "  --tolerance-top <n>             only list the n most forgiving shots\n"
+         "  --cache <file>                  reuse shots of the same scene solved\n"
+         "                                  by earlier runs, adding new ones\n"
+         "  --checkpoint <file>             append finished shots to a checkpoint\n"
+         "                                  file as the sweep runs\n"
+         "  --checkpoint-every <n>          shots per checkpoint (default 10000)\n"
+         "  --resume <file>                 finish the run of a checkpoint file\n"
+         "                                  with its options (options that\n"
+         "                                  don't change the sweep override\n"
+         "                                  them)\n"
+         "  --stream <file>                 write each shot to a streamed results\n"
+         "                                  file as soon as it finishes, instead\n"
+         "                                  of --output at the end\n"
+         "  --workers <n>                   solve the sweep in shards with n worker\n"
+         "                                  processes at a time, which share\n"
+         "                                  --threads threads\n"
+         "  --worker-cmd <cmd>              command that starts a worker, such as\n"
+         "                                  \"ssh host golf-solve\" (default: this\n"
+         "                                  program)\n"
+         "  --shard-size <n>                shots per shard (default: four shards\n"
+         "                                  per worker)\n"
+         "  --shard <begin> <end>           only stream the shots [begin, end), as\n"
+         "                                  a worker does\n"
+         "  --starts <u> <v> [<u> <v> ...]  run the sweep from each of these\n"
+         "                                  start positions, writing a bundle\n"
+         "                                  of results files to the --output\n"
+         "                                  directory\n"
+         "  --start-grid <u0> <u1> <v0> <v1> <n>\n"
+         "                                  same with an n by n grid of starts\n"
+         "  --goals <u> <v> [<u> <v> ...]   same for goal positions\n"
+         "  --goal-grid <u0> <u1> <v0> <v1> <n>\n"
+         "  --goal-radii <r> [<r> ...]      same for goal radii\n"
+         "  --power <min> <max>             power range\n"
+         "  --yaw <min> <max>               yaw offset range (deg)\n"
+         "  --pitch <min> <max>             pitch range (deg)\n"
+         "  --start <u> <v>                 relative start position\n"
+         "  --ball-radius <r>\n"
+         "  --goal <u> <v> <radius>         relative goal position and radius\n"
+         "  --terrain-size <width> <height>\n"
+         "  --terrain-res <cols> <rows>\n"
+         "  --noise <freq> <amp>\n"
+         "  --seed <n>                      terrain noise seed\n"
+         "  --noise-mode <mode>             fbm (default), ridged, or warp for\n"
+         "                                  domain warped fbm\n"
+         "  --octaves <amp> [<amp> ...]     weight of each octave of noise\n"
+         "                                  (default 1: a single octave)\n"
+         "  --lacunarity <f>                frequency multiplier between\n"
+         "                                  octaves (default 2)\n"
+         "  --warp <strength>               how far warp mode moves samples\n"
+         "                                  (default 1)\n"
+         "  --heightmap <file>              load the terrain from a .golfh height\n"
+         "                                  map file instead of noise\n"
+         "  --export-heightmap <file> [float32|int16]\n"
+         "                                  instead of solving, write the\n"
+         "                                  terrain to a height map file\n"
+         "  --live-balls <n>                balls in flight at the same time\n"
+         "                                  per thread\n"
+         "  --auto-tune <0|1>               tune the number of live balls for\n"
+         "                                  the most steps per second (default 1)\n"
+         "  --flight <0|1>                  move balls along their flight path\n"
+         "                                  without the physics engine until\n"
+         "                                  they are about to land (default 1)\n"
+         "  --prune <0|1>                   stop shots early once they can no\n"
+         "                                  longer go in and store a lower bound\n"
+         "                                  on their distance (default 0)\n"
+         "  --chunk-size <n>                shots handed to a thread at a time\n"
+         "  --max-shot-time <s>             simulated seconds before a shot is\n"
+         "                                  cut off\n"
+         "  --threads <n>                   worker threads, each with its own\n"
+         "                                  physics world (default: all cores)\n"
+         "  --backend <name>                rp3d (default), heightfield, or\n"
+         "                                  validate to run both and report how\n"
+         "                                  far their distances differ\n";
+}
+
+// both parse all of value, returning false if it isn't a number (or a whole
+// number in range)
+bool parseFloat(const std::string& value, float& result) {
+  size_t end = 0;
+  try {
+    result = std::stof(value, &end);
+  } catch (...) {
+    return false;
+  }
+  return end == value.size();
+}
+
+bool parseInt(const std::string& value, long long minValue,
+              long long maxValue, long long& result) {
+  size_t end = 0;
+  try {
+    result = std::stoll(value, &end);
+  } catch (...) {
+    return false;
+  }
+  return end == value.size() && result >= minValue && result <= maxValue;
+}
+
+// options whose values aren't numbers
+const char* STRING_OPTIONS[] = {"output",     "format",     "sampling",
+                                "inverse",    "tolerance",  "cache",
+                                "checkpoint", "stream",     "worker-cmd",
+                                "noise-mode", "heightmap",  "export-heightmap",
+                                "backend"};
+
+// applies a single option, returning false if it is unknown or malformed
+bool applyOption(SolveConfig& config, const std::string& name,
+                 const std::vector<std::string>& values) {
+  bool isNumeric =
+      std::find(std::begin(STRING_OPTIONS), std::end(STRING_OPTIONS), name) ==
+      std::end(STRING_OPTIONS);
+  std::vector<float> v(isNumeric ? values.size() : 0);
+  for (int i = 0; i < v.size(); i++) {
+    if (!parseFloat(values[i], v[i])) {
+      std::cout << "ERROR: --" << name << " expects numbers, not " << values[i]
+                << std::endl;
+      return false;
+    }
+  }
+
+  auto expect = [&](int count) {
+    if (values.size() != count) {
+      std::cout << "ERROR: --" << name << " expects " << count << " value(s)"
+                << std::endl;
+      return false;
+    }
+    return true;
+  };
+  // integer values are parsed as integers rather than through v, which would
+  // round them to 24 bits
+  auto getInt = [&](int i, int& result, int minValue = INT32_MIN) {
+    long long value;
+    if (!parseInt(values[i], minValue, INT32_MAX, value)) {
+      std::cout << "ERROR: --" << name << " expects whole numbers";
+      if (minValue != INT32_MIN) std::cout << " of at least " << minValue;
+      std::cout << ", not " << values[i] << std::endl;
+      return false;
+    }
+    result = static_cast<int>(value);
+    return true;
+  };
+
+  if (name == "output") {
+    if (!expect(1)) return false;
+    config.outputFilePath = values[0];
+  } else if (name == "format") {
+    if (!expect(1)) return false;
+    if (values[0] != "binary" && values[0] != "text") {
+      std::cout << "ERROR: unknown format " << values[0] << std::endl;
+      return false;
+    }
+    config.binaryOutput = values[0] == "binary";
+  } else if (name == "divisions") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.sweep.numDivisions, 2)) return false;
+  } else if (name == "sampling") {
+    if (!expect(1)) return false;
+    if (!parseSamplingMode(values[0], config.sweep.sampling)) {
+      std::cout << "ERROR: unknown sampling mode " << values[0] << std::endl;
+      return false;
+    }
+  } else if (name == "samples") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.sweep.numSamples, 1)) return false;
+  } else if (name == "sample-seed") {
+    if (!expect(1)) return false;
+    long long seed;
+    if (!parseInt(values[0], 0, UINT32_MAX, seed)) {
+      std::cout << "ERROR: --sample-seed expects a whole number from 0 to "
+                << UINT32_MAX << std::endl;
+      return false;
+    }
+    config.sweep.samplingSeed = static_cast<uint32_t>(seed);
+  } else if (name == "adaptive") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.adaptiveLevels, 0)) return false;
+  } else if (name == "refine-gradient") {
+    if (!expect(1)) return false;
+    config.refineGradient = v[0];
+  } else if (name == "inverse") {
+    if (!expect(1)) return false;
+    config.inverse = true;
+    if (!parseInverseMethod(values[0], config.inverseConfig.method)) {
+      std::cout << "ERROR: unknown inverse method " << values[0] << std::endl;
+      return false;
+    }
+  } else if (name == "inverse-shots") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.inverseConfig.targetShots, 1)) return false;
+  } else if (name == "inverse-budget") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.inverseConfig.maxSimulations, 1)) return false;
+  } else if (name == "searches") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.inverseConfig.numSearches, 1)) return false;
+  } else if (name == "population") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.inverseConfig.populationSize, 1)) return false;
+  } else if (name == "tolerance") {
+    if (!expect(1)) return false;
+    config.tolerancePath = values[0];
+  } else if (name == "tolerance-top") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.toleranceTop, 0)) return false;
+  } else if (name == "cache") {
+    if (!expect(1)) return false;
+    config.cachePath = values[0];
+  } else if (name == "checkpoint") {
+    if (!expect(1)) return false;
+    config.checkpointPath = values[0];
+  } else if (name == "checkpoint-every") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.checkpointInterval, 1)) return false;
+  } else if (name == "stream") {
+    if (!expect(1)) return false;
+    config.streamPath = values[0];
+  } else if (name == "workers") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.numWorkers, 1)) return false;
+  } else if (name == "worker-cmd") {
+    if (!expect(1)) return false;
+    config.workerCommand = values[0];
+  } else if (name == "shard-size") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.shardSize, 1)) return false;
+  } else if (name == "shard") {
+    if (!expect(2)) return false;
+    if (!getInt(0, config.shardBegin, 0) || !getInt(1, config.shardEnd, 0)) {
+      return false;
+    }
+  } else if (name == "starts" || name == "goals") {
+    if (values.empty() || values.size() % 2 != 0) {
+      std::cout << "ERROR: --" << name << " expects pairs of values"
+                << std::endl;
+      return false;
+    }
+    std::vector<glm::vec2>& positions = name == "starts"
+                                            ? config.scenarios.startPositions
+                                            : config.scenarios.goalPositions;
+    positions.clear();
+    for (int i = 0; i < v.size(); i += 2) {
+      positions.push_back(glm::vec2(v[i], v[i + 1]));
+    }
+  } else if (name == "start-grid" || name == "goal-grid") {
+    if (!expect(5)) return false;
+    std::vector<glm::vec2>& positions = name == "start-grid"
+                                            ? config.scenarios.startPositions
+                                            : config.scenarios.goalPositions;
+    int n;
+    if (!getInt(4, n, 1)) return false;
+    positions =
+        getGridPositions(glm::vec2(v[0], v[2]), glm::vec2(v[1], v[3]), n);
+  } else if (name == "goal-radii") {
+    if (values.empty()) {
+      std::cout << "ERROR: --goal-radii expects at least one value"
+                << std::endl;
+      return false;
+    }
+    config.scenarios.goalRadii = v;
+  } else if (name == "power") {
+    if (!expect(2)) return false;
+    config.sweep.minPower = v[0];
+    config.sweep.maxPower = v[1];
+  } else if (name == "yaw") {
+    if (!expect(2)) return false;
+    config.sweep.minYaw = v[0];
+    config.sweep.maxYaw = v[1];
+  } else if (name == "pitch") {
+    if (!expect(2)) return false;
+    config.sweep.minPitch = v[0];
+    config.sweep.maxPitch = v[1];
+  } else if (name == "start") {
+    if (!expect(2)) return false;
+    config.startPosition = glm::vec2(v[0], v[1]);
+  } else if (name == "ball-radius") {
+    if (!expect(1)) return false;
+    config.ballRadius = v[0];
+  } else if (name == "goal") {
+    if (!expect(3)) return false;
+    config.goalPosition = glm::vec2(v[0], v[1]);
+    config.goalRadius = v[2];
+  } else if (name == "terrain-size") {
+    if (!expect(2)) return false;
+    config.terrainWidth = v[0];
+    config.terrainHeight = v[1];
+  } else if (name == "terrain-res") {
+    if (!expect(2)) return false;
+    if (!getInt(0, config.terrainCols, 1)) return false;
+    if (!getInt(1, config.terrainRows, 1)) return false;
+  } else if (name == "noise") {
+    if (!expect(2)) return false;
+    config.noiseFreq = v[0];
+    config.noiseAmp = v[1];
+  } else if (name == "seed") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.noiseSeed)) return false;
+  } else if (name == "noise-mode") {
+    if (!expect(1)) return false;
+    if (!parseNoiseMode(values[0], config.noiseMode)) {
+      std::cout << "ERROR: unknown noise mode " << values[0] << std::endl;
+      return false;
+    }
+  } else if (name == "octaves") {
+    if (values.empty() || values.size() > TerrainGenerator::MAX_OCTAVES) {
+      std::cout << "ERROR: --octaves expects 1 to "
+                << TerrainGenerator::MAX_OCTAVES << " values" << std::endl;
+      return false;
+    }
+    config.octaveAmps = v;
+  } else if (name == "lacunarity") {
+    if (!expect(1)) return false;
+    config.lacunarity = v[0];
+  } else if (name == "warp") {
+    if (!expect(1)) return false;
+    config.warpStrength = v[0];
+  } else if (name == "heightmap") {
+    if (!expect(1)) return false;
+    config.heightMapPath = values[0];
+  } else if (name == "export-heightmap") {
+    if (values.empty() || values.size() > 2) {
+      std::cout << "ERROR: --export-heightmap expects a file and an optional "
+                   "format"
+                << std::endl;
+      return false;
+    }
+    config.exportHeightMapPath = values[0];
+    std::string format = values.size() == 2 ? values[1] : "float32";
+    if (format != "float32" && format != "int16") {
+      std::cout << "ERROR: unknown height map format " << format << std::endl;
+      return false;
+    }
+    config.exportFormat = format == "int16" ? HeightMapFormat::INT16
+                                            : HeightMapFormat::FLOAT32;
+  } else if (name == "live-balls") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.liveBalls, 1)) return false;
+  } else if (name == "auto-tune") {
+    if (!expect(1)) return false;
+    config.autoTune = v[0] != 0;
+  } else if (name == "flight") {
+    if (!expect(1)) return false;
+    config.useFlightStage = v[0] != 0;
+  } else if (name == "prune") {
+    if (!expect(1)) return false;
+    config.prune = v[0] != 0;
+  } else if (name == "chunk-size") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.chunkSize, 1)) return false;
+  } else if (name == "max-shot-time") {
+    if (!expect(1)) return false;
+    config.maxShotTime = v[0];
+  } else if (name == "threads") {
+    if (!expect(1)) return false;
+    if (!getInt(0, config.numThreads, 1)) return false;
+  } else if (name == "backend") {
+    if (!expect(1)) return false;
+    config.validate = values[0] == "validate";
+    if (!config.validate && !parseBackendName(values[0], config.backend)) {
+      std::cout << "ERROR: unknown backend " << values[0] << std::endl;
+      return false;
+    }
+  } else {
+    std::cout << "ERROR: unknown option --" << name << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+// applies every 'option = values' line of a config file
+bool readConfig(SolveConfig& config, std::istream& fin) {
+  std::string line;
+  while (std::getline(fin, line)) {
+    line = line.substr(0, line.find('#'));
+    size_t equals = line.find('=');
+    if (equals == std::string::npos) continue;
+
+    std::istringstream nameStream(line.substr(0, equals));
+    std::istringstream valueStream(line.substr(equals + 1));
+    std::string name;
+    nameStream >> name;
+
+    std::vector<std::string> values;
+    std::string value;
+    while (valueStream >> value) values.push_back(value);
+
+    if (!applyOption(config, name, values)) return false;
+  }
+
+  return true;
+}
+
+bool readConfigFile(SolveConfig& config, const std::string& path) {
+  std::ifstream fin(path);
+  if (!fin) {
+    std::cout << "ERROR: could not open config file " << path << std::endl;
+    return false;
+  }
+  return readConfig(config, fin);
+}
+
+// config file lines of the options that decide which shots a sweep simulates
+// and what their results are, with floats written with enough digits to be
+// read back exactly
+std::string formatSweepConfig(const SolveConfig& config) {
+  const SweepConfig& sweep = config.sweep;
+  std::ostringstream out;
+  out << std::setprecision(9);
+  out << "divisions = " << sweep.numDivisions << "\n";
+  out << "sampling = " << getSamplingModeName(sweep.sampling) << "\n";
+  out << "samples = " << sweep.numSamples << "\n";
+  out << "sample-seed = " << sweep.samplingSeed << "\n";
+  out << "power = " << sweep.minPower << " " << sweep.maxPower << "\n";
+  out << "yaw = " << sweep.minYaw << " " << sweep.maxYaw << "\n";
+  out << "pitch = " << sweep.minPitch << " " << sweep.maxPitch << "\n";
+  out << "start = " << config.startPosition.x << " " << config.startPosition.y
+      << "\n";
+  out << "ball-radius = " << config.ballRadius << "\n";
+  out << "goal = " << config.goalPosition.x << " " << config.goalPosition.y
+      << " " << config.goalRadius << "\n";
+  out << "terrain-size = " << config.terrainWidth << " "
+      << config.terrainHeight << "\n";
+  out << "terrain-res = " << config.terrainCols << " " << config.terrainRows
+      << "\n";
+  out << "noise = " << config.noiseFreq << " " << config.noiseAmp << "\n";
+  out << "seed = " << config.noiseSeed << "\n";
+  out << "noise-mode = " << getNoiseModeName(config.noiseMode) << "\n";
+  out << "octaves =";
+  for (float amp : config.octaveAmps) out << " " << amp;
+  out << "\n";
+  out << "lacunarity = " << config.lacunarity << "\n";
+  out << "warp = " << config.warpStrength << "\n";
+  if (!config.heightMapPath.empty()) {
+    out << "heightmap = " << config.heightMapPath << "\n";
+  }
+  out << "flight = " << config.useFlightStage << "\n";
+  out << "prune = " << config.prune << "\n";
+  out << "max-shot-time = " << config.maxShotTime << "\n";
+  out << "backend = " << getBackendName(config.backend) << "\n";
+  return out.str();
+}
+
+// config file lines that reproduce a run
+std::string formatConfig(const SolveConfig& config) {
+  std::ostringstream out;
+  out << "output = " << config.outputFilePath << "\n";
+  out << "format = " << (config.binaryOutput ? "binary" : "text") << "\n";
+  out << formatSweepConfig(config);
+  out << "live-balls = " << config.liveBalls << "\n";
+  out << "auto-tune = " << config.autoTune << "\n";
+  out << "chunk-size = " << config.chunkSize << "\n";
+  out << "threads = " << config.numThreads << "\n";
+  if (!config.cachePath.empty()) {
+    out << "cache = " << config.cachePath << "\n";
+  }
+  out << "checkpoint-every = " << config.checkpointInterval << "\n";
+  return out.str();
+}
+
+bool parseArgs(SolveConfig& config, int argc, char** argv) {
+  // options are gathered first so a config file can be overridden by any
+  // other option regardless of argument order
+  std::vector<std::pair<std::string, std::vector<std::string>>> options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      std::cout << "ERROR: unexpected argument " << arg << std::endl;
+      return false;
+    }
+
+    std::vector<std::string> values;
+    while (i + 1 < argc && (std::string(argv[i + 1]).rfind("--", 0) != 0)) {
+      values.push_back(argv[++i]);
+    }
+    options.push_back(std::make_pair(arg.substr(2), values));
+  }
+
+  for (auto& option : options) {
+    if (option.first == "config") {
+      if (option.second.size() != 1 ||
+          !readConfigFile(config, option.second[0])) {
+        return false;
+      }
+    }
+  }
+  // a resumed run starts from the options of its checkpoint
+  std::string resumedSweep;
+  for (auto& option : options) {
+    if (option.first == "resume") {
+      SweepCheckpoint checkpoint;
+      if (option.second.size() != 1 ||
+          !checkpoint.resume(option.second[0])) {
+        return false;
+      }
+      std::istringstream fin(checkpoint.getConfig());
+      if (!readConfig(config, fin)) return false;
+      config.checkpointPath = option.second[0];
+      config.resume = true;
+      resumedSweep = formatSweepConfig(config);
+    }
+  }
+  for (auto& option : options) {
+    if (option.first == "checkpoint" && config.resume) {
+      std::cout << "ERROR: --resume already continues its own checkpoint"
+                << std::endl;
+      return false;
+    }
+    if (option.first != "config" && option.first != "resume" &&
+        !applyOption(config, option.first, option.second)) {
+      return false;
+    }
+  }
+  // the checkpoint's shots are only valid for the sweep they were solved for
+  if (config.resume && formatSweepConfig(config) != resumedSweep) {
+    std::cout << "ERROR: --resume can't change the sweep, scene or physics "
+                 "options of its checkpoint"
+              << std::endl;
+    return false;
+  }
+
+  if (config.adaptiveLevels > 0 &&
+      AdaptiveSweep::computeResolution(config.sweep.numDivisions,
+                                       config.adaptiveLevels) >
+          AdaptiveSweep::MAX_RESOLUTION) {
+    std::cout << "ERROR: --adaptive " << config.adaptiveLevels << " on "
+              << config.sweep.numDivisions << " divisions needs more than "
+              << AdaptiveSweep::MAX_RESOLUTION + 1 << " points per axis"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// solves the shots the checkpoint doesn't have yet in batches of
+// checkpointInterval shots, appending each batch to it as it finishes. every
+// shot is simulated on its own, so the results are the same as those of a run
+// that was never interrupted
+void solveCheckpointed(const SolveConfig& config,
+                       const std::vector<ShotParams>& shots,
+                       const ShotEvaluator& evaluate,
+                       SweepCheckpoint& checkpoint,
+                       std::vector<float>& distances,
+                       std::vector<uint8_t>& states) {
+  distances.assign(shots.size(), 0);
+  states.assign(shots.size(), 0);
+  std::vector<uint8_t> finished(shots.size());
+  for (const CheckpointShot& shot : checkpoint.getShots()) {
+    if (shot.index >= shots.size()) continue;
+    distances[shot.index] = shot.distance;
+    states[shot.index] = shot.state;
+    finished[shot.index] = true;
+  }
+
+  std::vector<int> pending;
+  for (int i = 0; i < shots.size(); i++) {
+    if (!finished[i]) pending.push_back(i);
+  }
+  if (config.resume) {
+    std::cout << "Resuming with " << shots.size() - pending.size() << " of "
+              << shots.size() << " shots already finished" << std::endl;
+  }
+
+  size_t interval = std::max(1, config.checkpointInterval);
+  bool writing = true;
+  for (size_t begin = 0; begin < pending.size(); begin += interval) {
+    size_t end = std::min(pending.size(), begin + interval);
+    std::vector<ShotParams> batch;
+    for (size_t i = begin; i < end; i++) {
+      batch.push_back(shots[pending[i]]);
+    }
+
+    std::vector<float> batchDistances;
+    std::vector<uint8_t> batchStates;
+    evaluate(batch, batchDistances, batchStates);
+
+    std::vector<CheckpointShot> records(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+      int index = pending[begin + i];
+      distances[index] = batchDistances[i];
+      states[index] = batchStates[i];
+      // zeroed so the padding written to the checkpoint is too
+      CheckpointShot record = {};
+      record.index = static_cast<uint32_t>(index);
+      record.distance = batchDistances[i];
+      record.state = batchStates[i];
+      records[i] = record;
+    }
+    // a failed write only stops the checkpoints, not the sweep
+    if (writing) {
+      writing = checkpoint.append(records);
+    }
+    std::cout << "  " << end << " of " << pending.size() << " shots finished"
+              << std::endl;
+  }
+}
+
+// cache and checkpoint are nullptr when there is none
+std::vector<float> runBackend(const SolveConfig& config, Terrain& terrain,
+                              Goal& goal, const std::vector<ShotParams>& shots,
+                              SolverBackend backend, ResultCache* cache,
+                              SweepCheckpoint* checkpoint,
+                              std::vector<uint8_t>& states) {
+  std::cout << "Simulating " << shots.size() << " shots on "
+            << config.numThreads << " thread(s) with the "
+            << getBackendName(backend) << " backend..." << std::endl;
+
+  auto startTime = std::chrono::steady_clock::now();
+  std::vector<float> distances;
+  long long numSteps = 0;
+  {
+    ShardedSolver solver(terrain, goal, config.startPosition,
+                         config.ballRadius, config.numThreads);
+    solver.setBackend(backend);
+    solver.setAutoTune(config.autoTune);
+    solver.setUseFlightStage(config.useFlightStage);
+    solver.setPrune(config.prune);
+    ShotEvaluator evaluate = [&](const std::vector<ShotParams>& batch,
+                                 std::vector<float>& batchDistances,
+                                 std::vector<uint8_t>& batchStates) {
+      batchDistances = solver.solve(batch, config.chunkSize,
+                                    config.liveBalls, config.maxShotTime);
+      batchStates = solver.getStates();
+      numSteps += solver.getNumSteps();
+    };
+    if (cache != nullptr) {
+      evaluate = cache->wrap(evaluate);
+    }
+    if (checkpoint != nullptr) {
+      solveCheckpointed(config, shots, evaluate, *checkpoint, distances,
+                        states);
+    } else {
+      evaluate(shots, distances, states);
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - startTime)
+                       .count();
+
+  std::cout << "Simulated " << shots.size() << " shots (" << numSteps
+            << " physics steps) in " << seconds << " s: "
+            << shots.size() / seconds << " shots/s" << std::endl;
+  if (cache != nullptr) {
+    std::cout << cache->getNumHits() << " of " << shots.size()
+              << " shots were served from the cache" << std::endl;
+    if (cache->getNumUnflushed() > 0) {
+      std::cout << "ERROR: " << cache->getNumUnflushed()
+                << " solved shots could not be added to the cache"
+                << std::endl;
+    }
+  }
+  if (config.prune) {
+    std::cout << std::count(states.begin(), states.end(),
+                            static_cast<uint8_t>(BallState::PRUNED))
+              << " shots were stopped early" << std::endl;
+  }
+  return distances;
+}
+
+// reports how far the height field backend's distances are from the
+// reactphysics3d ones, and how many shots only one of them put in the goal
+void printValidation(const std::vector<float>& expected,
+                     const std::vector<float>& actual, float goalRadius) {
+  double sumDiff = 0;
+  float maxDiff = 0;
+  int maxDiffIndex = 0;
+  int numGoalMismatches = 0;
+  std::vector<float> diffs;
+  for (int i = 0; i < expected.size(); i++) {
+    float diff = std::abs(expected[i] - actual[i]);
+    diffs.push_back(diff);
+    sumDiff += diff;
+    if (diff > maxDiff) {
+      maxDiff = diff;
+      maxDiffIndex = i;
+    }
+    if ((expected[i] < goalRadius) != (actual[i] < goalRadius)) {
+      numGoalMismatches++;
+    }
+  }
+  if (diffs.empty()) return;
+
+  std::sort(diffs.begin(), diffs.end());
+  std::cout << "Distance difference: mean " << sumDiff / diffs.size()
+            << ", median " << diffs[diffs.size() / 2] << ", 95th percentile "
+            << diffs[diffs.size() * 95 / 100] << ", max " << maxDiff
+            << " (shot " << maxDiffIndex << ")" << std::endl;
+  std::cout << numGoalMismatches << " of " << expected.size()
+            << " shots differ on whether they end in the goal" << std::endl;
+}
+
+// simulates each batch of shots with a solver set up from the config, going
+// through the cache unless it is nullptr
+ShotEvaluator makeEvaluator(const SolveConfig& config, ShardedSolver& solver,
+                            ResultCache* cache) {
+  solver.setBackend(config.backend);
+  solver.setAutoTune(config.autoTune);
+  solver.setUseFlightStage(config.useFlightStage);
+  solver.setPrune(config.prune);
+  ShotEvaluator evaluate = [&config, &solver](
+      const std::vector<ShotParams>& shots, std::vector<float>& distances,
+      std::vector<uint8_t>& states) {
+    distances = solver.solve(shots, config.chunkSize, config.liveBalls,
+                             config.maxShotTime);
+    states = solver.getStates();
+  };
+  return cache != nullptr ? cache->wrap(evaluate) : evaluate;
+}
+
+// simulates only the shots an adaptive sweep asks for, one refinement level at
+// a time, and writes them as a sparse tree results file
+int runAdaptive(const SolveConfig& config, Terrain& terrain, Goal& goal,
+                ResultCache* cache) {
+  if (config.sweep.sampling != SamplingMode::GRID) {
+    std::cout << "ERROR: adaptive sweeps refine a grid, not "
+              << getSamplingModeName(config.sweep.sampling) << " samples"
+              << std::endl;
+    return 1;
+  }
+  if (!config.binaryOutput) {
+    std::cout << "ERROR: adaptive sweeps can only be written as binary files"
+              << std::endl;
+    return 1;
+  }
+
+  AdaptiveSweep sweep(config.sweep, config.adaptiveLevels,
+                      goal.getRadius() - config.ballRadius,
+                      config.refineGradient);
+  std::cout << "Refining a " << config.sweep.numDivisions
+            << " point grid up to " << sweep.getResolution() + 1
+            << " points per axis on " << config.numThreads
+            << " thread(s) with the " << getBackendName(config.backend)
+            << " backend..." << std::endl;
+
+  auto startTime = std::chrono::steady_clock::now();
+  ShardedSolver solver(terrain, goal, config.startPosition, config.ballRadius,
+                       config.numThreads);
+  ShotEvaluator evaluate = makeEvaluator(config, solver, cache);
+  sweep.run([&](const std::vector<ShotParams>& shots,
+                std::vector<float>& distances, std::vector<uint8_t>& states) {
+    evaluate(shots, distances, states);
+    std::cout << "  " << shots.size() << " shots" << std::endl;
+  });
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - startTime)
+                       .count();
+
+  std::cout << "Simulated " << sweep.getSamples().size() << " shots in "
+            << seconds << " s, "
+            << 100.0 * sweep.getSamples().size() / sweep.getNumUniformShots()
+            << "% of the " << sweep.getNumUniformShots()
+            << " a uniform sweep would need" << std::endl;
+
+  if (!writeSparseTreeResultFile(config.outputFilePath, sweep,
+                                 config.ballRadius, goal.getRadius())) {
+    return 1;
+  }
+  std::cout << "Results written to " << config.outputFilePath << std::endl;
+  return 0;
+}
+
+// printed by a worker process once its whole shard is in its stream file
+const char SHARD_DONE[] = "SHARD DONE";
+
+// simulates the sweep (or just the shard of a worker) without keeping its
+// results in memory, writing each shot to the stream file as soon as it
+// finishes
+int runStreamed(const SolveConfig& config, Terrain& terrain, Goal& goal) {
+  bool isShard = config.shardEnd > 0;
+  ResultStream stream;
+  if (!stream.open(config.streamPath, config.sweep, config.ballRadius,
+                   goal.getRadius(), isShard ? config.shardBegin : 0)) {
+    return 1;
+  }
+
+  std::vector<ShotParams> shots = config.sweep.getShots();
+  if (isShard) {
+    shots = std::vector<ShotParams>(shots.begin() + config.shardBegin,
+                                    shots.begin() + config.shardEnd);
+  }
+  std::cout << "Streaming " << shots.size() << " shots to "
+            << config.streamPath << " on " << config.numThreads
+            << " thread(s) with the " << getBackendName(config.backend)
+            << " backend..." << std::endl;
+
+  auto startTime = std::chrono::steady_clock::now();
+  long long numSteps;
+  {
+    ShardedSolver solver(terrain, goal, config.startPosition,
+                         config.ballRadius, config.numThreads);
+    solver.setBackend(config.backend);
+    solver.setAutoTune(config.autoTune);
+    solver.setUseFlightStage(config.useFlightStage);
+    solver.setPrune(config.prune);
+    solver.setStream(&stream, false);
+    solver.start(shots, config.chunkSize, config.liveBalls,
+                 config.maxShotTime);
+    solver.wait();
+    numSteps = solver.getNumSteps();
+  }
+  bool written = stream.close();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - startTime)
+                       .count();
+
+  std::cout << "Simulated " << shots.size() << " shots (" << numSteps
+            << " physics steps) in " << seconds << " s: "
+            << shots.size() / seconds << " shots/s" << std::endl;
+  if (!written) {
+    return 1;
+  }
+  std::cout << stream.getNumWritten() << " shots written to "
+            << config.streamPath << std::endl;
+  if (isShard) {
+    std::cout << SHARD_DONE << " " << config.shardBegin << " "
+              << config.shardEnd << std::endl;
+  }
+  return 0;
+}
+
+// a range of shots solved by a single worker process
+struct Shard {
+  int begin;
+  int end;
+  int attempts;
+};
+
+// times a shard is handed out before the run gives up on it
+const int MAX_SHARD_ATTEMPTS = 3;
+
+std::string quoteArg(const std::string& arg) { return "\"" + arg + "\""; }
+
+// runs a worker process to completion, returning whether it exited cleanly
+// after reporting its shard as done
+bool runWorkerProcess(std::string command) {
+#ifdef _WIN32
+  // cmd strips the outer quotes of a command that starts with one
+  command = "\"" + command + "\"";
+#endif
+  std::FILE* pipe = popen(command.c_str(), "r");
+  if (pipe == nullptr) {
+    return false;
+  }
+
+  bool done = false;
+  char line[512];
+  while (std::fgets(line, sizeof(line), pipe) != nullptr) {
+    if (std::strncmp(line, SHARD_DONE, std::strlen(SHARD_DONE)) == 0) {
+      done = true;
+    }
+  }
+  return pclose(pipe) == 0 && done;
+}
+
+// copies the shots of a shard's stream file into the sweep's results,
+// returning false if any of them are missing
+bool mergeShard(const std::string& path, const Shard& shard,
+                std::vector<float>& distances, std::vector<uint8_t>& states) {
+  ResultHeader header;
+  std::vector<StreamRecord> records;
+  if (!readStreamFile(path, header, records)) {
+    return false;
+  }
+
+  std::vector<uint8_t> found(shard.end - shard.begin);
+  for (const StreamRecord& record : records) {
+    if (record.index < shard.begin || record.index >= shard.end) continue;
+    distances[record.index] = record.distance;
+    states[record.index] = record.state;
+    found[record.index - shard.begin] = true;
+  }
+  return std::find(found.begin(), found.end(), false) == found.end();
+}
+
+// splits the sweep into shards and solves them with worker processes, each
+// streaming its shard to its own file, which are merged into the results.
+// shards whose worker dies (or that come back incomplete) are handed out
+// again
+bool runCoordinator(const SolveConfig& config, const std::string& programPath,
+                    std::vector<float>& distances,
+                    std::vector<uint8_t>& states) {
+  int numShots = config.sweep.getNumShots();
+  int shardSize = config.shardSize > 0
+                      ? config.shardSize
+                      : (numShots + config.numWorkers * 4 - 1) /
+                            (config.numWorkers * 4);
+  shardSize = std::max(1, shardSize);
+  std::deque<Shard> pending;
+  for (int begin = 0; begin < numShots; begin += shardSize) {
+    pending.push_back(Shard{begin, std::min(numShots, begin + shardSize), 0});
+  }
+
+  // the workers split the run's threads between them instead of each starting
+  // as many, which would run workers times too many on one machine
+  SolveConfig workerConfig = config;
+  workerConfig.numThreads = std::max(1, config.numThreads / config.numWorkers);
+
+  std::cout << "Solving " << numShots << " shots in " << pending.size()
+            << " shards with " << config.numWorkers
+            << " worker process(es) of " << workerConfig.numThreads
+            << " thread(s)" << std::endl;
+
+  // workers read the options of the run from a config file, so the command
+  // lines stay short. workers on other hosts need to see the same paths
+  std::string configPath = config.outputFilePath + ".workers.cfg";
+  {
+    std::ofstream fout(configPath);
+    fout << formatConfig(workerConfig);
+    if (!fout) {
+      std::cout << "ERROR: could not write " << configPath << std::endl;
+      return false;
+    }
+  }
+  std::string command = config.workerCommand.empty()
+                            ? quoteArg(programPath)
+                            : config.workerCommand;
+
+  auto startTime = std::chrono::steady_clock::now();
+  distances.assign(numShots, 0);
+  states.assign(numShots, 0);
+  std::mutex mutex;
+  int numFinished = 0;
+  bool failed = false;
+
+  // one thread per worker process, each running shards until none are left.
+  // shards never overlap, so they are merged without locking
+  auto runShards = [&]() {
+    while (true) {
+      Shard shard;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.empty() || failed) return;
+        shard = pending.front();
+        pending.pop_front();
+      }
+
+      std::string shardPath =
+          config.outputFilePath + ".shard" + std::to_string(shard.begin);
+      bool solved = runWorkerProcess(
+                        command + " --config " + quoteArg(configPath) +
+                        " --stream " + quoteArg(shardPath) + " --shard " +
+                        std::to_string(shard.begin) + " " +
+                        std::to_string(shard.end)) &&
+                    mergeShard(shardPath, shard, distances, states);
+      std::error_code error;
+      std::filesystem::remove(shardPath, error);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (solved) {
+        numFinished += shard.end - shard.begin;
+        std::cout << "  " << numFinished << " of " << numShots
+                  << " shots finished" << std::endl;
+      } else if (++shard.attempts < MAX_SHARD_ATTEMPTS) {
+        std::cout << "  worker for shots " << shard.begin << " to "
+                  << shard.end << " failed, handing them out again"
+                  << std::endl;
+        pending.push_back(shard);
+      } else {
+        std::cout << "ERROR: shots " << shard.begin << " to " << shard.end
+                  << " failed " << MAX_SHARD_ATTEMPTS << " times" << std::endl;
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < config.numWorkers; i++) {
+    threads.emplace_back(runShards);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  std::error_code error;
+  std::filesystem::remove(configPath, error);
+  if (failed) {
+    return false;
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - startTime)
+                       .count();
+  std::cout << "Simulated " << numShots << " shots in " << seconds << " s: "
+            << numShots / seconds << " shots/s" << std::endl;
+  return true;
+}
+
+// searches for shots that go in, printing them along with how many shots it
+// took to find them
+int runInverse(const SolveConfig& config, Terrain& terrain, Goal& goal,
+               ResultCache* cache) {
+  std::cout << "Searching for " << config.inverseConfig.targetShots
+            << " shots that go in with "
+            << getInverseMethodName(config.inverseConfig.method) << " on "
+            << config.numThreads << " thread(s) with the "
+            << getBackendName(config.backend) << " backend..." << std::endl;
+
+  auto startTime = std::chrono::steady_clock::now();
+  ShardedSolver solver(terrain, goal, config.startPosition, config.ballRadius,
+                       config.numThreads);
+  InverseSolver inverseSolver(config.sweep, config.inverseConfig);
+  ShotEvaluator evaluate = makeEvaluator(config, solver, cache);
+  // the searches follow the distance down towards the goal, which lower
+  // bounds would only lead astray
+  solver.setPrune(false);
+  InverseResult result = inverseSolver.run(evaluate);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - startTime)
+                       .count();
+
+  std::cout << "Found " << result.holedShots.size() << " shot(s) in "
+            << result.numSimulations << " simulations (" << result.numBatches
+            << " batches) in " << seconds << " s" << std::endl;
+  for (const ShotParams& shot : result.holedShots) {
+    std::cout << "  power " << shot.power << ", yaw " << shot.yawOffset
+              << ", pitch " << shot.pitch << std::endl;
+  }
+  if (result.holedShots.empty()) {
+    std::cout << "Closest shot ended " << result.bestDistance
+              << " from the goal: power " << result.bestShot.power << ", yaw "
+              << result.bestShot.yawOffset << ", pitch "
+              << result.bestShot.pitch << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// pruned shots only have a lower bound on their distance, and never went in
+bool isHoled(float distance, uint8_t state, float goalRadius,
+             float ballRadius) {
+  return state != static_cast<uint8_t>(BallState::PRUNED) &&
+         distance < goalRadius - ballRadius;
+}
+
+// ranks the shots of an existing results file by their margin of error
+int runTolerance(const SolveConfig& config) {
+  auto startTime = std::chrono::steady_clock::now();
+  SweepConfig sweep;
+  float ballRadius, goalRadius;
+  std::vector<float> distances;
+  std::vector<uint8_t> states;
+  if (!readResultGrid(config.tolerancePath, sweep, ballRadius, goalRadius,
+                      distances, states)) {
+    return 1;
+  }
+
+  // same test for going in as the visualizer
+  std::vector<uint8_t> inside(distances.size());
+  for (size_t i = 0; i < distances.size(); i++) {
+    inside[i] = isHoled(distances[i], states.empty() ? 0 : states[i],
+                        goalRadius, ballRadius);
+  }
+  std::vector<ToleranceShot> shots =
+      rankTolerances(inside, distances, sweep.numDivisions,
+                     config.toleranceTop, config.numThreads);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - startTime)
+                       .count();
+
+  std::string outputPath = config.tolerancePath;
+  if (outputPath.size() > 5 &&
+      outputPath.compare(outputPath.size() - 5, 5, ".golf") == 0) {
+    outputPath.resize(outputPath.size() - 5);
+  }
+  outputPath += ".tolerance.txt";
+  std::ofstream fout(outputPath);
+  if (!fout) {
+    std::cout << "ERROR: could not open " << outputPath << std::endl;
+    return 1;
+  }
+  writeToleranceFile(fout, sweep, shots);
+
+  std::cout << "Ranked " << shots.size() << " shots of a "
+            << sweep.numDivisions << " per axis grid in " << seconds
+            << " s, written to " << outputPath << std::endl;
+  if (!shots.empty()) {
+    ShotParams best = sweep.getShotParams(shots[0].index);
+    std::cout << "Most forgiving shot: power " << best.power << ", yaw "
+              << best.yawOffset << ", pitch " << best.pitch << " ("
+              << shots[0].radius << " steps to the nearest miss)"
+              << std::endl;
+  }
+  return 0;
+}
+
+// writes the results of the whole sweep in the configured format
+int writeResults(const SolveConfig& config, float goalRadius,
+                 const std::vector<float>& distances,
+                 const std::vector<uint8_t>& states) {
+  auto writeStart = std::chrono::steady_clock::now();
+  if (config.binaryOutput) {
+    if (!writeBinaryResultFile(config.outputFilePath, config.sweep,
+                               config.ballRadius, goalRadius, distances,
+                               states)) {
+      return 1;
+    }
+  } else {
+    std::ofstream fout(config.outputFilePath);
+    if (!fout) {
+      std::cout << "ERROR: could not open " << config.outputFilePath
+                << std::endl;
+      return 1;
+    }
+    writeResultFile(fout, config.sweep, config.ballRadius, goalRadius,
+                    distances);
+    fout.close();
+  }
+  double writeSeconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - writeStart)
+                            .count();
+
+  std::cout << "Results written to " << config.outputFilePath << " in "
+            << writeSeconds << " s" << std::endl;
+
+  return 0;
+}
+
+bool isScenarioRun(const SolveConfig& config) {
+  return !config.scenarios.startPositions.empty() ||
+         !config.scenarios.goalPositions.empty() ||
+         !config.scenarios.goalRadii.empty();
+}
+
+// runs the sweep for every scenario of the batch on the same terrain, whose
+// height map (and the colliders made from it) is only built once. the goal is
+// only rebuilt when it changes, which also moves its footprint in the
+// terrain's physics height map in place, and the solver's workers are kept
+// across every start position of the same goal. each scenario's results file
+// and an index of them are written to the output directory
+int runScenarios(const SolveConfig& config, Terrain& terrain) {
+  ScenarioBatch batch = config.scenarios;
+  if (batch.startPositions.empty()) {
+    batch.startPositions.push_back(config.startPosition);
+  }
+  if (batch.goalPositions.empty()) {
+    batch.goalPositions.push_back(config.goalPosition);
+  }
+  if (batch.goalRadii.empty()) {
+    batch.goalRadii.push_back(config.goalRadius);
+  }
+  std::vector<Scenario> scenarios = batch.getScenarios();
+  std::vector<ShotParams> shots = config.sweep.getShots();
+
+  std::error_code error;
+  std::filesystem::create_directories(config.outputFilePath, error);
+  std::string indexPath = config.outputFilePath + "/index.txt";
+  std::ofstream index(indexPath);
+  if (error || !index) {
+    std::cout << "ERROR: could not write " << indexPath << std::endl;
+    return 1;
+  }
+  index << "# scenario start_u start_v goal_u goal_v goal_radius holed_shots "
+           "file\n";
+
+  std::cout << "Running " << scenarios.size() << " scenarios of "
+            << shots.size() << " shots on " << config.numThreads
+            << " thread(s) with the " << getBackendName(config.backend)
+            << " backend..." << std::endl;
+
+  auto startTime = std::chrono::steady_clock::now();
+  std::unique_ptr<Goal> goal;
+  // kept for as long as the goal is, so its physics worlds are only built
+  // once for all of the start positions of each goal
+  std::unique_ptr<ShardedSolver> solver;
+  int numGoalBuilds = 0;
+  ResultCache cache;
+  for (int i = 0; i < scenarios.size(); i++) {
+    const Scenario& scenario = scenarios[i];
+    if (goal == nullptr ||
+        goal->getRelativePosition() != scenario.goalPosition ||
+        goal->getRadius() != scenario.goalRadius) {
+      solver.reset();
+      goal = std::make_unique<Goal>(scenario.goalPosition.x,
+                                    scenario.goalPosition.y,
+                                    scenario.goalRadius);
+      goal->generateModel(terrain);
+      solver = std::make_unique<ShardedSolver>(terrain, *goal,
+                                               scenario.startPosition,
+                                               config.ballRadius,
+                                               config.numThreads);
+      numGoalBuilds++;
+    }
+    solver->setStartPosition(scenario.startPosition);
+
+    ResultCache* cachePointer = nullptr;
+    if (!config.cachePath.empty()) {
+      uint64_t sceneKey = computeSceneKey(
+          terrain, *goal, scenario.startPosition, config.ballRadius,
+          config.backend, config.maxShotTime, config.prune);
+      if (!cache.open(config.cachePath, sceneKey)) {
+        return 1;
+      }
+      cachePointer = &cache;
+    }
+
+    std::vector<float> distances;
+    std::vector<uint8_t> states;
+    ShotEvaluator evaluate = makeEvaluator(config, *solver, cachePointer);
+    evaluate(shots, distances, states);
+
+    SolveConfig scenarioConfig = config;
+    std::string fileName = "scenario_" + std::to_string(i) + ".golf";
+    scenarioConfig.outputFilePath = config.outputFilePath + "/" + fileName;
+    if (writeResults(scenarioConfig, scenario.goalRadius, distances, states) !=
+        0) {
+      return 1;
+    }
+
+    // same test for going in as the visualizer
+    int numHoled = 0;
+    for (size_t shot = 0; shot < distances.size(); shot++) {
+      numHoled += isHoled(distances[shot], states.empty() ? 0 : states[shot],
+                          scenario.goalRadius, config.ballRadius);
+    }
+    index << i << " " << scenario.startPosition.x << " "
+          << scenario.startPosition.y << " " << scenario.goalPosition.x << " "
+          << scenario.goalPosition.y << " " << scenario.goalRadius << " "
+          << numHoled << " " << fileName << "\n";
+    index.flush();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - startTime)
+                       .count();
+
+  std::cout << "Ran " << scenarios.size() << " scenarios (" << numGoalBuilds
+            << " goal builds) in " << seconds << " s, indexed in "
+            << indexPath << std::endl;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  SolveConfig config;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--help") {
+      printUsage();
+      return 0;
+    }
+  }
+  if (!parseArgs(config, argc, argv)) {
+    printUsage();
+    return 1;
+  }
+  if (!config.tolerancePath.empty()) {
+    return runTolerance(config);
+  }
+  if (!config.binaryOutput && config.sweep.sampling != SamplingMode::GRID) {
+    std::cout << "ERROR: only grid sweeps can be written as text" << std::endl;
+    return 1;
+  }
+  if (config.shardEnd > 0 &&
+      (config.streamPath.empty() || config.shardBegin < 0 ||
+       config.shardBegin >= config.shardEnd ||
+       config.shardEnd > config.sweep.getNumShots())) {
+    std::cout << "ERROR: --shard needs --stream and a range of the sweep's "
+              << config.sweep.getNumShots() << " shots" << std::endl;
+    return 1;
+  }
+
+  // the coordinator only hands out shards, so it never builds the terrain
+  if (config.numWorkers > 0) {
+    if (config.inverse || config.adaptiveLevels > 0 || config.validate ||
+        !config.cachePath.empty() || !config.checkpointPath.empty() ||
+        !config.streamPath.empty() || isScenarioRun(config)) {
+      std::cout << "ERROR: only single grid and sampled sweeps without a "
+                   "cache, checkpoint or stream can be run on workers"
+                << std::endl;
+      return 1;
+    }
+    std::vector<float> distances;
+    std::vector<uint8_t> states;
+    if (!runCoordinator(config, argv[0], distances, states)) {
+      return 1;
+    }
+    return writeResults(config, config.goalRadius, distances, states);
+  }
+
+  Goal goal(config.goalPosition.x, config.goalPosition.y, config.goalRadius);
+  Terrain terrain(glm::vec3(0.0, 0.0, 0.0), config.terrainCols,
+                  config.terrainRows, config.terrainWidth,
+                  config.terrainHeight, config.noiseFreq, config.noiseAmp);
+  terrain.setNoiseSeed(config.noiseSeed);
+  TerrainGenerator& generator = terrain.getGenerator();
+  generator.mode = config.noiseMode;
+  generator.numOctaves = config.octaveAmps.size();
+  std::copy(config.octaveAmps.begin(), config.octaveAmps.end(),
+            generator.octaveAmps);
+  generator.lacunarity = config.lacunarity;
+  generator.warpStrength = config.warpStrength;
+  terrain.setHeightMapPath(config.heightMapPath);
+  if (!terrain.generateModel(goal)) {
+    return 1;
+  }
+  goal.generateModel(terrain);
+
+  if (!config.exportHeightMapPath.empty()) {
+    if (!terrain.exportHeightMap(config.exportHeightMapPath,
+                                 config.exportFormat)) {
+      return 1;
+    }
+    std::cout << "Height map written to " << config.exportHeightMapPath
+              << std::endl;
+    return 0;
+  }
+
+  if (isScenarioRun(config)) {
+    if (config.inverse || config.adaptiveLevels > 0 || config.validate ||
+        !config.checkpointPath.empty() || !config.streamPath.empty()) {
+      std::cout << "ERROR: only grid and sampled sweeps without a checkpoint "
+                   "or stream can be run for several scenarios"
+                << std::endl;
+      return 1;
+    }
+    return runScenarios(config, terrain);
+  }
+
+  if (!config.streamPath.empty()) {
+    if (config.inverse || config.adaptiveLevels > 0 || config.validate ||
+        !config.cachePath.empty() || !config.checkpointPath.empty()) {
+      std::cout << "ERROR: only grid and sampled sweeps without a cache or "
+                   "checkpoint can be streamed"
+                << std::endl;
+      return 1;
+    }
+    return runStreamed(config, terrain, goal);
+  }
+
+  // the validation compares fresh results of both backends, so it doesn't use
+  // the cache
+  ResultCache cache;
+  ResultCache* cachePointer = nullptr;
+  if (!config.cachePath.empty() && !config.validate) {
+    uint64_t sceneKey = computeSceneKey(
+        terrain, goal, config.startPosition, config.ballRadius,
+        config.backend, config.maxShotTime, config.prune && !config.inverse);
+    if (!cache.open(config.cachePath, sceneKey)) {
+      return 1;
+    }
+    std::cout << cache.getNumRecords() << " shots of this scene found in "
+              << config.cachePath << std::endl;
+    cachePointer = &cache;
+  }
+
+  SweepCheckpoint checkpoint;
+  SweepCheckpoint* checkpointPointer = nullptr;
+  if (!config.checkpointPath.empty()) {
+    if (config.inverse || config.adaptiveLevels > 0 || config.validate) {
+      std::cout << "ERROR: only grid and sampled sweeps can be checkpointed"
+                << std::endl;
+      return 1;
+    }
+    if (config.resume ? !checkpoint.resume(config.checkpointPath)
+                      : !checkpoint.create(config.checkpointPath,
+                                           formatConfig(config))) {
+      return 1;
+    }
+    checkpointPointer = &checkpoint;
+  }
+
+  if (config.inverse) {
+    return runInverse(config, terrain, goal, cachePointer);
+  }
+  if (config.adaptiveLevels > 0) {
+    return runAdaptive(config, terrain, goal, cachePointer);
+  }
+
+  std::vector<ShotParams> shots = config.sweep.getShots();
+
+  std::vector<uint8_t> states;
+  std::vector<float> distances =
+      runBackend(config, terrain, goal, shots,
+                 config.validate ? SolverBackend::RP3D : config.backend,
+                 cachePointer, checkpointPointer, states);
+  if (config.validate) {
+    std::vector<uint8_t> fastStates;
+    std::vector<float> fastDistances =
+        runBackend(config, terrain, goal, shots, SolverBackend::HEIGHT_FIELD,
+                   nullptr, nullptr, fastStates);
+    printValidation(distances, fastDistances, goal.getRadius());
+  }
+
+  return writeResults(config, goal.getRadius(), distances, states);
+}
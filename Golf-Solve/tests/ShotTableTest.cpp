@@ -0,0 +1,68 @@
+// checks for ShotTable, run by the Golf-Solve-Tests target. every failed check
+// is printed and the exit code is the number of failures
+
+#include <reactphysics3d/reactphysics3d.h>
+
+#include <iostream>
+
+#include "ball/BallBodyPool.h"
+#include "ball/BallShapeRegistry.h"
+#include "ball/ShotTable.h"
+
+namespace {
+
+int numFailures = 0;
+
+void check(bool condition, const char* description) {
+  if (!condition) {
+    std::cout << "FAILED: " << description << std::endl;
+    numFailures++;
+  }
+}
+
+// a shot that reaches the time limit while it is still in flight is retired
+// like any other, and must not keep moving the next shot given its row
+void testTimeoutInFlight(BallBodyPool& pool) {
+  ShotTable table;
+  int row = table.add(0, glm::vec3(0.0f, 10.0f, 0.0f));
+  table.addFlight(row, glm::vec3(1.0f, 5.0f, 0.0f));
+  check(table.isInFlight(row), "launched shot is in flight");
+
+  table.removePhysics(row, pool);
+  table.release(row);
+  check(table.getNumInFlight() == 0, "timed out shot leaves flight");
+  check(pool.getNumInUse() == 0, "timed out shot never took a body");
+
+  int reused = table.add(1, glm::vec3(2.0f, 0.0f, 2.0f));
+  check(reused == row, "released row is reused");
+  check(!table.isInFlight(reused), "reused row starts out of flight");
+  check(table.getPosition(reused) == glm::vec3(2.0f, 0.0f, 2.0f),
+        "reused row keeps its own position");
+
+  // the new shot gets a body of its own and gives it back when retired
+  table.addPhysics(reused, pool);
+  check(table.hasPhysics(reused) && table.getNumWithPhysics() == 1,
+        "reused row gets physics");
+  table.removePhysics(reused, pool);
+  check(table.getNumWithPhysics() == 0 && pool.getNumInUse() == 0,
+        "retired shot gives its body back");
+}
+
+}  // namespace
+
+int main() {
+  reactphysics3d::PhysicsCommon physicsCommon;
+  reactphysics3d::PhysicsWorld* physicsWorld =
+      physicsCommon.createPhysicsWorld();
+  BallShapeRegistry ballShapeRegistry;
+  {
+    BallBodyPool pool(physicsWorld, physicsCommon, ballShapeRegistry, 0.25f);
+    testTimeoutInFlight(pool);
+  }
+  physicsCommon.destroyPhysicsWorld(physicsWorld);
+
+  if (numFailures == 0) {
+    std::cout << "All ShotTable checks passed" << std::endl;
+  }
+  return numFailures;
+}
@@ -1,3 +1,6 @@
+import os
+import struct
+
 import numpy as np
 
 parameters = [
@@ -5,10 +8,54 @@ parameters = [
     'min_pitch', 'max_pitch', 'ball_radius', 'goal_radius'
 ]
 
+# binary (version 2) results file header, see solver/ResultFile.h
+BINARY_MAGIC = b'GOLF'
+BINARY_HEADER = struct.Struct('<4sIIII4B8fQ')
+BINARY_HAS_STATES = 1
+BINARY_SPARSE_TREE = 2
+BINARY_SAMPLES = 4
+# streamed results file, see solver/ResultStream.h: the same header followed
+# by a record per finished shot
+STREAM_MAGIC = b'GOLS'
+STREAM_RECORD = np.dtype([('index', '<u4'), ('distance', '<f4'),
+                          ('position', '<f4', (3,)), ('state', 'u1'),
+                          ('padding', 'u1', (3,))])
+# dimension codes used by the header's dimension order
+DIM_POWER, DIM_YAW, DIM_PITCH = 0, 1, 2
+
+# ball states stored per shot in binary files
+STATE_NAMES = ['Active', 'Out of Bounds', 'Stationary', 'Goal', 'Pruned']
+STATE_PRUNED = 4
+
 
 class File():
 
-    def __init__(self, file_contents):
+    def __init__(self, filename):
+        # states are only stored in binary files
+        self.states = None
+        self.sample_states = None
+        # lattice coordinates (power, yaw, pitch) of each shot and the leaf
+        # cells (power, yaw, pitch, size), only set for adaptive sweeps
+        self.sample_coords = None
+        self.leaves = None
+        # (power, yaw, pitch) of each shot, only set for sweeps that aren't a
+        # grid, which have no values either
+        self.sample_params = None
+        # where each ball ended up, only set for streamed files
+        self.positions = None
+
+        with open(filename, 'rb') as file:
+            magic = file.read(len(BINARY_MAGIC))
+
+        if magic == BINARY_MAGIC:
+            self._load_binary(filename)
+        elif magic == STREAM_MAGIC:
+            self._load_stream(filename)
+        else:
+            with open(filename, 'r') as file:
+                self._load_text(file.readlines())
+
+    def _load_text(self, file_contents):
         stripped_lines = [line.strip() for line in file_contents]
         for ix, parameter in enumerate(parameters):
             setattr(self, parameter, float(stripped_lines[ix]))
@@ -24,6 +71,169 @@ class File():
         # order: power, yaw, pitch
         self.values = np.array(values).reshape((self.dim, self.dim, self.dim))
 
+    def _load_binary(self, filename):
+        with open(filename, 'rb') as file:
+            header = BINARY_HEADER.unpack(file.read(BINARY_HEADER.size))
+
+        (_, version, header_size, dim, flags,
+         order0, order1, order2, _,
+         self.min_power, self.max_power, self.min_yaw, self.max_yaw,
+         self.min_pitch, self.max_pitch, self.ball_radius, self.goal_radius,
+         num_shots) = header
+        if version != 2:
+            raise ValueError('unsupported results file version %d' % version)
+
+        self.dim = dim
+        if flags & BINARY_SPARSE_TREE:
+            self._load_sparse_tree(filename, header_size, num_shots)
+            return
+        if flags & BINARY_SAMPLES:
+            self._load_samples(filename, header_size, num_shots, flags)
+            return
+
+        shape = (dim, dim, dim)
+        # the distances are mapped rather than read, so even huge sweeps
+        # load instantly and are only paged in as they are plotted
+        values = np.memmap(filename, dtype='<f4', mode='r',
+                           offset=header_size, shape=shape)
+        if flags & BINARY_HAS_STATES:
+            states = np.memmap(filename, dtype=np.uint8, mode='r',
+                               offset=header_size + num_shots * 4,
+                               shape=shape)
+
+        # order: power, yaw, pitch
+        axes = [[order0, order1, order2].index(d)
+                for d in (DIM_POWER, DIM_YAW, DIM_PITCH)]
+        self.values = np.transpose(values, axes)
+        if flags & BINARY_HAS_STATES:
+            self.states = np.transpose(states, axes)
+
+    # streamed sweep, which may still be running: shots that haven't finished
+    # yet are NaN (and Active)
+    def _load_stream(self, filename):
+        with open(filename, 'rb') as file:
+            header = BINARY_HEADER.unpack(file.read(BINARY_HEADER.size))
+
+        (_, version, header_size, dim, flags, _, _, _, _,
+         self.min_power, self.max_power, self.min_yaw, self.max_yaw,
+         self.min_pitch, self.max_pitch, self.ball_radius, self.goal_radius,
+         num_shots) = header
+        if version != 1:
+            raise ValueError('unsupported stream file version %d' % version)
+        if flags & BINARY_SAMPLES:
+            raise ValueError('only streamed grid sweeps can be loaded')
+
+        # a record that is still being written is left out
+        with open(filename, 'rb') as file:
+            file.seek(0, 2)
+            num_records = (file.tell() - header_size) // STREAM_RECORD.itemsize
+        records = np.fromfile(filename, dtype=STREAM_RECORD,
+                              count=num_records, offset=header_size)
+
+        self.dim = dim
+        values = np.full(num_shots, np.nan, dtype=np.float32)
+        states = np.zeros(num_shots, dtype=np.uint8)
+        positions = np.full((num_shots, 3), np.nan, dtype=np.float32)
+        values[records['index']] = records['distance']
+        states[records['index']] = records['state']
+        positions[records['index']] = records['position']
+
+        # order: power, yaw, pitch
+        shape = (dim, dim, dim)
+        self.values = values.reshape(shape)
+        self.states = states.reshape(shape)
+        self.positions = positions.reshape(shape + (3,))
+        self.num_finished = num_records
+
+    # sobol, halton or latin hypercube sweep
+    def _load_samples(self, filename, header_size, num_shots, flags):
+        self.values = None
+        self.sample_values = np.memmap(filename, dtype='<f4', mode='r',
+                                       offset=header_size, shape=(num_shots,))
+        params_offset = header_size + num_shots * 4
+        if flags & BINARY_HAS_STATES:
+            self.sample_states = np.memmap(filename, dtype=np.uint8, mode='r',
+                                           offset=params_offset,
+                                           shape=(num_shots,))
+            params_offset += num_shots
+        params_offset = (params_offset + 7) // 8 * 8
+        self.sample_params = np.memmap(filename, dtype='<f4', mode='r',
+                                       offset=params_offset,
+                                       shape=(num_shots, 3))
+
+    # adaptive sweep, see writeSparseTreeResultFile in solver/ResultFile.h
+    def _load_sparse_tree(self, filename, header_size, num_shots):
+        def align(offset):
+            return (offset + 7) // 8 * 8
+
+        self.sample_values = np.memmap(filename, dtype='<f4', mode='r',
+                                       offset=header_size, shape=(num_shots,))
+        states_offset = header_size + num_shots * 4
+        self.sample_states = np.memmap(filename, dtype=np.uint8, mode='r',
+                                       offset=states_offset,
+                                       shape=(num_shots,))
+        coords_offset = align(states_offset + num_shots)
+        self.sample_coords = np.memmap(filename, dtype='<u2', mode='r',
+                                       offset=coords_offset,
+                                       shape=(num_shots, 3))
+        leaves_offset = align(coords_offset + num_shots * 6)
+        num_leaves = int(np.memmap(filename, dtype='<u8', mode='r',
+                                   offset=leaves_offset, shape=(1,))[0])
+        self.leaves = np.memmap(filename, dtype='<u2', mode='r',
+                                offset=leaves_offset + 8,
+                                shape=(num_leaves, 4))
+        self.values = self._fill_lattice()
+
+    # expands an adaptive sweep to the full lattice: every leaf cell is filled
+    # with the mean of its corners, then the simulated shots are written over
+    # it, so cross sections look like those of a uniform sweep
+    def _fill_lattice(self):
+        values = np.zeros((self.dim, self.dim, self.dim), dtype=np.float32)
+        corners = np.array([[i, j, k] for i in (0, 1) for j in (0, 1)
+                            for k in (0, 1)])
+        exact = np.zeros_like(values)
+        coords = self.sample_coords.astype(np.int64)
+        exact[coords[:, 0], coords[:, 1], coords[:, 2]] = self.sample_values
+
+        leaves = self.leaves.astype(np.int64)
+        for size in np.unique(leaves[:, 3]):
+            group = leaves[leaves[:, 3] == size]
+            if size == 1:
+                continue
+            corner_coords = group[:, None, :3] + corners[None] * size
+            means = exact[corner_coords[..., 0], corner_coords[..., 1],
+                          corner_coords[..., 2]].mean(axis=1)
+            for (i, j, k, _), mean in zip(group, means):
+                values[i:i + size + 1, j:j + size + 1, k:k + size + 1] = mean
+
+        values[coords[:, 0], coords[:, 1], coords[:, 2]] = self.sample_values
+        return values
+
+    # power, yaw, pitch and distance of every simulated shot
+    def get_samples(self):
+        if self.sample_params is not None:
+            return (self.sample_params[:, 0], self.sample_params[:, 1],
+                    self.sample_params[:, 2], self.sample_values)
+        if self.sample_coords is not None:
+            coords = self.sample_coords
+            values = self.sample_values
+        else:
+            coords = np.indices(self.values.shape).reshape(3, -1).T
+            values = np.asarray(self.values).reshape(-1)
+        power = coords[:, 0] * self.get_power_inc() + self.min_power
+        yaw = coords[:, 1] * self.get_yaw_inc() + self.min_yaw
+        pitch = coords[:, 2] * self.get_pitch_inc() + self.min_pitch
+        return power, yaw, pitch, values
+
+    # ball state of every shot returned by get_samples, or None if the file
+    # has no states
+    def get_sample_states(self):
+        if self.sample_params is not None or self.sample_coords is not None:
+            return self.sample_states
+        if self.states is None:
+            return None
+        return np.asarray(self.states).reshape(-1)
+
     def get_power_inc(self):
         return (self.max_power - self.min_power) / (self.dim - 1)
 
@@ -34,7 +244,33 @@ class File():
         return (self.max_pitch - self.min_pitch) / (self.dim - 1)
 
     def get_max_value(self):
-        return np.amax(self.values)
+        if self.values is None:
+            return np.amax(self.sample_values)
+        return np.nanmax(self.values)
 
     def get_min_value(self):
-        return np.amin(self.values)
+        if self.values is None:
+            return np.amin(self.sample_values)
+        return np.nanmin(self.values)
+
+
+# directory of results files written by golf-solve for a batch of scenarios,
+# indexed by its index.txt
+class Bundle():
+
+    def __init__(self, dirname):
+        self.dirname = dirname
+        # (start_u, start_v, goal_u, goal_v, goal_radius, holed_shots, file)
+        # of each scenario
+        self.scenarios = []
+        with open(os.path.join(dirname, 'index.txt'), 'r') as file:
+            for line in file:
+                line = line.split('#')[0].split()
+                if not line:
+                    continue
+                self.scenarios.append(
+                    tuple(float(token) for token in line[1:6]) +
+                    (int(line[6]), line[7]))
+
+    def get_file(self, scenario):
+        return File(os.path.join(self.dirname, self.scenarios[scenario][-1]))
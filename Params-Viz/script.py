@@ -1,6 +1,6 @@
 from tkinter import Tk
 from tkinter.filedialog import askopenfilename
-from file import File
+from file import File, STATE_PRUNED
 import matplotlib.pyplot as plt
 from matplotlib.widgets import Slider
 import numpy as np
@@ -9,15 +9,9 @@ import sys
 pitch_slider = None
 
 
-def get_file_contents():
+def get_filename():
     Tk().withdraw()
-    filename = askopenfilename()
-
-    contents = None
-    with open(filename, 'r') as file:
-        contents = file.readlines()
-
-    return contents
+    return askopenfilename()
 
 
 # plots on a 3D plot only the balls that landed in the hole
@@ -36,18 +30,13 @@ def plot_successes_3d(file):
     ax.set_ylim(file.min_pitch, file.max_pitch)
     ax.set_zlim(file.min_power, file.max_power)
 
-    it = np.nditer(file.values, flags=['multi_index'])
-    data = [[], [], [], []]
-    for dist in it:
-        power = it.multi_index[0] * file.get_power_inc() + file.min_power
-        yaw = it.multi_index[1] * file.get_yaw_inc() + file.min_yaw
-        pitch = it.multi_index[2] * file.get_pitch_inc() + file.min_pitch
-
-        if dist < file.goal_radius - file.ball_radius:
-            data[0].append(yaw)
-            data[1].append(pitch)
-            data[2].append(power)
-            data[3].append(dist)
+    power, yaw, pitch, dist = file.get_samples()
+    success = dist < file.goal_radius - file.ball_radius
+    # pruned shots only have a lower bound on their distance
+    states = file.get_sample_states()
+    if states is not None:
+        success &= states != STATE_PRUNED
+    data = [yaw[success], pitch[success], power[success], dist[success]]
 
     cmap = plt.cm.get_cmap('winter')
     scatter = ax.scatter(data[0], data[1], data[2], c=data[3], cmap=cmap)
@@ -119,10 +108,11 @@ if __name__ == '__main__':
 
     if high_dpi:
         plt.rcParams['figure.dpi'] = 200
-    file_contents = get_file_contents()
-    file = File(file_contents)
+    file = File(get_filename())
 
     plot_successes_3d(file)
-    plot_cross_section_color(file)
+    # only grids (and adaptive sweeps filled in to one) have cross sections
+    if file.values is not None:
+        plot_cross_section_color(file)
 
     plt.show()
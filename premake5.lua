@@ -33,3 +33,4 @@ group ""
 
 include "OpenGL-Core"
 include "Golf-Sim"
+include "Golf-Solve"